@@ -0,0 +1,150 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <streambuf>
+#include <string>
+
+/*
+	This component contains the helpers shared by the benchmarks: timing,
+	generated data files, a scratch directory laid out like the application
+	expects (the data files in ../textfiles of the working directory) and a
+	way to silence the loaders' console logs while they are timed.
+	Every benchmark takes the size of its data as its first argument, so the
+	test suite runs them on small data and measurements use large data
+*/
+
+//Run a function a few times and return its fastest run in seconds
+template<typename Function>
+double best_time(Function &&function, int runs = 5) {
+    double best = 0;
+    for (int run = 0; run < runs; run++) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (run == 0 || elapsed.count() < best) {
+            best = elapsed.count();
+        }
+    }
+    return best;
+}
+
+//Size of the data from the first argument, or a default
+inline std::size_t bench_size(int argc, char **argv, std::size_t default_size) {
+    return argc > 1 ? (std::size_t) std::strtoull(argv[1], nullptr, 10) : default_size;
+}
+
+//Stream buffer dropping what is written to it
+class NullBuffer : public std::streambuf {
+    char buffer[4096];
+
+public:
+    NullBuffer() { setp(buffer, buffer + sizeof(buffer)); }
+
+protected:
+    int overflow(int c) override {
+        setp(buffer, buffer + sizeof(buffer));
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(char const *, std::streamsize count) override { return count; }
+};
+
+//Redirect std::cout to nowhere while it lives (the loaders log every line)
+class QuietConsole {
+    NullBuffer sink;
+    std::streambuf *previous;
+
+public:
+    QuietConsole() : previous(std::cout.rdbuf(&sink)) {}
+    ~QuietConsole() { std::cout.rdbuf(previous); }
+
+    QuietConsole(QuietConsole const &) = delete;
+    QuietConsole &operator=(QuietConsole const &) = delete;
+};
+
+//Scratch directory with a textfiles and a run directory, the run directory
+//is the working directory while it lives so the data files are in ../textfiles
+class BenchDirectory {
+    std::filesystem::path root;
+    std::filesystem::path previous;
+
+public:
+    explicit BenchDirectory(std::string const &name)
+            : root(std::filesystem::temp_directory_path() / name), previous(std::filesystem::current_path()) {
+        std::filesystem::remove_all(root);
+        std::filesystem::create_directories(root / "textfiles");
+        std::filesystem::create_directories(root / "run");
+        std::filesystem::current_path(root / "run");
+    }
+
+    ~BenchDirectory() {
+        std::filesystem::current_path(previous);
+        std::error_code ignored;
+        std::filesystem::remove_all(root, ignored);
+    }
+
+    BenchDirectory(BenchDirectory const &) = delete;
+    BenchDirectory &operator=(BenchDirectory const &) = delete;
+
+    //Path of a data file
+    inline std::string textfile(std::string const &name) const { return (root / "textfiles" / name).string(); }
+};
+
+//Number of distinct item ids: 1000 numbers for each year from 1888 to 2021
+const std::size_t max_bench_items = 134000;
+
+//Text id of the n-th generated item
+inline std::string bench_item_id(std::size_t n) {
+    char id[10];
+    std::snprintf(id, sizeof(id), "I%03u-%04u", (unsigned) (n % 1000), (unsigned) (1888 + n / 1000));
+    return id;
+}
+
+//Text id of the n-th generated customer (at most 1000 of them)
+inline std::string bench_customer_id(std::size_t n) {
+    char id[5];
+    std::snprintf(id, sizeof(id), "C%03u", (unsigned) (n % 1000));
+    return id;
+}
+
+//Line of items.txt of the n-th generated item: games, records and DVDs in turn
+inline std::string bench_item_line(std::size_t n) {
+    static const char *titles[] = {"Medal of Honour", "White Castle", "Alpha Dog", "Rat Race", "Halloween"};
+    std::string line = bench_item_id(n) + "," + titles[n % 5] + " " + std::to_string(n / 5);
+    switch (n % 3) {
+        case 0:
+            return line + ",Game,2-day,3,3.990000";
+        case 1:
+            return line + ",Record,1-week,2,1.000000,Comedy";
+        default:
+            return line + ",DVD,1-week,5,2.000000,Horror";
+    }
+}
+
+//Write items.txt with count generated items
+inline void write_bench_items(std::string const &path, std::size_t count) {
+    std::ofstream file(path, std::ios::binary);
+    for (std::size_t n = 0; n < count; n++) {
+        file << bench_item_line(n) << (n + 1 < count ? "\n" : "");
+    }
+}
+
+//Write customers.txt with count generated customers renting rentals of the item_count items each
+inline void write_bench_customers(std::string const &path, std::size_t count, std::size_t item_count,
+                                  std::size_t rentals) {
+    std::ofstream file(path, std::ios::binary);
+    for (std::size_t n = 0; n < count; n++) {
+        file << bench_customer_id(n) << ",Customer " << n << "," << n << " Irwin Street,0421473243,"
+             << rentals << ",VIP";
+        for (std::size_t r = 0; r < rentals; r++) {
+            file << "\n" << bench_item_id((n * rentals + r) * 7919 % item_count);
+        }
+        file << (n + 1 < count ? "\n" : "");
+    }
+}
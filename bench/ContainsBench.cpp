@@ -0,0 +1,74 @@
+#include "Bench.h"
+#include "../headers/StringHelper.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+	Throughput benchmark of check_field_contains in GB/s of searched text,
+	against the function it replaced: both strings copied, lowercased in a
+	copy that was thrown away, then std::string::find (so it did not even
+	ignore the case). Measured on short fields, like the filters search, and
+	on one long text, where the kernel's vector loop dominates
+*/
+
+static void old_to_lowercase(std::string string) {
+    for (char &pointer : string) {
+        pointer = (char) tolower(pointer);
+    }
+}
+
+//check_field_contains before the kernel
+static bool old_check_field_contains(std::string target, std::string query) {
+    old_to_lowercase(target);
+    old_to_lowercase(query);
+    return target.find(query) != std::string::npos;
+}
+
+//Search every field with both functions and print their GB/s
+template<typename Fields>
+static void measure(char const *name, Fields const &fields, std::string const &query, int runs) {
+    double bytes = 0;
+    for (auto const &field : fields) {
+        bytes += (double) field.size();
+    }
+
+    std::size_t found = 0, old_found = 0;
+    double kernel = best_time([&]() {
+        found = 0;
+        for (auto const &field : fields) {
+            found += check_field_contains(field, query);
+        }
+    }, runs);
+    double old = best_time([&]() {
+        old_found = 0;
+        for (auto const &field : fields) {
+            old_found += old_check_field_contains(field, query);
+        }
+    }, runs);
+
+    std::printf("%s: kernel %.2f GB/s, old function %.2f GB/s (%zu and %zu matches)\n",
+                name, bytes / kernel / 1e9, bytes / old / 1e9, found, old_found);
+}
+
+int main(int argc, char **argv) {
+    std::size_t count = bench_size(argc, argv, 1000000);
+
+    //Short fields: item titles
+    std::vector<std::string> titles;
+    for (std::size_t n = 0; n < count; n++) {
+        std::string line = bench_item_line(n % max_bench_items);
+        titles.push_back(line.substr(10, line.find(',', 10) - 10));
+    }
+    measure("titles", titles, "castle 12", 5);
+
+    //One long field: the titles joined, with the query only at the end
+    std::string text;
+    for (auto const &title : titles) {
+        text += title;
+        text += ' ';
+    }
+    text += "Needle In The Text";
+    measure("long text", std::vector<std::string>{text}, "needle in the", 5);
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include "Bench.h"
+#include "../headers/CustomerRepository.h"
+#include "../headers/ItemRepository.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+	Startup benchmark of customers.txt: the loader resolving every rental
+	through the item index, against the scans the loader used to make for
+	each rental (item_exists_with_id, then get_item_with_id to fetch it, both
+	comparing the text id of every item). The scans are timed on a sample of
+	the rentals and scaled to all of them, running them all would take minutes
+*/
+
+//The lookup before the item index
+static Item *scan_item_with_id(std::vector<Item *> const &items, std::string const &id) {
+    for (Item *item : items) {
+        if (item->get_id() == id) {
+            return item;
+        }
+    }
+    return nullptr;
+}
+
+int main(int argc, char **argv) {
+    std::size_t item_count = std::min(bench_size(argc, argv, 50000), max_bench_items);
+    std::size_t customer_count = 1000;
+    std::size_t rentals = 20;
+
+    BenchDirectory directory("customer_load_bench");
+    write_bench_items(directory.textfile("items.txt"), item_count);
+    write_bench_customers(directory.textfile("customers.txt"), customer_count, item_count, rentals);
+
+    Arena item_arena;
+    std::vector<Item *> items;
+    {
+        QuietConsole quiet;
+        items = TextFileItemPersistence().load(item_arena);
+    }
+
+    std::size_t loaded = 0;
+    double indexed = best_time([&]() {
+        QuietConsole quiet;
+        Arena arena;
+        TextFileCustomerPersistence persistence;
+        loaded = persistence.load(items, arena).size();
+    });
+
+    //Two scans for each rental of a VIP customer, timed on a sample
+    std::size_t sample = std::min<std::size_t>(200, customer_count * rentals);
+    std::size_t found = 0;
+    double scanned = best_time([&]() {
+        for (std::size_t n = 0; n < sample; n++) {
+            std::string id = bench_item_id(n * 7919 % item_count);
+            found += scan_item_with_id(items, id) != nullptr;
+            found += scan_item_with_id(items, id) != nullptr;
+        }
+    }, 1);
+    double scanned_total = scanned / (double) sample * (double) (customer_count * rentals);
+
+    std::printf("items: %zu, customers: %zu, rentals: %zu\n", item_count, loaded, customer_count * rentals);
+    std::printf("customer load with the item index: %.2f ms\n", indexed * 1e3);
+    std::printf("rental scans of the old loader (estimated): %.2f ms\n", scanned_total * 1e3);
+    return loaded == customer_count && found == 2 * sample ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+#include "Bench.h"
+#include "../headers/ItemRepository.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+	Micro-benchmark of item lookups by id: the hash index of
+	InMemoryItemRepository against the linear scan it replaced, which compared
+	the id of every item in turn. Also checks that the index still finds every
+	item after removals have moved items to other positions
+*/
+
+//The lookup before the hash index: a scan over the items comparing text ids
+static int scan_item_index(std::vector<Item *> const &items, std::string const &item_id) {
+    for (int position = 0; position < (int) items.size(); position++) {
+        if (item_id == items[position]->get_id()) {
+            return position;
+        }
+    }
+    return -1;
+}
+
+int main(int argc, char **argv) {
+    std::size_t count = std::min(bench_size(argc, argv, 100000), max_bench_items);
+
+    std::vector<Item *> items;
+    std::vector<std::string> ids;
+    for (std::size_t n = 0; n < count; n++) {
+        ids.push_back(bench_item_id(n));
+        items.push_back(new Game(ids.back(), "Medal of Honour", Item::RentalType::TwoDay, 3, 3.99f,
+                                 Item::RentalStatus::Available));
+    }
+    InMemoryItemRepository repository(items);
+
+    //Look the ids up in a scattered order, the scan only on a sample of them as it is O(n)
+    std::vector<std::string> lookups;
+    for (std::size_t n = 0; n < count; n++) {
+        lookups.push_back(ids[n * 7919 % count]);
+    }
+    std::size_t sample = std::min<std::size_t>(count, 1000);
+
+    std::size_t found = 0;
+    double indexed = best_time([&]() {
+        for (auto const &id : lookups) {
+            found += repository.get_item(id) != nullptr;
+        }
+    });
+    double scanned = best_time([&]() {
+        for (std::size_t n = 0; n < sample; n++) {
+            found += scan_item_index(items, lookups[n]) != -1;
+        }
+    }, 1);
+
+    double indexed_ns = indexed * 1e9 / (double) lookups.size();
+    double scanned_ns = scanned * 1e9 / (double) sample;
+    std::printf("items: %zu\n", count);
+    std::printf("hash index lookup: %.1f ns\n", indexed_ns);
+    std::printf("linear scan lookup: %.1f ns\n", scanned_ns);
+    std::printf("speedup: %.0fx\n", scanned_ns / indexed_ns);
+
+    //Remove half of the items in a scattered order: each removal moves the last item into
+    //the freed position, every item left must still be found at its new position
+    {
+        QuietConsole quiet;
+        for (std::size_t n = 0; n < count / 2; n++) {
+            repository.remove_item(lookups[n]);
+        }
+    }
+    bool consistent = repository.get_items().size() == count - count / 2;
+    for (std::size_t n = 0; n < count; n++) {
+        Item *item = repository.get_item(lookups[n]);
+        consistent &= n < count / 2 ? item == nullptr : item != nullptr && item->get_id() == lookups[n];
+    }
+    std::printf("removals consistent: %s\n", consistent ? "yes" : "no");
+    return found > 0 && consistent ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+#include "Bench.h"
+#include "../headers/ItemHelpers.h"
+#include "../headers/ItemRepository.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/*
+	Load time benchmark of items.txt: the mapped string_view loader (on one
+	thread, the parallel mode is measured by parallel_load_bench) against the
+	reading and tokenizing it replaced: std::getline, get_item_as_vector
+	erasing each field off the front of the line, a substr copy per field,
+	std::stoi/std::stof and a std::endl per log line.
+	Both check the lines with the same validators and find repeated ids with
+	the same hash index, so only the reading and tokenizing differ.
+	The id format allows 134000 items: larger files repeat the ids, and both
+	loaders reject the repeats the same way
+*/
+
+//get_item_as_vector before the mapped loader
+static std::vector<std::string> old_get_item_as_vector(std::string &line) {
+    std::vector<std::string> item_as_vector;
+    std::string delimiter = ",";
+    size_t pos = 0;
+    std::string token;
+
+    while ((pos = line.find(delimiter)) != std::string::npos) {
+        token = line.substr(0, pos);
+        if (token.empty()) {
+            return {};
+        }
+        remove_carriage_return(token);
+        item_as_vector.push_back(token);
+        line.erase(0, pos + delimiter.length());
+    }
+    remove_carriage_return(line);
+    item_as_vector.push_back(line.substr(0, line.length()));
+    return item_as_vector;
+}
+
+//The getline loader, with the current validators and id index
+static std::vector<Item *> old_load(std::string const &path, Arena &arena) {
+    std::ifstream infile(path);
+    std::vector<Item *> items;
+    ItemIndex loaded_items;
+    std::string line;
+    while (std::getline(infile, line)) {
+        if (line.empty() || line[0] == '#' || !correct_info_length(line)) {
+            continue;
+        }
+        std::vector<std::string> fields = old_get_item_as_vector(line);
+        if (fields.empty() || !valid_item_data(fields[0], loaded_items, fields[2], fields[fields.size() - 1],
+                                               fields.size(), fields[3], fields[4], fields[5])) {
+            continue;
+        }
+        Item *item;
+        if (fields.size() == 6) {
+            item = arena.create<Game>(fields[0], fields[1], string_to_rental_type(fields[3]),
+                                      std::stoi(fields[4]), std::stof(fields[5]), Item::RentalStatus::Available);
+        } else if (fields[2] == "DVD") {
+            item = arena.create<DVD>(fields[0], fields[1], string_to_rental_type(fields[3]),
+                                     std::stoi(fields[4]), std::stof(fields[5]), Item::RentalStatus::Available,
+                                     string_to_genre(fields[6]));
+        } else {
+            item = arena.create<VideoRecord>(fields[0], fields[1], string_to_rental_type(fields[3]),
+                                             std::stoi(fields[4]), std::stof(fields[5]),
+                                             Item::RentalStatus::Available, string_to_genre(fields[6]));
+        }
+        items.push_back(item);
+        loaded_items.insert(item->get_key(), item);
+        std::cout << "[SUCCESS] Successfully created listing with ID: " << fields[0] << std::endl;
+    }
+    return items;
+}
+
+int main(int argc, char **argv) {
+    std::size_t lines = bench_size(argc, argv, max_bench_items);
+
+    BenchDirectory directory("item_load_bench");
+    {
+        std::ofstream file(directory.textfile("items.txt"), std::ios::binary);
+        for (std::size_t n = 0; n < lines; n++) {
+            file << bench_item_line(n % max_bench_items) << (n + 1 < lines ? "\n" : "");
+        }
+    }
+
+    std::size_t loaded = 0, old_loaded = 0;
+    double mapped = best_time([&]() {
+        QuietConsole quiet;
+        Arena arena;
+        loaded = TextFileItemPersistence(1).load(arena).size();
+    }, 3);
+    double old = best_time([&]() {
+        QuietConsole quiet;
+        Arena arena;
+        old_loaded = old_load(directory.textfile("items.txt"), arena).size();
+    }, 3);
+
+    std::printf("lines: %zu, items: %zu\n", lines, loaded);
+    std::printf("mapped loader: %.1f ms\n", mapped * 1e3);
+    std::printf("getline loader: %.1f ms\n", old * 1e3);
+    std::printf("speedup: %.1fx\n", old / mapped);
+    return loaded == old_loaded ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+#include "Bench.h"
+#include "../headers/ItemHelpers.h"
+#include "../headers/ItemRepository.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+	Throughput benchmark of the item listing in records per second: the
+	console displayer rendering into its reusable buffer, against the listing
+	it replaced, which built each record with an ostringstream and string
+	concatenations and wrote it with std::endl. Both write through std::cout,
+	sent to /dev/null so the terminal is not measured
+*/
+
+//Item::to_string_console before the output buffer
+static std::string old_item_text(Item const *item) {
+    std::ostringstream oss;
+    oss << "ID: " << item->get_key() << ", ";
+    oss << "Title: " << item->get_title() << ", ";
+    oss << "Rental type: " << (item->get_rental_type() == Item::RentalType::TwoDay ? "Two day" : "One week") << ", ";
+    oss << "Stock: " << item->get_number_in_stock() << ", ";
+    oss << "Fee: " << item->get_rental_fee() << ", ";
+    oss << "Rental status: " << (item->get_rental_status() == Item::RentalStatus::Available ? "Available" : "Borrowed");
+    return oss.str();
+}
+
+//The Game, VideoRecord and DVD overloads, which wrapped it in more temporaries
+static std::string old_to_string_console(Item const *item) {
+    if (item->get_type() == GAME) {
+        return {"Game: [" + old_item_text(item) + "]"};
+    }
+    auto genred = static_cast<GenredItem const *>(item);
+    std::string genred_text = {old_item_text(item) + ", Genre: " + genre_to_string(genred->get_genre())};
+    if (item->get_type() == VIDEO) {
+        return {"Video record: [" + genred_text + "]"};
+    }
+    return {"DVD: [" + genred_text + "]"};
+}
+
+int main(int argc, char **argv) {
+    std::size_t count = std::min(bench_size(argc, argv, 100000), max_bench_items);
+
+    BenchDirectory directory("listing_bench");
+    write_bench_items(directory.textfile("items.txt"), count);
+    Arena arena;
+    std::vector<Item *> items;
+    {
+        QuietConsole quiet;
+        items = TextFileItemPersistence().load(arena);
+    }
+
+    std::ofstream null("/dev/null");
+    std::streambuf *console = std::cout.rdbuf(null.rdbuf());
+    ConsoleItemDisplayer displayer;
+    ItemNoOrder order;
+    double buffered = best_time([&]() {
+        displayer.display(items, &order);
+    });
+    double old = best_time([&]() {
+        for (Item const *item : items) {
+            std::cout << old_to_string_console(item) << std::endl;
+        }
+    });
+    std::cout.rdbuf(console);
+
+    std::printf("records: %zu\n", items.size());
+    std::printf("buffered listing: %.2f M records/s\n", (double) items.size() / buffered / 1e6);
+    std::printf("old listing: %.2f M records/s\n", (double) items.size() / old / 1e6);
+    return items.size() == count ? 0 : 1;
+}
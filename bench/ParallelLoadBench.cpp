@@ -0,0 +1,49 @@
+#include "Bench.h"
+#include "../headers/ItemRepository.h"
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+/*
+	Scaling benchmark of the parallel items.txt loader: the load time with 1,
+	2, 4 and 8 worker threads (and one per core when there are more cores),
+	and the speedup over one thread
+*/
+
+int main(int argc, char **argv) {
+    std::size_t lines = bench_size(argc, argv, max_bench_items);
+
+    BenchDirectory directory("parallel_load_bench");
+    {
+        std::ofstream file(directory.textfile("items.txt"), std::ios::binary);
+        for (std::size_t n = 0; n < lines; n++) {
+            file << bench_item_line(n % max_bench_items) << (n + 1 < lines ? "\n" : "");
+        }
+    }
+
+    std::vector<unsigned int> thread_counts = {1, 2, 4, 8};
+    if (std::thread::hardware_concurrency() > 8) {
+        thread_counts.push_back(std::thread::hardware_concurrency());
+    }
+
+    std::printf("lines: %zu, cores: %u\n", lines, std::thread::hardware_concurrency());
+    double single = 0;
+    std::size_t expected = 0;
+    for (auto threads : thread_counts) {
+        std::size_t loaded = 0;
+        double elapsed = best_time([&]() {
+            QuietConsole quiet;
+            Arena arena;
+            loaded = TextFileItemPersistence(threads).load(arena).size();
+        }, 3);
+        if (threads == 1) {
+            single = elapsed;
+            expected = loaded;
+        }
+        std::printf("%u thread(s): %.1f ms, speedup %.2fx\n", threads, elapsed * 1e3, single / elapsed);
+        if (loaded != expected) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+	This component contains a monotonic arena allocator.
+	Objects created in the arena are placed one after another in large blocks,
+	they are never freed one by one: the whole arena is released at once,
+	running the destructors of the objects which need it and freeing the blocks.
+	It is used for every item and customer materialized by a load, so a large
+	dataset costs a handful of allocations instead of one per object
+*/
+class Arena {
+    //A block of memory objects are bump-allocated from
+    struct Block {
+        char* begin;
+        std::size_t size;
+    };
+
+    //Destructor to run when the arena is released, stored in the arena itself
+    struct Finalizer {
+        void (*destroy)(void*);
+        void* object;
+        Finalizer* next;
+    };
+
+    //Blocks sorted by address so owns() can use a binary search
+    std::vector<Block> blocks;
+    char* current = nullptr;
+    char* end = nullptr;
+    std::size_t next_block_size;
+    Finalizer* finalizers = nullptr;
+
+    static const std::size_t initial_block_size = 64 * 1024;
+    static const std::size_t max_block_size = 16 * 1024 * 1024;
+
+    void add_block(std::size_t minimum_size);
+
+    template<typename T>
+    static void destroy(void* object) {
+        static_cast<T*>(object)->~T();
+    }
+
+public:
+    Arena();
+    ~Arena();
+    Arena(Arena const&) = delete;
+    Arena& operator=(Arena const&) = delete;
+
+    //Get size bytes of memory aligned to alignment
+    void* allocate(std::size_t size, std::size_t alignment);
+
+    //Construct an object in the arena
+    //Its destructor is run when the arena is released
+    template<typename T, typename... Args>
+    T* create(Args&&... args) {
+        T* object = new(allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if (!std::is_trivially_destructible<T>::value) {
+            Finalizer* finalizer = new(allocate(sizeof(Finalizer), alignof(Finalizer))) Finalizer{
+                    &Arena::destroy<T>, object, finalizers
+            };
+            finalizers = finalizer;
+        }
+        return object;
+    }
+
+    //Check if an object was created in this arena
+    bool owns(void const* object) const;
+
+    //Take the blocks and objects of another arena, which is left empty
+    //The objects are released with this arena's, the other's first
+    void adopt(Arena& other);
+
+    //Destroy every object and free every block
+    void release();
+};
@@ -0,0 +1,106 @@
+#pragma once
+#include "HashIndex.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+	This component contains plain bitmaps and a bitmap index over the
+	low-cardinality attributes of records (genre, rental type, item type,
+	customer level...). Every record gets a slot, and every value of every
+	attribute keeps a bitmap with the bits of the slots having that value.
+	Filters on several attributes are then AND / OR / NOT over 64 slots per
+	instruction, and counts are popcounts: no record is ever visited.
+	Slots are given in insertion order and never reused, so walking the set bits
+	gives the records in the order they were added; once most slots belong to
+	removed records the index renumbers the remaining ones
+*/
+class Bitmap {
+    std::vector<std::uint64_t> words;
+    std::size_t bit_count = 0;
+
+public:
+    Bitmap() = default;
+    explicit Bitmap(std::size_t bit_count) : words((bit_count + 63) / 64), bit_count(bit_count) {}
+
+    inline std::size_t size() const { return bit_count; }
+
+    //Grow or shrink the bitmap, new bits are cleared
+    void resize(std::size_t new_bit_count);
+    void clear() { words.clear(); bit_count = 0; }
+
+    inline bool test(std::size_t bit) const { return (words[bit / 64] >> (bit % 64)) & 1u; }
+    inline void set(std::size_t bit) { words[bit / 64] |= std::uint64_t(1) << (bit % 64); }
+    inline void reset(std::size_t bit) { words[bit / 64] &= ~(std::uint64_t(1) << (bit % 64)); }
+
+    //Number of set bits
+    std::size_t count() const;
+
+    //Word-parallel operations, both bitmaps must have the same size
+    Bitmap &operator&=(Bitmap const &other);
+    Bitmap &operator|=(Bitmap const &other);
+    //Clear the bits set in other
+    Bitmap &and_not(Bitmap const &other);
+
+    //Call f with the position of every set bit, in increasing order
+    template<typename F>
+    void for_each(F f) const {
+        for (std::size_t w = 0; w < words.size(); w++) {
+            std::uint64_t word = words[w];
+            while (word != 0) {
+                f(w * 64 + (std::size_t) __builtin_ctzll(word));
+                word &= word - 1;
+            }
+        }
+    }
+};
+
+class BitmapIndex {
+    //Number of values of every attribute, and where its bitmaps start in values
+    std::vector<std::size_t> cardinalities;
+    std::vector<std::size_t> offsets;
+
+    //One bitmap per value of every attribute, and the bitmap of the slots in use
+    std::vector<Bitmap> values;
+    Bitmap live;
+    std::size_t live_count = 0;
+
+    //Slot -> key and attribute values, key -> slot
+    std::vector<std::uint32_t> keys;
+    std::vector<std::uint8_t> slot_values;
+    HashIndex<std::uint32_t, std::uint32_t> slots;
+
+    void compact();
+
+public:
+    //cardinalities[a] is the number of values of attribute a
+    explicit BitmapIndex(std::vector<std::size_t> cardinalities);
+
+    //Get the number of indexed records
+    inline std::size_t size() const { return live_count; }
+    inline std::size_t attribute_count() const { return cardinalities.size(); }
+
+    //Remove every record
+    void clear();
+
+    //Index a record, or change its values if the key is already indexed
+    //record_values[a] is the value of attribute a
+    void set(std::uint32_t key, std::uint8_t const *record_values);
+
+    //Remove a record, return false if the key is not indexed
+    bool remove(std::uint32_t key);
+
+    //Bitmap of the records having a value for an attribute
+    inline Bitmap const &get(std::size_t attribute, std::uint8_t value) const {
+        return values[offsets[attribute] + value];
+    }
+
+    //Bitmap of every record
+    inline Bitmap const &all() const { return live; }
+
+    //Append the keys of the set bits of a bitmap of this index, in insertion order
+    void keys_of(Bitmap const &bits, std::vector<std::uint32_t> &result) const;
+
+    //Sort indexed keys into insertion order
+    void sort_keys(std::vector<std::uint32_t> &keys) const;
+};
@@ -1,7 +1,11 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 #include "Item.h"
+#include "PackedId.h"
+#include "StringPool.h"
+#include "OutputBuffer.h"
 
 /*
 	This components contains the logic for a customer and its state: Guest, Regular and VIP
@@ -18,9 +22,9 @@ class CustomerState;
 //Customer class containing id, name, address, phone, item and state
 class Customer {
     //Hold the id, name, address and phone
-    std::string id;
-    std::string name;
-    std::string address;
+    CustomerId id;
+    InternedString name;
+    InternedString address;
     std::string phone;
 
     //Hold the number of renting items
@@ -34,27 +38,39 @@ class Customer {
     //Each customer will have a state representing his/her privelegde
     CustomerState* state;
 
+    //False when the state is owned by an arena instead of the customer
+    bool owns_state = true;
+
 public:
     //Constructor and destructor
     Customer() = default;
-    Customer(std::string  id, std::string  name, std::string  address, std::string  phone, int total_rentals, std::vector<Item*>  items, CustomerState* state);
+    //Constructor, throws std::invalid_argument if the id is not in the Cxxx format
+    Customer(std::string const& id, std::string_view name, std::string_view address, std::string  phone, int total_rentals, std::vector<Item*>  items, CustomerState* state, bool owns_state = true);
+    //Constructor from an already packed id
+    Customer(CustomerId id, std::string_view name, std::string_view address, std::string phone, int total_rentals, std::vector<Item*> items, CustomerState* state, bool owns_state = true);
     ~Customer();
 
     //Get methods
     inline int get_number_of_rentals() const { return number_of_rentals; }
     inline void increase_number_of_videos() { number_of_videos += 1; }
     inline int get_number_of_videos() const { return number_of_videos; }
-    inline std::vector<Item*> get_items() const { return items; }
-    inline std::string get_id() const { return id; }
-    inline std::string get_name() const { return name; }
-    inline std::string get_address() const { return address; }
-    inline std::string get_phone() const { return phone; }
+    inline std::vector<Item*> const& get_items() const { return items; }
+    inline std::string get_id() const { return decode_customer_id(id); }
+    inline CustomerId get_key() const { return id; }
+    inline std::string_view get_name() const { return string_pool().view(name); }
+    inline std::string_view get_address() const { return string_pool().view(address); }
+    inline std::string const& get_phone() const { return phone; }
     Category get_state() const;
 
     //Set methods
-    inline void set_name(std::string const& new_name) { name = new_name; }
-    inline void set_address(std::string const& new_address) { address = new_address; }
+    inline void set_name(std::string_view new_name) { name = string_pool().intern(new_name); }
+    inline void set_address(std::string_view new_address) { address = string_pool().intern(new_address); }
     inline void set_phone(std::string const& new_phone) { phone = new_phone; }
+    inline void set_rentals(std::vector<Item*> const& new_items, int total_rentals, int videos) {
+        items = new_items;
+        number_of_rentals = total_rentals;
+        number_of_videos = videos;
+    }
     void change_state(CustomerState* new_state);
 
     //Method to promote a customer
@@ -69,6 +85,10 @@ public:
 
     //Methods for printing the items
     friend std::ostream& operator<<(std::ostream& os, Customer const&);
+    //Append the console representation to an output buffer, without temporaries
+    void render_console(OutputBuffer& out) const;
+    //Append the file representation (the customer line and the ids of its rentals) to an output buffer
+    void render_file(OutputBuffer& out) const;
     std::string to_string_file() const;
 };
 
@@ -77,6 +97,9 @@ public:
 //Which can be change to reflects his/her status
 class CustomerState {
 public:
+    //States are deleted through this class by the customer owning them
+    virtual ~CustomerState() = default;
+
     //Methods to borrow an items
     virtual void borrow(Item* item) = 0;
 
@@ -84,7 +107,7 @@ public:
     //Guest -> Regular or Regula -> VIP
     virtual bool can_be_promoted() const = 0;
     virtual void promote() = 0;
-    virtual std::string to_string() const = 0;
+    virtual char const* to_string() const = 0;
 
     //Set the Context of the state - which is the customer itself
     virtual void set_context(Customer* customer) = 0;
@@ -133,7 +156,7 @@ public:
     //Method to get the State (Guest, VIP, Regular)
     Category get_state() override;
 
-    std::string to_string() const override;
+    char const* to_string() const override;
 };
 
 //RegularState: Child of ThreeItemPromotableState
@@ -149,7 +172,7 @@ public:
 
     //Get the State enum (guest, regular, VIP)
     Category get_state() override;
-    std::string to_string() const override;
+    char const* to_string() const override;
 };
 
 //VIPState: Child of ThreeItemPromotableState
@@ -168,5 +191,5 @@ public:
     //Get the State enum (guest, regular, VIP) and set context
     void set_context(Customer* customer) override;
     Category get_state() override;
-    std::string to_string() const override;
+    char const* to_string() const override;
 };
\ No newline at end of file
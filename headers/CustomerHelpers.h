@@ -7,18 +7,25 @@
 
 std::vector<std::string> get_customer_as_vector(const std::string &str);
 
-bool correct_customer_info_length(const std::string &line);
+//Split a customer line into fields (empty fields are dropped), reusing the vector
+void split_customer_fields(const std::string &line, std::vector<std::string> &fields);
+
+//The validators report what is wrong with a value to the log, the console by default
+bool correct_customer_info_length(const std::string &line, std::ostream &log = std::cout);
 
 bool customer_phone_is_valid(const std::string &stock);
 
-bool customer_id_is_valid(const std::string &id, bool from_menu = true);
+bool customer_id_is_valid(const std::string &id, bool from_menu = true, std::ostream &log = std::cout);
 
-bool customer_name_is_valid(const std::string &name);
+bool customer_name_is_valid(const std::string &name, std::ostream &log = std::cout);
 
-bool customer_address_is_valid(const std::string &address);
+bool customer_address_is_valid(const std::string &address, std::ostream &log = std::cout);
 
-bool customer_type_is_valid(const std::string &type);
+bool customer_type_is_valid(const std::string &type, std::ostream &log = std::cout);
 
 bool valid_customer_data(const std::string &id);
 
+//Check a customer line, leaving its fields in fields so it is tokenized only once
+bool valid_customer_data(const std::string &line, std::vector<std::string> &fields, std::ostream &log = std::cout);
+
 int get_number_of_videos(Customer const* customer);
@@ -2,7 +2,21 @@
 
 #include "Customer.h"
 #include "StringHelper.h"
+#include "HashIndex.h"
+#include "Arena.h"
+#include "TrigramIndex.h"
+#include "OrderedIndex.h"
+#include "QueryPlan.h"
+#include "Bitmap.h"
+#include "Page.h"
+#include "FileWriter.h"
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <list>
+#include <string>
+#include <string_view>
 
 /*
 	This class contains the Customer Service class
@@ -69,9 +83,44 @@ struct PhoneModificationIntent : public ModificationIntent {
     void modify() override;
 };
 
+//Child of Modification intent
+//Used when we want to promote a customer to the next level
+struct PromotionModificationIntent : public ModificationIntent {
+    PromotionModificationIntent() = default;
+
+    void modify() override;
+};
+
+//Strict orders on customers, ties are broken by id
+//Used by the order classes and by the ordered indexes of the repositories
+struct CustomerNameLess {
+    bool operator()(Customer const *a, Customer const *b) const;
+};
+
+struct CustomerIdLess {
+    bool operator()(Customer const *a, Customer const *b) const;
+};
+
+struct CustomerLevelLess {
+    bool operator()(Customer const *a, Customer const *b) const;
+};
+
+//Attributes of the customer bitmap index
+enum CustomerAttribute { LEVEL_ATTRIBUTE = 0 };
+
+//Bitmap index over the level (guest, regular or VIP) of the customers
+struct CustomerBitmapIndex : public BitmapIndex {
+    CustomerBitmapIndex();
+
+    //Index a customer or update its level
+    void set_customer(Customer const *customer);
+};
+
 //A blue print of repository pattern
 //containing methods such as CRUD of customers
 struct CustomerRepository {
+    virtual ~CustomerRepository() = default;
+
     virtual void add_customer(Customer *customer) = 0;
 
     virtual Customer *get_customer(std::string const &) = 0;
@@ -80,20 +129,89 @@ struct CustomerRepository {
 
     virtual void update_customer(std::string const &customer_id, ModificationIntent &intent) = 0;
 
-    virtual std::vector<Customer *> get_customers() = 0;
+    virtual std::vector<Customer *> const &get_customers() = 0;
 
     virtual void set_customers(std::vector<Customer *> const &) = 0;
+
+    //Repositories reading the customers themselves, when they are first needed, open the
+    //data file here instead of being given every customer by the persistence
+    //Return false if the repository is given its customers
+    virtual bool open(std::vector<Item *> const &items) { return false; }
+
+    //Repositories reading the customers themselves render the data file here, from the file
+    //and the customers changed, instead of reading every customer for the persistence
+    //Return false if the persistence renders the customers
+    virtual bool render(PendingFile &file) { return false; }
+
+    //A customer was changed outside of the repository (borrowing or returning)
+    virtual void customer_changed(Customer *customer) { mark_changed(); }
+
+    //Arena owning the customers materialized by a load, released with the repository
+    virtual Arena &get_arena() = 0;
+
+    //Version of the customers, bumped by every change (adding, removing, modifying,
+    //and borrowing and returning through the service) but not by a load
+    //Compared with the version last saved to skip saving unchanged customers
+    inline std::uint64_t get_version() const { return version; }
+
+    inline void mark_changed() { version++; }
+
+    //Substring search on the names and ids through the trigram indexes of the repository
+    //The customers found are appended in repository order, return false if there is no index
+    virtual bool search_names(std::string_view query, std::vector<Customer *> &found) { return false; }
+
+    virtual bool search_ids(std::string_view query, std::vector<Customer *> &found) { return false; }
+
+    //Number of candidates a name or id search would check, return false if there is no index
+    virtual bool estimate_names(std::string_view query, std::size_t &estimate) { return false; }
+
+    virtual bool estimate_ids(std::string_view query, std::size_t &estimate) { return false; }
+
+    //Customers kept in name, id or level order by the repository, nullptr if it does not keep the order
+    virtual std::vector<Customer *> const *get_customers_by_name() { return nullptr; }
+
+    virtual std::vector<Customer *> const *get_customers_by_id() { return nullptr; }
+
+    virtual std::vector<Customer *> const *get_customers_by_level() { return nullptr; }
+
+    //Bitmap index of the repository, nullptr if it does not keep one
+    virtual CustomerBitmapIndex const *get_bitmap_index() { return nullptr; }
+
+    //Append the customers of the set bits of a bitmap of the bitmap index, in repository order
+    virtual void collect_bitmap(Bitmap const &bits, std::vector<Customer *> &found) {}
+
+protected:
+    std::uint64_t version = 0;
 };
 
 //Implementation of Repository pattern
 //Where all CRUD operation will be done using an in-memory vector
+//Customers are found through a hash index from id to position in the vector,
+//and removing swaps the last customer into the freed position so nothing is shifted
 struct InMemoryCustomerRepository : public CustomerRepository {
     std::vector<Customer *> customers;
+    HashIndex<CustomerId, std::size_t> index;
+    //Trigram indexes over the names and the text ids
+    TrigramIndex name_index;
+    TrigramIndex id_index;
+    //Ordered indexes for the name, id and level listings
+    //The name and level change only through update_customer, which keeps them in order
+    OrderedIndex<Customer, CustomerNameLess> by_name;
+    OrderedIndex<Customer, CustomerIdLess> by_id;
+    OrderedIndex<Customer, CustomerLevelLess> by_level;
+    //Bitmap index over the levels, kept up to date by update_customer like the level order
+    CustomerBitmapIndex bitmaps;
+    //Arena owning the loaded customers and their states
+    Arena arena;
 public:
     InMemoryCustomerRepository() = default;
 
     InMemoryCustomerRepository(std::vector<Customer *> const &customers);
 
+    ~InMemoryCustomerRepository();
+
+    Arena &get_arena() override { return arena; }
+
     Customer *get_customer(std::string const &) override;
 
     void set_customers(std::vector<Customer *> const &customers) override;
@@ -104,70 +222,288 @@ public:
 
     void update_customer(std::string const &customer_id, ModificationIntent &intent) override;
 
-    std::vector<Customer *> get_customers() override { return customers; }
+    std::vector<Customer *> const &get_customers() override { return customers; }
+
+    bool search_names(std::string_view query, std::vector<Customer *> &found) override;
+
+    bool search_ids(std::string_view query, std::vector<Customer *> &found) override;
+
+    bool estimate_names(std::string_view query, std::size_t &estimate) override {
+        estimate = name_index.estimate(query);
+        return true;
+    }
+
+    bool estimate_ids(std::string_view query, std::size_t &estimate) override {
+        estimate = id_index.estimate(query);
+        return true;
+    }
+
+    std::vector<Customer *> const *get_customers_by_name() override { return &by_name.get(); }
+
+    std::vector<Customer *> const *get_customers_by_id() override { return &by_id.get(); }
+
+    std::vector<Customer *> const *get_customers_by_level() override { return &by_level.get(); }
+
+    CustomerBitmapIndex const *get_bitmap_index() override { return &bitmaps; }
+
+    void collect_bitmap(Bitmap const &bits, std::vector<Customer *> &found) override;
+
+    int get_customer_index(std::string const &customer_id) const;
+
+    void rebuild_index();
+
+    void index_text(Customer const *customer);
+
+    void collect(std::vector<std::uint32_t> const &keys, std::vector<Customer *> &found) const;
+};
+
+//Implementation of Repository pattern
+//Where a customer is only read from customers.txt when it is looked up, so a session
+//costs the customers it uses instead of the whole file:
+//- customers.idx maps every customer id to the position of the customer in the file,
+//  sorted by id and memory mapped; it is built again (with one pass over customers.txt)
+//  when it does not match the size and time of the file
+//- the customers read are cached, the least recently used is dropped when the cache is full
+//- customers added or changed (which the file does not have yet) are kept until the end,
+//  and the customers of the file which are removed are remembered
+//Listing and filtering need every customer: the first of them reads the whole file, then
+//the repository keeps every customer like the in-memory repository
+//Saving and checkpoints stream customers.txt instead: the records of the unchanged customers
+//are copied as they are, so writing the file does not bring every customer in memory
+struct LazyCustomerRepository : public CustomerRepository {
+    static constexpr char const *path = "../textfiles/customers.txt";
+    static constexpr char const *index_path = "../textfiles/customers.idx";
+
+    //Number of unchanged customers kept in memory
+    static const std::size_t default_cache_size = 1024;
+
+private:
+    //A customer in memory
+    struct CachedCustomer {
+        Customer *customer = nullptr;
+        //Kept customers are never dropped and are not in the recently used list
+        bool kept = false;
+        std::list<CustomerId>::iterator position;
+    };
+
+    std::size_t cache_size;
+
+    //Data file, and the records of the index (in the mapped index, or built when it did not match)
+    MappedFile file;
+    MappedFile index_file;
+    std::string built_index;
+    char const *index_records = nullptr;
+    std::uint32_t index_count = 0;
+
+    //Items the rentals are resolved against
+    ItemIndex item_index;
+
+    HashIndex<CustomerId, CachedCustomer> cache;
+    //Ids of the customers which can be dropped, the most recently used first
+    std::list<CustomerId> recently_used;
+    //Customers of the file which have been removed
+    HashIndex<CustomerId, bool> removed;
+    //Customers which are not in the file, in the order they were added
+    std::vector<Customer *> added;
+    //Customers removed, deleted with the repository since the caller may still use them
+    std::vector<Customer *> retired;
+
+    //Every customer, once they are all read
+    bool complete = false;
+    std::vector<Customer *> customers;
+
+    //Arena owning the customers given by set_customers
+    Arena arena;
+
+public:
+    explicit LazyCustomerRepository(std::size_t cache_size = default_cache_size);
+
+    ~LazyCustomerRepository();
+
+    LazyCustomerRepository(LazyCustomerRepository const &) = delete;
+    LazyCustomerRepository &operator=(LazyCustomerRepository const &) = delete;
+
+    bool open(std::vector<Item *> const &items) override;
+
+    bool render(PendingFile &file) override;
+
+    Arena &get_arena() override { return arena; }
+
+    Customer *get_customer(std::string const &) override;
+
+    void set_customers(std::vector<Customer *> const &customers) override;
+
+    void add_customer(Customer *customer) override;
+
+    void remove_customer(std::string const &customer_id) override;
+
+    void update_customer(std::string const &customer_id, ModificationIntent &intent) override;
+
+    void customer_changed(Customer *customer) override;
+
+    std::vector<Customer *> const &get_customers() override;
+
+    //Number of customers in memory, and of customers in the file
+    inline std::size_t get_cached_count() const { return cache.size(); }
+
+    inline std::size_t get_indexed_count() const { return index_count; }
+
+private:
+    bool open_index();
+    void build_index();
+    bool find_record(CustomerId key, std::uint64_t &offset, std::uint32_t &line) const;
+    Customer *read_customer(std::uint64_t offset, std::uint32_t line);
+    void cache_customer(Customer *customer, bool kept);
+    void keep(CustomerId key);
+    void drop_least_recently_used();
+    void read_all();
+    void clear();
 };
 
 //Blueprint for Customer persistence
 //Containing two methods: load() for loading customer data
 //save() for saving customer data
+//The loaded customers are created in the given arena
+//render() gives what save() writes without writing it, for the checkpoints of the journal
+//(with the items as they are written next to the customers)
 struct CustomerPersistence {
-    virtual std::vector<Customer *> load(std::vector<Item *>) = 0;
+    virtual ~CustomerPersistence() = default;
+
+    virtual std::vector<Customer *> load(std::vector<Item *> const &, Arena &arena) = 0;
 
-    virtual void save(std::vector<Customer *>) = 0;
+    virtual void save(std::vector<Customer *> const &) = 0;
+
+    virtual PendingFile render(std::vector<Customer *> const &, std::vector<Item *> const &items) = 0;
 };
 
 //Implementation of CustomerPersistence
 //This is responsible for loading and saving
 //customers from and to a text file
 struct TextFileCustomerPersistence : public CustomerPersistence {
-    std::vector<Customer *> load(std::vector<Item *>) override;
-    void save(std::vector<Customer *>) override;
+    std::vector<Customer *> load(std::vector<Item *> const &, Arena &arena) override;
+    void save(std::vector<Customer *> const &) override;
+    PendingFile render(std::vector<Customer *> const &, std::vector<Item *> const &items) override;
+};
+
+//Position of a customer in a listing, kept by value so it stays valid when the customer
+//is changed or removed: the next page starts after where the customer was
+struct CustomerCursor {
+    std::string name;
+    Category level = Category::guest;
+    CustomerId key;
+
+    CustomerCursor() = default;
+    explicit CustomerCursor(Customer const *customer);
 };
 
+//A page of a customer listing
+using CustomerPage = Page<Customer, CustomerCursor>;
+
 //Order classes
 //These classes are responsible for
 //Sorting a customer list based on their attributes
 struct CustomerOrder {
     virtual void order(std::vector<Customer *> &customers) const = 0;
+
+    //Pagination: strict total order of the listing, and position of a customer
+    //relative to a cursor (negative before it, zero at it, positive after it)
+    virtual bool less(Customer const *a, Customer const *b) const = 0;
+    virtual int compare(Customer const *customer, CustomerCursor const &cursor) const = 0;
+
+    //False if order() leaves the list as it is, so it does not need to be copied
+    virtual bool reorders() const { return true; }
+
+    //Get the customers of a repository already kept in this order, nullptr if it does not keep it
+    virtual std::vector<Customer *> const *ordered(CustomerRepository &repository) const { return nullptr; }
 };
 
 //No order: This class will do nothing
+//The repository order has no position to resume from, so its pages follow the ids
 struct CustomerNoOrder : public CustomerOrder {
     void order(std::vector<Customer *> &customers) const override;
+    bool reorders() const override { return false; }
+    std::vector<Customer *> const *ordered(CustomerRepository &repository) const override;
+    bool less(Customer const *a, Customer const *b) const override;
+    int compare(Customer const *customer, CustomerCursor const &cursor) const override;
 };
 
 //Order by name: This class will sort the customer based on their names
 struct CustomerNameOrder : public CustomerOrder {
     void order(std::vector<Customer *> &customers) const override;
+    std::vector<Customer *> const *ordered(CustomerRepository &repository) const override;
+    bool less(Customer const *a, Customer const *b) const override;
+    int compare(Customer const *customer, CustomerCursor const &cursor) const override;
 };
 
 //Order by id: This class will sort the customer based on their ids
 struct CustomerIdOrder : public CustomerOrder {
     void order(std::vector<Customer *> &customers) const override;
+    std::vector<Customer *> const *ordered(CustomerRepository &repository) const override;
+    bool less(Customer const *a, Customer const *b) const override;
+    int compare(Customer const *customer, CustomerCursor const &cursor) const override;
 };
 
 //Order by Level: This class will sort the customer based on their levels
 //Guest -> Regular -> VIP
 struct CustomerLevelOrder : public CustomerOrder {
     void order(std::vector<Customer *> &customers) const override;
+    std::vector<Customer *> const *ordered(CustomerRepository &repository) const override;
+    bool less(Customer const *a, Customer const *b) const override;
+    int compare(Customer const *customer, CustomerCursor const &cursor) const override;
 };
 
 //Blueprint for CustomerDisplayer
 //Which is used to display customer through an interface
 struct CustomerDisplayer {
-    virtual void display(std::vector<Customer *> customers, CustomerOrder const *order) = 0;
+    virtual ~CustomerDisplayer() = default;
+
+    virtual void display(std::vector<Customer *> const &customers, CustomerOrder const *order) = 0;
 };
 
 //Implementation of CustomerDisplayer
 //Responsible for displaying the customer through the console
+//The customers are rendered into one buffer kept between listings and written in large chunks
 struct ConsoleCustomerDisplayer : public CustomerDisplayer {
-    void display(std::vector<Customer *> customers, CustomerOrder const *order) override;
+    OutputBuffer out{std::cout};
+
+    void display(std::vector<Customer *> const &customers, CustomerOrder const *order) override;
+
+private:
+    void render(std::vector<Customer *> const &customers);
 };
 
 //Specification Design Pattern for filtering
 //Each speficification class will check if user satisfies a credential for filtering
 struct FilterSpecification {
     virtual bool is_satisfied(Customer const *customer) const = 0;
+
+    //Get the satisfying customers through an index of the repository
+    //Return false if no index can answer, the customers then have to be checked one by one
+    virtual bool lookup(CustomerRepository &repository, std::vector<Customer *> &customers) const { return false; }
+
+    //Planner hook: get the specification whose lookup gives the fewest candidates among which
+    //are all the customers satisfying this one, and set its estimated number of candidates
+    //Return nullptr if no index can be used, the customers then have to be scanned
+    virtual FilterSpecification const *plan(CustomerRepository &repository, std::size_t &estimate) const {
+        return nullptr;
+    }
+
+    //Name of the index used by lookup, reported in the query plans
+    virtual char const *index_name() const { return "none"; }
+
+    //Get the bitmap of the satisfying customers from the bitmap index of the repository
+    //Return false if the bitmap index can not answer the specification
+    virtual bool bitmap(CustomerRepository &repository, Bitmap &bits) const { return false; }
+};
+
+//Specifications which can be answered by the bitmap index
+//The planner uses their bitmap as index, its number of set bits is the estimate
+struct BitmapFilterSpecification : public FilterSpecification {
+    bool lookup(CustomerRepository &repository, std::vector<Customer *> &customers) const override;
+
+    FilterSpecification const *plan(CustomerRepository &repository, std::size_t &estimate) const override;
+
+    char const *index_name() const override { return "bitmap index"; }
 };
 
 //Filter customer based on their id
@@ -177,6 +513,12 @@ struct IdFilterSpecification : public FilterSpecification {
     IdFilterSpecification(std::string const &id);
 
     bool is_satisfied(Customer const *customer) const override;
+
+    bool lookup(CustomerRepository &repository, std::vector<Customer *> &customers) const override;
+
+    FilterSpecification const *plan(CustomerRepository &repository, std::size_t &estimate) const override;
+
+    char const *index_name() const override { return "id trigram index"; }
 };
 
 //Filter the customer based on their name
@@ -186,40 +528,117 @@ struct NameFilterSpecification : public FilterSpecification {
     NameFilterSpecification(std::string const &name);
 
     bool is_satisfied(Customer const *customer) const override;
+
+    bool lookup(CustomerRepository &repository, std::vector<Customer *> &customers) const override;
+
+    FilterSpecification const *plan(CustomerRepository &repository, std::size_t &estimate) const override;
+
+    char const *index_name() const override { return "name trigram index"; }
 };
 
 //Filter the customer based on their state
-struct StateFilterSpecification : public FilterSpecification {
+struct StateFilterSpecification : public BitmapFilterSpecification {
     Category state;
 
     StateFilterSpecification(Category state);
 
     bool is_satisfied(Customer const *customer) const override;
+
+    bool bitmap(CustomerRepository &repository, Bitmap &bits) const override;
 };
 
 //Filter base on no conditions -> Every customer is satisfied
-struct AllFilterSpecification : public FilterSpecification {
+struct AllFilterSpecification : public BitmapFilterSpecification {
     AllFilterSpecification() = default;
 
     bool is_satisfied(Customer const *customer) const override;
+
+    bool bitmap(CustomerRepository &repository, Bitmap &bits) const override;
+};
+
+//Combinators: combine specifications into one
+//They do not own the specifications they combine
+//Every specification is satisfied -> the planner uses the most selective index among them,
+//or the intersection of the bitmaps of the specifications the bitmap index can answer
+struct AndFilterSpecification : public FilterSpecification {
+    std::vector<FilterSpecification const *> specifications;
+
+    AndFilterSpecification(std::vector<FilterSpecification const *> specifications);
+
+    bool is_satisfied(Customer const *customer) const override;
+
+    bool lookup(CustomerRepository &repository, std::vector<Customer *> &customers) const override;
+
+    FilterSpecification const *plan(CustomerRepository &repository, std::size_t &estimate) const override;
+
+    char const *index_name() const override { return "bitmap index"; }
+
+    bool bitmap(CustomerRepository &repository, Bitmap &bits) const override;
+
+private:
+    //Intersect the bitmaps of the specifications the bitmap index can answer
+    //The specifications it can not answer are appended to remaining
+    //Return the number of such specifications
+    std::size_t intersect_bitmaps(CustomerRepository &repository, Bitmap &bits,
+                                  std::vector<FilterSpecification const *> *remaining) const;
+};
+
+//At least one specification is satisfied
+struct OrFilterSpecification : public BitmapFilterSpecification {
+    std::vector<FilterSpecification const *> specifications;
+
+    OrFilterSpecification(std::vector<FilterSpecification const *> specifications);
+
+    bool is_satisfied(Customer const *customer) const override;
+
+    bool bitmap(CustomerRepository &repository, Bitmap &bits) const override;
+};
+
+//The specification is not satisfied
+struct NotFilterSpecification : public BitmapFilterSpecification {
+    FilterSpecification const *specification;
+
+    NotFilterSpecification(FilterSpecification const *specification);
+
+    bool is_satisfied(Customer const *customer) const override;
+
+    bool bitmap(CustomerRepository &repository, Bitmap &bits) const override;
 };
 
 //This class uses a spefication class (IdSpec, NameSpec or all Spec)
 //to filter the list of customer and include only those who satistfies the spec
 struct CustomerFilterer {
     std::vector<Customer *> filter(std::vector<Customer *> const &customers, FilterSpecification const *);
+
+    //Plan the filter on a repository: get the candidates from the most selective index
+    //the specification can use and check the specification on them only, or scan the
+    //customers when there is no such index. The plan is written into plan
+    std::vector<Customer *> filter(CustomerRepository &repository, FilterSpecification const *, QueryPlan &plan);
 };
 
 //Aggregated class
 //Each attributes: repo, displayer, filterer and persistence
 //can be switched out and replaced by another implementation
 //to satisfy the Open-Closed principle
+class Journal;
+
 class CustomerService {
     CustomerRepository *repository;
     CustomerDisplayer *displayer;
     CustomerFilterer *filterer;
     CustomerPersistence *persistence;
 
+    //Journal the changes are written to, if any
+    Journal *journal = nullptr;
+
+    //Version of the repository the data file holds, as of the last load, save or checkpoint
+    std::uint64_t saved_version = 0;
+
+    //Plan of the last filter, for profiling
+    QueryPlan last_plan;
+    //Print the plan of every filter
+    bool profiling = false;
+
 public:
     //Destruct and construct
     CustomerService(CustomerRepository *repo, CustomerDisplayer *display, CustomerFilterer *filterer,
@@ -229,12 +648,36 @@ public:
 
     //Customer Service mainly calls
     //methods of its attributes to perform CRUD operations
-    void load(std::vector<Item *>);
+    void load(std::vector<Item *> const &);
+
+    //Save the customers, unless they did not change since they were loaded or saved
     void save();
+
+    //Render the data file without writing it, for a checkpoint of the journal
+    PendingFile render(std::vector<Item *> const &items);
+
+    inline void set_journal(Journal *new_journal) { journal = new_journal; }
+
     Customer *get(std::string const &id);
     void add(Customer *customer);
     void remove(std::string const &id);
     void update(std::string const &id, ModificationIntent &intent);
+
+    //A customer borrowing or returning an item, return false if nothing changed
+    bool borrow(Customer *customer, Item *item);
+    bool return_item(Customer *customer, Item *item);
     void display(CustomerOrder const *order);
+
+    //Get the page of page_size customers after the cursor (forward) or before it, the first page without cursor
+    CustomerPage page(CustomerOrder const *order, CustomerCursor const *cursor, bool forward, std::size_t page_size);
+    void display_page(CustomerPage const &page);
+
     void filter(FilterSpecification const *spec);
+
+    //Count the customers satisfying a specification, with popcounts when the bitmap index can answer it
+    std::size_t count(FilterSpecification const *spec);
+
+    inline QueryPlan const &get_last_plan() const { return last_plan; }
+
+    inline void set_profiling(bool enabled) { profiling = enabled; }
 };
\ No newline at end of file
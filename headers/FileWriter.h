@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+	This component contains the writing of whole data files.
+	A file is written next to the one it replaces, synced to the disk and
+	renamed over it, then its directory is synced so the rename itself is
+	durable: a reader (or the next start after a crash or a full disk) sees
+	either the old file or the new one, never a file cut in the middle.
+	Files replaced together go through one batch, which waits for the disk
+	once for all of them instead of once per file
+*/
+
+//A file rendered in memory, to be written later (possibly on another thread)
+struct PendingFile {
+    std::string path;
+    std::string contents;
+};
+
+//Files replaced together: each one is written to a temporary file when added,
+//commit() syncs them all, renames them over their paths and syncs each directory once
+//Files not committed are discarded with the batch
+class FileBatch {
+    struct StagedFile {
+        std::string path;
+        std::string temporary;
+        int descriptor;
+    };
+    std::vector<StagedFile> files;
+
+public:
+    //Size of the writes the contents are split into
+    static const std::size_t write_chunk_size = 1024 * 1024;
+
+    FileBatch() = default;
+    ~FileBatch();
+
+    FileBatch(FileBatch const &) = delete;
+    FileBatch &operator=(FileBatch const &) = delete;
+
+    //Write the contents of a file, return false if it can not be written
+    bool add(std::string const &path, std::string_view contents);
+    inline bool add(PendingFile const &file) { return add(file.path, file.contents); }
+
+    //Replace the files written, return false if one of them could not be replaced
+    //(the files before it are replaced, the ones after it are discarded)
+    bool commit();
+
+private:
+    void discard();
+};
+
+//Write all the contents to a file descriptor, in chunks, retrying the writes cut short
+//Return false if a write fails
+bool write_all(int descriptor, std::string_view contents);
+
+//Replace a file with the given contents, return false if it can not be written
+bool replace_file(std::string const &path, std::string_view contents);
+
+//Sync a file or a directory to the disk, return false if it can not be synced
+bool sync_path(std::string const &path, bool directory);
@@ -0,0 +1,165 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/*
+	This component contains an id-keyed hash index used by the repositories
+	to find a record in constant time instead of scanning the whole vector.
+	It uses open addressing (linear probing) over one flat array of slots,
+	so inserting a key never allocates a node, and deletes use backward
+	shifting so no tombstones are ever left behind
+*/
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class HashIndex {
+    //A slot holds the key, its value and whether it is in use
+    struct Slot {
+        Key key{};
+        Value value{};
+        bool occupied = false;
+    };
+
+    std::vector<Slot> slots;
+    std::size_t count = 0;
+    Hash hasher;
+
+    //Capacity is always a power of two so the probe can use a mask
+    inline std::size_t mask() const { return slots.size() - 1; }
+    inline std::size_t home_of(Key const &key) const { return hasher(key) & mask(); }
+
+    //Grow when the table becomes more than 70% full
+    void grow_if_needed() {
+        if (slots.empty()) {
+            rehash(16);
+        } else if ((count + 1) * 10 > slots.size() * 7) {
+            rehash(slots.size() * 2);
+        }
+    }
+
+    void rehash(std::size_t new_capacity) {
+        std::vector<Slot> old_slots(new_capacity);
+        //Swap so that slots is the new empty table and old_slots holds the keys
+        old_slots.swap(slots);
+        count = 0;
+        for (auto &slot : old_slots) {
+            if (slot.occupied) {
+                insert(std::move(slot.key), std::move(slot.value));
+            }
+        }
+    }
+
+public:
+    HashIndex() = default;
+
+    //Get the number of keys in the index
+    inline std::size_t size() const { return count; }
+    inline bool empty() const { return count == 0; }
+
+    //Make room for at least n keys without rehashing
+    void reserve(std::size_t n) {
+        std::size_t capacity = 16;
+        while (capacity * 7 < n * 10) {
+            capacity *= 2;
+        }
+        if (capacity > slots.size()) {
+            rehash(capacity);
+        }
+    }
+
+    //Remove every key but keep the allocated slots
+    void clear() {
+        for (auto &slot : slots) {
+            slot = Slot{};
+        }
+        count = 0;
+    }
+
+    //Insert a key, return false if the key is already in the index
+    bool insert(Key key, Value value) {
+        grow_if_needed();
+        std::size_t position = home_of(key);
+        while (slots[position].occupied) {
+            if (slots[position].key == key) {
+                return false;
+            }
+            position = (position + 1) & mask();
+        }
+        slots[position].key = std::move(key);
+        slots[position].value = std::move(value);
+        slots[position].occupied = true;
+        count++;
+        return true;
+    }
+
+    //Insert a key or overwrite the value of an existing one
+    void insert_or_assign(Key const &key, Value value) {
+        Value *existing = find(key);
+        if (existing != nullptr) {
+            *existing = std::move(value);
+        } else {
+            insert(key, std::move(value));
+        }
+    }
+
+    //Find the value of a key, nullptr if the key does not exist
+    Value *find(Key const &key) {
+        if (count == 0) {
+            return nullptr;
+        }
+        std::size_t position = home_of(key);
+        while (slots[position].occupied) {
+            if (slots[position].key == key) {
+                return &slots[position].value;
+            }
+            position = (position + 1) & mask();
+        }
+        return nullptr;
+    }
+
+    Value const *find(Key const &key) const {
+        return const_cast<HashIndex *>(this)->find(key);
+    }
+
+    inline bool contains(Key const &key) const { return find(key) != nullptr; }
+
+    //Call a function with every key and its value, in no particular order
+    template<typename Function>
+    void for_each(Function function) const {
+        for (auto const &slot : slots) {
+            if (slot.occupied) {
+                function(slot.key, slot.value);
+            }
+        }
+    }
+
+    //Remove a key, return false if the key does not exist
+    bool erase(Key const &key) {
+        if (count == 0) {
+            return false;
+        }
+        std::size_t position = home_of(key);
+        while (slots[position].occupied && !(slots[position].key == key)) {
+            position = (position + 1) & mask();
+        }
+        if (!slots[position].occupied) {
+            return false;
+        }
+
+        //Backward shift: move every following key of the probe chain
+        //that may live in the freed slot back into it
+        std::size_t hole = position;
+        std::size_t next = (hole + 1) & mask();
+        while (slots[next].occupied) {
+            std::size_t home = home_of(slots[next].key);
+            if (((next - home) & mask()) >= ((next - hole) & mask())) {
+                slots[hole] = std::move(slots[next]);
+                hole = next;
+            }
+            next = (next + 1) & mask();
+        }
+        slots[hole] = Slot{};
+        count--;
+        return true;
+    }
+};
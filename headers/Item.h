@@ -1,5 +1,10 @@
 #pragma once
 #include <string>
+#include <string_view>
+#include "PackedId.h"
+#include "StringPool.h"
+#include "HashIndex.h"
+#include "OutputBuffer.h"
 
 /*
 	This component contains the logic for items and
@@ -10,21 +15,41 @@
 //Item type to differentiate between types of items
 enum ItemType { GAME = 0, VIDEO, DISC };
 
+struct Item;
+
+//Observer design pattern
+//A repository that keeps its own copy of item data (e.g. columns or indexes)
+//observes its items, so changes made outside of the repository
+//(a customer borrowing or returning an item) are seen as well
+//The stock the item had before the change is given to the observers keeping the
+//items in stock order, since they can only find the item by the stock it was sorted by
+struct ItemObserver {
+    virtual void item_changed(Item const* item, unsigned int old_stock) = 0;
+};
+
 struct Item {
 	//Attributes
-	std::string id;
-	std::string title;
+	ItemId id;
+	InternedString title;
 	enum class RentalType { TwoDay, OneWeek } rental_type;
 	unsigned int number_in_stock;
 	float rental_fee;
 	enum class RentalStatus { Available, Borrowed } rental_status;
 
-	//Constructor
-	Item(std::string id, std::string title, RentalType rental_type, unsigned int stock, float fee, RentalStatus status);
+	//Observer notified after every change, set by the repository holding the item
+	ItemObserver* observer = nullptr;
+
+	//Constructor, throws std::invalid_argument if the id is not in the Ixxx-yyyy format
+	Item(std::string_view id, std::string_view title, RentalType rental_type, unsigned int stock, float fee, RentalStatus status);
+	//Constructor from an already packed id
+	Item(ItemId id, std::string_view title, RentalType rental_type, unsigned int stock, float fee, RentalStatus status);
+	//Items created outside of the arena are deleted through Item*
+	virtual ~Item() = default;
 
 	//Getter methods for attributes
-    inline std::string get_id() const { return id; }
-	inline std::string get_title() const { return title; }
+    inline std::string get_id() const { return decode_item_id(id); }
+    inline ItemId get_key() const { return id; }
+	inline std::string_view get_title() const { return string_pool().view(title); }
 	inline RentalType get_rental_type() const { return rental_type; }
 	inline unsigned int get_number_in_stock() const { return number_in_stock; }
     inline float get_rental_fee() const { return rental_fee; }
@@ -32,15 +57,19 @@ struct Item {
     virtual ItemType get_type() const = 0;
 
     //Setter methods for attributes
-	inline void set_title(std::string const& new_title) { title = new_title; }
-	inline void set_rental_type(RentalType const new_rental_type) { rental_type = new_rental_type; }
-	inline void set_num_in_stock(unsigned int const new_num_in_stock) { number_in_stock = new_num_in_stock; }
-    inline void set_rental_fee(float fee) { rental_fee = fee ; }
-    inline void set_rental_status(RentalStatus new_rental_status) { rental_status = new_rental_status ; }
+	inline void set_title(std::string_view new_title) { title = string_pool().intern(new_title); notify(); }
+	inline void set_rental_type(RentalType const new_rental_type) { rental_type = new_rental_type; notify(); }
+	inline void set_num_in_stock(unsigned int const new_num_in_stock) { unsigned int old_stock = number_in_stock; number_in_stock = new_num_in_stock; notify(old_stock); }
+    inline void set_rental_fee(float fee) { rental_fee = fee ; notify(); }
+    inline void set_rental_status(RentalStatus new_rental_status) { rental_status = new_rental_status ; notify(); }
 
     //Methods to increase or decrease number of stocks
-    inline void increase_num_in_stock(unsigned int value) { number_in_stock += value ; }
-    inline void decrease_num_in_stock(unsigned int value) { number_in_stock -=(number_in_stock > value) ? value : number_in_stock; }
+    inline void increase_num_in_stock(unsigned int value) { unsigned int old_stock = number_in_stock; number_in_stock += value ; notify(old_stock); }
+    inline void decrease_num_in_stock(unsigned int value) { unsigned int old_stock = number_in_stock; number_in_stock -=(number_in_stock > value) ? value : number_in_stock; notify(old_stock); }
+
+    //Tell the observer (if any) that the item has changed, and the stock it had before
+    inline void notify(unsigned int old_stock) const { if (observer != nullptr) observer->item_changed(this, old_stock); }
+    inline void notify() const { notify(number_in_stock); }
 
     //Check if item is available and in stock
 	inline bool is_available() const { return rental_status == RentalStatus::Available; }
@@ -49,11 +78,23 @@ struct Item {
 	//Print item to sstream
 	friend std::ostream& operator<<(std::ostream& os, Item const& item);
 
+	//Append the console representation to an output buffer, without temporaries
+	virtual void render_console(OutputBuffer& out) const = 0;
+
+	//Append the fields shared by every item, used by render_console
+	void render_console_fields(OutputBuffer& out) const;
+
 	//To string for printing to console
-	virtual std::string to_string_console() const = 0;
+	std::string to_string_console() const;
+
+	//Append the file representation to an output buffer, without temporaries
+	virtual void render_file(OutputBuffer& out) const = 0;
+
+	//Append the fields shared by every item, used by render_file
+	void render_file_fields(OutputBuffer& out, std::string_view type) const;
 
 	//To string for print to file
-	virtual std::string to_string_file() const = 0;
+	std::string to_string_file() const;
 };
 
 //Genre Items are items which genre
@@ -63,20 +104,21 @@ struct GenredItem : public Item {
 	enum class Genre { Action, Horror, Drama, Comedy } genre;
 
 	//Constructor
-	GenredItem(std::string id, std::string title, RentalType rental_type, unsigned int stock, float fee, RentalStatus status, Genre genre);
+	GenredItem(std::string_view id, std::string_view title, RentalType rental_type, unsigned int stock, float fee, RentalStatus status, Genre genre);
+	GenredItem(ItemId id, std::string_view title, RentalType rental_type, unsigned int stock, float fee, RentalStatus status, Genre genre);
 
 	//Setter and getter for genre
     inline Genre get_genre() const { return genre; }
-    inline void set_genre(Genre const new_genre) { genre = new_genre; }
+    inline void set_genre(Genre const new_genre) { genre = new_genre; notify(); }
 
     //User for printing genreditem
 	friend std::ostream& operator<<(std::ostream& os, GenredItem const& genredItem);
 
-    //Genred Item to string (for console display)
-	std::string to_string_console() const override;
+    //Append the fields shared by every genred item, used by render_console
+	void render_console_fields(OutputBuffer& out) const;
 
-    //Genred Item to string (for writing to file)
-	std::string to_string_file() const override = 0;
+    //Append the fields shared by every genred item, used by render_file
+	void render_file_fields(OutputBuffer& out, std::string_view type) const;
 };
 
 //Game is a child of item
@@ -87,11 +129,11 @@ struct Game : public Item {
     //Use for printing game
 	friend std::ostream& operator<<(std::ostream& os, Game const& game);
 
-    //Genred Item to string (for console display)
-	std::string to_string_console() const override;
+    //Game for console display
+	void render_console(OutputBuffer& out) const override;
 
-    //Genred Item to string (for writing to file)
-	std::string to_string_file() const override;
+    //Game for writing to file
+	void render_file(OutputBuffer& out) const override;
 
 	//Get type of item as enum
     ItemType get_type() const override;
@@ -105,11 +147,11 @@ struct VideoRecord : public GenredItem {
     //Use for printing Video Record
 	friend std::ostream& operator<<(std::ostream& os, VideoRecord const& videoRecord);
 
-    //Video to string (for console display)
-	std::string to_string_console() const override;
+    //Video for console display
+	void render_console(OutputBuffer& out) const override;
 
-    //Video to string (for writing to file)
-    std::string to_string_file() const override;
+    //Video for writing to file
+    void render_file(OutputBuffer& out) const override;
 
     //Get type as enum
     ItemType get_type() const override;
@@ -123,13 +165,15 @@ struct DVD : public GenredItem {
     //Use for printing DVD
 	friend std::ostream& operator<<(std::ostream& os, DVD const& dvd);
 
-    //DVD to string (for console display)
-	std::string to_string_console() const override;
+    //DVD for console display
+	void render_console(OutputBuffer& out) const override;
 
-    //DVD to string (for writing to file)
-    std::string to_string_file() const override;
+    //DVD for writing to file
+    void render_file(OutputBuffer& out) const override;
 
     //Get type as enum
     ItemType get_type() const override;
 };
 
+//Index from packed item id to item
+typedef HashIndex<ItemId, Item*> ItemIndex;
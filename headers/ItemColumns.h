@@ -0,0 +1,49 @@
+#pragma once
+#include "Item.h"
+#include "StringPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/*
+	This component contains a read-only view over item data stored
+	column by column (structure of arrays): every hot field of the items
+	is kept in its own contiguous array, indexed by row, and the titles are kept
+	as handles into the string pool. Filters and aggregations written against
+	this view are plain loops over arrays instead of pointer and vtable chasing
+*/
+
+//Genre column value for items without a genre (games)
+const std::uint8_t NO_GENRE = 0xFF;
+
+struct ItemColumnView {
+    std::size_t size = 0;
+
+    //Hot columns
+    ItemId const* ids = nullptr;
+    unsigned int const* stocks = nullptr;
+    float const* fees = nullptr;
+    std::uint8_t const* statuses = nullptr;
+    std::uint8_t const* rental_types = nullptr;
+    std::uint8_t const* genres = nullptr;
+    std::uint8_t const* types = nullptr;
+
+    //Titles, as handles into the string pool
+    InternedString const* titles = nullptr;
+
+    //Cold column: the item objects themselves
+    Item* const* items = nullptr;
+
+    //Get the title of a row
+    inline std::string_view title(std::size_t row) const { return string_pool().view(titles[row]); }
+
+    //Selections: append the rows satisfying the condition to rows
+    void select_stock_equal(unsigned int stock, std::vector<std::uint32_t> &rows) const;
+    void select_all(std::vector<std::uint32_t> &rows) const;
+
+    //Aggregations
+    unsigned long long total_stock() const;
+    std::size_t count_in_stock() const;
+    std::size_t count_available() const;
+};
@@ -3,49 +3,71 @@
 #include "Item.h"
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
-Item::RentalType string_to_rental_type(const std::string &string_rental_type);
+Item::RentalType string_to_rental_type(std::string_view string_rental_type);
 
-std::string rental_type_to_string(Item::RentalType rental_type);
+char const *rental_type_to_string(Item::RentalType rental_type);
 
 Item::RentalStatus string_to_rental_status(const std::string &string_rental_status);
 
 std::string rental_status_to_string(Item::RentalStatus rental_status);
 
-GenredItem::Genre string_to_genre(const std::string &string_genre);
+GenredItem::Genre string_to_genre(std::string_view string_genre);
 
-std::string genre_to_string(GenredItem::Genre genre);
+char const *genre_to_string(GenredItem::Genre genre);
 
 void remove_carriage_return(std::string &string);
 
-bool correct_info_length(const std::string &line);
+bool correct_info_length(std::string_view line);
 
-bool item_id_is_valid(const std::string &id, const std::vector<Item *> &mockItems = {}, bool format_only = true);
+//The validators report what is wrong with a value to the log, the console by default
+bool item_id_is_valid(std::string_view id, const ItemIndex &loaded_items = {}, bool format_only = true,
+                      std::ostream &log = std::cout);
 
 bool item_type_and_genre_is_valid(
-        const std::string &type,
-        const std::string &genre,
-        std::vector<std::string>::size_type item_info_length
+        std::string_view type,
+        std::string_view genre,
+        std::size_t item_info_length,
+        std::ostream &log = std::cout
 );
 
-bool item_loan_type_is_valid(const std::string &loan_type);
+bool item_loan_type_is_valid(std::string_view loan_type, std::ostream &log = std::cout);
 
-bool item_stock_is_valid(const std::string &stock);
+bool item_stock_is_valid(std::string_view stock, std::ostream &log = std::cout);
 
-bool item_price_is_valid(const std::string &price);
+bool item_price_is_valid(std::string_view price, std::ostream &log = std::cout);
 
 bool valid_item_data(
-        const std::string &id,
-        const std::vector<Item *> &mockItems,
-        const std::string &type,
-        const std::string &genre,
-        std::vector<std::string>::size_type item_info_length,
-        const std::string &loan_type,
-        const std::string &stock,
-        const std::string &price
+        std::string_view id,
+        const ItemIndex &loaded_items,
+        std::string_view type,
+        std::string_view genre,
+        std::size_t item_info_length,
+        std::string_view loan_type,
+        std::string_view stock,
+        std::string_view price
 );
 
-Item * get_item_with_id(const std::vector<Item *> &items, const std::string &id);
+//Everything valid_item_data checks but the id
+bool valid_item_fields(
+        std::string_view type,
+        std::string_view genre,
+        std::size_t item_info_length,
+        std::string_view loan_type,
+        std::string_view stock,
+        std::string_view price,
+        std::ostream &log = std::cout
+);
+
+//Parse the stock and the price of a line, return false if they are not numbers
+//(the text is read up to the first character which does not belong to the number, like std::stoi)
+bool parse_item_stock(std::string_view stock, unsigned int &value);
+bool parse_item_price(std::string_view price, float &value);
+
+ItemIndex build_item_index(const std::vector<Item *> &items);
+
+Item * get_item_with_id(const ItemIndex &items, ItemId id);
 
-bool item_exists_with_id(std::vector<Item *> &items, const std::string &id);
\ No newline at end of file
+bool item_exists_with_id(const ItemIndex &items, ItemId id);
\ No newline at end of file
@@ -1,7 +1,20 @@
 #pragma once
 #include "Item.h"
 #include "StringHelper.h"
+#include "HashIndex.h"
+#include "ItemColumns.h"
+#include "Arena.h"
+#include "TrigramIndex.h"
+#include "OrderedIndex.h"
+#include "QueryPlan.h"
+#include "Bitmap.h"
+#include "Page.h"
+#include "FileWriter.h"
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <string>
+#include <string_view>
 #include <vector>
 
 /*
@@ -106,88 +119,361 @@ struct GenredItemGenreModificationIntent : public GenredItemModificationIntent {
     void modify() override;
 };
 
+//Strict orders on items, ties are broken by id
+//Used by the order classes and by the ordered indexes of the repositories
+struct ItemTitleLess {
+    bool operator()(Item const* a, Item const* b) const;
+};
+
+struct ItemIdLess {
+    bool operator()(Item const* a, Item const* b) const;
+};
+
+//Used by the stock and fee indexes, which also compare items with the bounds of range queries
+//Position of an item in the stock order by a stock it may no longer have
+struct ItemStockKey {
+    unsigned int stock;
+    ItemId key;
+};
+
+struct ItemStockLess {
+    bool operator()(Item const* a, Item const* b) const;
+    bool operator()(Item const* item, unsigned int stock) const;
+    bool operator()(unsigned int stock, Item const* item) const;
+    //The item with the key's id is at the key, whatever its stock is now
+    bool operator()(Item const* item, ItemStockKey key) const;
+};
+
+struct ItemFeeLess {
+    bool operator()(Item const* a, Item const* b) const;
+    bool operator()(Item const* item, float fee) const;
+    bool operator()(float fee, Item const* item) const;
+};
+
+//Attributes of the item bitmap index
+enum ItemAttribute { GENRE_ATTRIBUTE = 0, RENTAL_TYPE_ATTRIBUTE, RENTAL_STATUS_ATTRIBUTE, TYPE_ATTRIBUTE, IN_STOCK_ATTRIBUTE };
+
+//Value of the genre attribute for items without a genre (games)
+const std::uint8_t NO_GENRE_VALUE = 4;
+
+//Bitmap index over the genre, rental type, rental status, type of the items
+//and whether they are in stock
+struct ItemBitmapIndex : public BitmapIndex {
+    ItemBitmapIndex();
+
+    //Index an item or update its values
+    void set_item(Item const* item);
+};
+
 //A blue print of repository pattern
 //containing methods such as CRUD of customers
 struct ItemRepository {
+    virtual ~ItemRepository() = default;
     virtual void add_item(Item* item) = 0;
     virtual void remove_item(std::string const& item_id) = 0;
     virtual void update_item(std::string const& item_id, ItemModificationIntent& intent) = 0;
     virtual void update_genred_item(std::string const& item_id, GenredItemModificationIntent& intent) = 0;
     virtual Item* get_item(std::string const& id) = 0;
-    virtual std::vector<Item*> get_items() = 0;
+    virtual std::vector<Item*> const& get_items() = 0;
     virtual void set_items(std::vector<Item*> const&) = 0;
+
+    //Arena owning the items materialized by a load, released with the repository
+    virtual Arena& get_arena() = 0;
+
+    //Version of the items, bumped by every change (adding, removing, modifying, and
+    //the stock and status changes of borrowing and returning) but not by a load
+    //Compared with the version last saved to skip saving unchanged items
+    inline std::uint64_t get_version() const { return version; }
+    inline void mark_changed() { version++; }
+
+    //Repositories storing the items column by column expose them through a view
+    //Return false if the items are not stored as columns
+    virtual bool get_columns(ItemColumnView& view) { return false; }
+
+    //Substring search on the titles and ids through the trigram indexes of the repository
+    //The items found are appended in repository order, return false if there is no index
+    virtual bool search_titles(std::string_view query, std::vector<Item*>& found) { return false; }
+    virtual bool search_ids(std::string_view query, std::vector<Item*>& found) { return false; }
+
+    //Number of candidates a title or id search would check, return false if there is no index
+    virtual bool estimate_titles(std::string_view query, std::size_t& estimate) { return false; }
+    virtual bool estimate_ids(std::string_view query, std::size_t& estimate) { return false; }
+
+    //Items kept in title or id order by the repository, nullptr if it does not keep the order
+    virtual std::vector<Item*> const* get_items_by_title() { return nullptr; }
+    virtual std::vector<Item*> const* get_items_by_id() { return nullptr; }
+
+    //Items whose stock or fee is between two bounds (both included), through the ordered
+    //indexes of the repository, appended in repository order. Return false if there is no index
+    virtual bool range_stocks(unsigned int low, unsigned int high, std::vector<Item*>& found) { return false; }
+    virtual bool range_fees(float low, float high, std::vector<Item*>& found) { return false; }
+
+    //Number of items a stock or fee range would give, return false if there is no index
+    virtual bool estimate_stocks(unsigned int low, unsigned int high, std::size_t& estimate) { return false; }
+    virtual bool estimate_fees(float low, float high, std::size_t& estimate) { return false; }
+
+    //Bitmap index of the repository, nullptr if it does not keep one
+    virtual ItemBitmapIndex const* get_bitmap_index() { return nullptr; }
+    //Append the items of the set bits of a bitmap of the bitmap index, in repository order
+    virtual void collect_bitmap(Bitmap const& bits, std::vector<Item*>& found) {}
+
+protected:
+    std::uint64_t version = 0;
 };
 
 //Implementation of Repository pattern
 //Where all CRUD operation will be done using an in-memory vector
-struct InMemoryItemRepository : public ItemRepository {
+//The repository observes its items to keep the bitmap index up to date
+struct InMemoryItemRepository : public ItemRepository, public ItemObserver {
     std::vector<Item*> items;
-    unsigned int starting_index = 0;
+    //Hash index from packed item id to position in the vector, kept in sync by add, remove and set
+    HashIndex<ItemId, std::size_t> index;
+    //Trigram indexes over the titles and the text ids
+    TrigramIndex title_index;
+    TrigramIndex id_index;
+    //Ordered indexes for the title and id listings
+    OrderedIndex<Item, ItemTitleLess> by_title;
+    OrderedIndex<Item, ItemIdLess> by_id;
+    //Ordered indexes for the stock and fee ranges, kept up to date by update_item
+    //(and by item_changed for the stock, which borrowing and returning change)
+    OrderedIndex<Item, ItemStockLess> by_stock;
+    OrderedIndex<Item, ItemFeeLess> by_fee;
+    //Bitmap index over the low-cardinality attributes
+    ItemBitmapIndex bitmaps;
+    //Arena owning the loaded items
+    Arena arena;
 public:
     InMemoryItemRepository() = default;
     ~InMemoryItemRepository();
     InMemoryItemRepository(std::vector<Item*>  items);
-    unsigned int get_starting_index() { return starting_index; }
-    void increment_starting_index() { this->starting_index++; }
-    void decrement_starting_index() { this->starting_index--; }
-    std::vector<Item*> get_items() override { return items; }
+    std::vector<Item*> const& get_items() override { return items; }
     void set_items(std::vector<Item*> const& items) override;
+    Arena& get_arena() override { return arena; }
     void add_item(Item* item) override;
     void remove_item(std::string const& item_id) override;
     void update_item(std::string const& item_id, ItemModificationIntent& intent) override;
     void update_genred_item(std::string const& item_id, GenredItemModificationIntent& intent) override;
     Item* get_item(std::string const& id) override;
+    bool search_titles(std::string_view query, std::vector<Item*>& found) override;
+    bool search_ids(std::string_view query, std::vector<Item*>& found) override;
+    bool estimate_titles(std::string_view query, std::size_t& estimate) override {
+        estimate = title_index.estimate(query);
+        return true;
+    }
+    bool estimate_ids(std::string_view query, std::size_t& estimate) override {
+        estimate = id_index.estimate(query);
+        return true;
+    }
+    std::vector<Item*> const* get_items_by_title() override { return &by_title.get(); }
+    std::vector<Item*> const* get_items_by_id() override { return &by_id.get(); }
+    bool range_stocks(unsigned int low, unsigned int high, std::vector<Item*>& found) override;
+    bool range_fees(float low, float high, std::vector<Item*>& found) override;
+    bool estimate_stocks(unsigned int low, unsigned int high, std::size_t& estimate) override;
+    bool estimate_fees(float low, float high, std::size_t& estimate) override;
+    ItemBitmapIndex const* get_bitmap_index() override { return &bitmaps; }
+    void collect_bitmap(Bitmap const& bits, std::vector<Item*>& found) override;
+    void item_changed(Item const* item, unsigned int old_stock) override;
     int get_item_index(std::string const &item_id);
+    void rebuild_index();
+    void index_text(Item const* item);
+    void collect(std::vector<std::uint32_t> const& keys, std::vector<Item*>& found);
+    void collect_range(std::vector<Item*>::const_iterator first, std::vector<Item*>::const_iterator last,
+                       std::vector<Item*>& found);
+};
+
+//Implementation of Repository pattern
+//Where the hot fields of the items (packed id, stock, fee, status, rental type,
+//genre and item type) are kept in contiguous column arrays and the titles as
+//handles into the string pool, so that filters and aggregations are tight loops.
+//The item objects are still kept (row by row) for the operations which need them,
+//and the repository observes them to keep the columns up to date
+struct ColumnarItemRepository : public ItemRepository, public ItemObserver {
+    //Cold column: row -> item object
+    std::vector<Item*> items;
+
+    //Hot columns
+    std::vector<ItemId> ids;
+    std::vector<unsigned int> stocks;
+    std::vector<float> fees;
+    std::vector<std::uint8_t> statuses;
+    std::vector<std::uint8_t> rental_types;
+    std::vector<std::uint8_t> genres;
+    std::vector<std::uint8_t> types;
+
+    //Titles
+    std::vector<InternedString> titles;
+
+    //Hash index from packed item id to row
+    HashIndex<ItemId, std::uint32_t> rows;
+
+    //Trigram indexes over the titles and the text ids
+    TrigramIndex title_index;
+    TrigramIndex id_index;
+
+    //Ordered indexes for the title and id listings
+    OrderedIndex<Item, ItemTitleLess> by_title;
+    OrderedIndex<Item, ItemIdLess> by_id;
+
+    //Ordered indexes for the stock and fee ranges, kept up to date by update_item
+    //(and by item_changed for the stock, which borrowing and returning change)
+    OrderedIndex<Item, ItemStockLess> by_stock;
+    OrderedIndex<Item, ItemFeeLess> by_fee;
+
+    //Bitmap index over the low-cardinality attributes
+    ItemBitmapIndex bitmaps;
+
+    //Arena owning the loaded items
+    Arena arena;
+
+public:
+    ColumnarItemRepository() = default;
+    ~ColumnarItemRepository();
+    std::vector<Item*> const& get_items() override { return items; }
+    void set_items(std::vector<Item*> const& items) override;
+    Arena& get_arena() override { return arena; }
+    void add_item(Item* item) override;
+    void remove_item(std::string const& item_id) override;
+    void update_item(std::string const& item_id, ItemModificationIntent& intent) override;
+    void update_genred_item(std::string const& item_id, GenredItemModificationIntent& intent) override;
+    Item* get_item(std::string const& id) override;
+    bool get_columns(ItemColumnView& view) override;
+    bool search_titles(std::string_view query, std::vector<Item*>& found) override;
+    bool search_ids(std::string_view query, std::vector<Item*>& found) override;
+    bool estimate_titles(std::string_view query, std::size_t& estimate) override {
+        estimate = title_index.estimate(query);
+        return true;
+    }
+    bool estimate_ids(std::string_view query, std::size_t& estimate) override {
+        estimate = id_index.estimate(query);
+        return true;
+    }
+    std::vector<Item*> const* get_items_by_title() override { return &by_title.get(); }
+    std::vector<Item*> const* get_items_by_id() override { return &by_id.get(); }
+    bool range_stocks(unsigned int low, unsigned int high, std::vector<Item*>& found) override;
+    bool range_fees(float low, float high, std::vector<Item*>& found) override;
+    bool estimate_stocks(unsigned int low, unsigned int high, std::size_t& estimate) override;
+    bool estimate_fees(float low, float high, std::size_t& estimate) override;
+    ItemBitmapIndex const* get_bitmap_index() override { return &bitmaps; }
+    void collect_bitmap(Bitmap const& bits, std::vector<Item*>& found) override;
+    void item_changed(Item const* item, unsigned int old_stock) override;
+
+private:
+    bool append_item(Item* item);
+    void collect(std::vector<std::uint32_t> const& keys, std::vector<Item*>& found);
+    void collect_range(std::vector<Item*>::const_iterator first, std::vector<Item*>::const_iterator last,
+                       std::vector<Item*>& found);
+    int get_row(std::string const& item_id) const;
+    void append_row(Item* item);
+    void write_row(std::uint32_t row, Item const* item);
+    void move_row(std::uint32_t from, std::uint32_t to);
+    void pop_row();
 };
 
 //Blueprint for Item persistence
 //Containing two methods: load() for loading item data
 //save() for saving item data
+//The loaded items are created in the given arena
+//render() gives what save() writes without writing it, for the checkpoints of the journal
 struct ItemPersistence {
-    virtual std::vector<Item*> load() = 0;
-    virtual void save(std::vector<Item*>) = 0;
+    virtual ~ItemPersistence() = default;
+    virtual std::vector<Item*> load(Arena& arena) = 0;
+    virtual void save(std::vector<Item*> const&) = 0;
+    virtual PendingFile render(std::vector<Item*> const&) = 0;
 };
 
 //Implementation of ItemPersistence
 //This is responsible for loading and saving
 //customers from and to a text file
+//Large files are split into chunks of lines parsed, checked and turned into
+//items on worker threads (at most threads of them, 0 for one per core), then
+//the repeated ids are rejected and the log written in the order of the file
 struct TextFileItemPersistence : public ItemPersistence {
-    std::vector<Item*> load() override;
-    void save(std::vector<Item*>) override;
+    //Smallest chunk worth a thread of its own
+    static const std::size_t min_chunk_size = 256 * 1024;
+
+    unsigned int threads;
+
+    explicit TextFileItemPersistence(unsigned int threads = 0) : threads(threads) {}
+
+    std::vector<Item*> load(Arena& arena) override;
+    void save(std::vector<Item*> const&) override;
+    PendingFile render(std::vector<Item*> const&) override;
 };
 
+//Position of an item in a listing, kept by value so it stays valid when the item
+//is changed or removed: the next page starts after where the item was
+struct ItemCursor {
+    std::string title;
+    ItemId key;
+
+    ItemCursor() = default;
+    explicit ItemCursor(Item const* item);
+};
+
+//A page of an item listing
+using ItemPage = Page<Item, ItemCursor>;
+
 //Order classes
 //These classes are responsible for
 //Sorting an items list based on their attributes
 struct ItemOrder {
     virtual void order(std::vector<Item*>& items) const = 0;
+
+    //Pagination: strict total order of the listing, and position of an item
+    //relative to a cursor (negative before it, zero at it, positive after it)
+    virtual bool less(Item const* a, Item const* b) const = 0;
+    virtual int compare(Item const* item, ItemCursor const& cursor) const = 0;
+
+    //False if order() leaves the list as it is, so it does not need to be copied
+    virtual bool reorders() const { return true; }
+
+    //Get the items of a repository already kept in this order, nullptr if it does not keep it
+    virtual std::vector<Item*> const* ordered(ItemRepository& repository) const { return nullptr; }
 };
 
 //No order: This class will do nothing
+//The repository order has no position to resume from, so its pages follow the ids
 struct ItemNoOrder : public ItemOrder {
     void order(std::vector<Item*>& items) const override;
+    bool reorders() const override { return false; }
+    std::vector<Item*> const* ordered(ItemRepository& repository) const override;
+    bool less(Item const* a, Item const* b) const override;
+    int compare(Item const* item, ItemCursor const& cursor) const override;
 };
 
 //Order by name: This class will sort the items based on their titles
 struct ItemTitleOrder : public ItemOrder {
     void order(std::vector<Item*>& items) const override;
+    std::vector<Item*> const* ordered(ItemRepository& repository) const override;
+    bool less(Item const* a, Item const* b) const override;
+    int compare(Item const* item, ItemCursor const& cursor) const override;
 };
 
 //Order by id: This class will sort the items based on their ids
 struct ItemIdOrder : public ItemOrder {
     void order(std::vector<Item*>& items) const override;
+    std::vector<Item*> const* ordered(ItemRepository& repository) const override;
+    bool less(Item const* a, Item const* b) const override;
+    int compare(Item const* item, ItemCursor const& cursor) const override;
 };
 
 //Blueprint for CustomerDisplayer
 //Which is used to display customer through an interface
 struct ItemDisplayer {
-    virtual void display(std::vector<Item*> items, ItemOrder const* order) = 0;
+    virtual ~ItemDisplayer() = default;
+    virtual void display(std::vector<Item*> const& items, ItemOrder const* order) = 0;
 };
 
 //Implementation of ItemDisplayer
 //Responsible for displaying the items through the console
+//The items are rendered into one buffer kept between listings and written in large chunks
 struct ConsoleItemDisplayer : public ItemDisplayer {
-    void display(std::vector<Item*> items, ItemOrder const* order) override;
+    OutputBuffer out{std::cout};
+
+    void display(std::vector<Item*> const& items, ItemOrder const* order) override;
+
+private:
+    void render(std::vector<Item*> const& items);
 };
 
 
@@ -195,14 +481,71 @@ struct ConsoleItemDisplayer : public ItemDisplayer {
 //Each speficification class will check if an item satisfies a credential for filtering
 struct ItemFilterSpecification {
     virtual bool is_satisfied(Item const* item) const = 0;
+
+    //Append the rows of a column view satisfying the specification
+    //By default every row's item is checked with is_satisfied
+    virtual void select(ItemColumnView const& view, std::vector<std::uint32_t>& rows) const;
+
+    //Get the satisfying items through an index of the repository
+    //Return false if no index can answer, the items then have to be checked one by one
+    virtual bool lookup(ItemRepository& repository, std::vector<Item*>& items) const { return false; }
+
+    //Planner hook: get the specification whose lookup gives the fewest candidates among which
+    //are all the items satisfying this one, and set its estimated number of candidates
+    //Return nullptr if no index can be used, the items then have to be scanned
+    virtual ItemFilterSpecification const* plan(ItemRepository& repository, std::size_t& estimate) const { return nullptr; }
+
+    //Name of the index used by lookup, reported in the query plans
+    virtual char const* index_name() const { return "none"; }
+
+    //Get the bitmap of the satisfying items from the bitmap index of the repository
+    //Return false if the bitmap index can not answer the specification
+    virtual bool bitmap(ItemRepository& repository, Bitmap& bits) const { return false; }
+};
+
+//Specifications which can be answered by the bitmap index
+//The planner uses their bitmap as index, its number of set bits is the estimate
+struct ItemBitmapFilterSpecification : public ItemFilterSpecification {
+    bool lookup(ItemRepository& repository, std::vector<Item*>& items) const override;
+    ItemFilterSpecification const* plan(ItemRepository& repository, std::size_t& estimate) const override;
+    char const* index_name() const override { return "bitmap index"; }
 };
 
 //Filter item based on their number of stock
-struct ItemNumStockFilterSpecification : public ItemFilterSpecification {
+//Only the items out of stock can be answered by the bitmap index
+struct ItemNumStockFilterSpecification : public ItemBitmapFilterSpecification {
     int number_in_stock;
 
     ItemNumStockFilterSpecification(unsigned int const number_in_stock);
     bool is_satisfied(Item const* item) const override;
+    void select(ItemColumnView const& view, std::vector<std::uint32_t>& rows) const override;
+    bool bitmap(ItemRepository& repository, Bitmap& bits) const override;
+};
+
+//Filter item based on a range of number of stock (both bounds included), e.g. stock <= N
+struct ItemStockRangeFilterSpecification : public ItemFilterSpecification {
+    unsigned int low;
+    unsigned int high;
+
+    ItemStockRangeFilterSpecification(unsigned int low, unsigned int high);
+    bool is_satisfied(Item const* item) const override;
+    void select(ItemColumnView const& view, std::vector<std::uint32_t>& rows) const override;
+    bool lookup(ItemRepository& repository, std::vector<Item*>& items) const override;
+    ItemFilterSpecification const* plan(ItemRepository& repository, std::size_t& estimate) const override;
+    char const* index_name() const override { return "stock index"; }
+};
+
+//Filter item based on a range of rental fee (both bounds included)
+struct ItemFeeRangeFilterSpecification : public ItemFilterSpecification {
+    float low;
+    float high;
+
+    ItemFeeRangeFilterSpecification(float low, float high);
+    bool is_satisfied(Item const* item) const override;
+    void select(ItemColumnView const& view, std::vector<std::uint32_t>& rows) const override;
+    bool lookup(ItemRepository& repository, std::vector<Item*>& items) const override;
+    ItemFilterSpecification const* plan(ItemRepository& repository, std::size_t& estimate) const override;
+    char const* index_name() const override { return "fee index"; }
 };
 
 //Filter item based on their id
@@ -211,6 +554,9 @@ struct ItemIdFilterSpecification : public ItemFilterSpecification {
 
     ItemIdFilterSpecification(std::string);
     bool is_satisfied(Item const* item) const override;
+    bool lookup(ItemRepository& repository, std::vector<Item*>& items) const override;
+    ItemFilterSpecification const* plan(ItemRepository& repository, std::size_t& estimate) const override;
+    char const* index_name() const override { return "id trigram index"; }
 };
 
 //Filter item based on their title
@@ -219,30 +565,134 @@ struct ItemTitleFilterSpecification : public ItemFilterSpecification {
 
     ItemTitleFilterSpecification(std::string title);
     bool is_satisfied(Item const* item) const override;
+    void select(ItemColumnView const& view, std::vector<std::uint32_t>& rows) const override;
+    bool lookup(ItemRepository& repository, std::vector<Item*>& items) const override;
+    ItemFilterSpecification const* plan(ItemRepository& repository, std::size_t& estimate) const override;
+    char const* index_name() const override { return "title trigram index"; }
+};
+
+//Filter item based on their genre (games have no genre)
+struct ItemGenreFilterSpecification : public ItemBitmapFilterSpecification {
+    GenredItem::Genre genre;
+
+    ItemGenreFilterSpecification(GenredItem::Genre genre);
+    bool is_satisfied(Item const* item) const override;
+    void select(ItemColumnView const& view, std::vector<std::uint32_t>& rows) const override;
+    bool bitmap(ItemRepository& repository, Bitmap& bits) const override;
+};
+
+//Filter item based on their type (game, video record or DVD)
+struct ItemTypeFilterSpecification : public ItemBitmapFilterSpecification {
+    ItemType type;
+
+    ItemTypeFilterSpecification(ItemType type);
+    bool is_satisfied(Item const* item) const override;
+    void select(ItemColumnView const& view, std::vector<std::uint32_t>& rows) const override;
+    bool bitmap(ItemRepository& repository, Bitmap& bits) const override;
+};
+
+//Filter item based on their rental type
+struct ItemRentalTypeFilterSpecification : public ItemBitmapFilterSpecification {
+    Item::RentalType rental_type;
+
+    ItemRentalTypeFilterSpecification(Item::RentalType rental_type);
+    bool is_satisfied(Item const* item) const override;
+    bool bitmap(ItemRepository& repository, Bitmap& bits) const override;
+};
+
+//Filter item based on their rental status (available or borrowed)
+struct ItemRentalStatusFilterSpecification : public ItemBitmapFilterSpecification {
+    Item::RentalStatus rental_status;
+
+    ItemRentalStatusFilterSpecification(Item::RentalStatus rental_status);
+    bool is_satisfied(Item const* item) const override;
+    bool bitmap(ItemRepository& repository, Bitmap& bits) const override;
 };
 
 //Filter base on no conditions -> Every item is satisfied
-struct ItemAllFilterSpecification : public ItemFilterSpecification {
+struct ItemAllFilterSpecification : public ItemBitmapFilterSpecification {
     ItemAllFilterSpecification() = default;
     bool is_satisfied(Item const* item) const override;
+    void select(ItemColumnView const& view, std::vector<std::uint32_t>& rows) const override;
+    bool bitmap(ItemRepository& repository, Bitmap& bits) const override;
+};
+
+//Combinators: combine specifications into one
+//They do not own the specifications they combine
+//Every specification is satisfied -> the planner uses the most selective index among them,
+//or the intersection of the bitmaps of the specifications the bitmap index can answer
+struct ItemAndFilterSpecification : public ItemFilterSpecification {
+    std::vector<ItemFilterSpecification const*> specifications;
+
+    ItemAndFilterSpecification(std::vector<ItemFilterSpecification const*> specifications);
+    bool is_satisfied(Item const* item) const override;
+    void select(ItemColumnView const& view, std::vector<std::uint32_t>& rows) const override;
+    bool lookup(ItemRepository& repository, std::vector<Item*>& items) const override;
+    ItemFilterSpecification const* plan(ItemRepository& repository, std::size_t& estimate) const override;
+    char const* index_name() const override { return "bitmap index"; }
+    bool bitmap(ItemRepository& repository, Bitmap& bits) const override;
+
+private:
+    //Intersect the bitmaps of the specifications the bitmap index can answer
+    //Return the number of such specifications
+    //The specifications it can not answer are appended to remaining
+    std::size_t intersect_bitmaps(ItemRepository& repository, Bitmap& bits,
+                                  std::vector<ItemFilterSpecification const*>* remaining) const;
+};
+
+//At least one specification is satisfied
+struct ItemOrFilterSpecification : public ItemBitmapFilterSpecification {
+    std::vector<ItemFilterSpecification const*> specifications;
+
+    ItemOrFilterSpecification(std::vector<ItemFilterSpecification const*> specifications);
+    bool is_satisfied(Item const* item) const override;
+    bool bitmap(ItemRepository& repository, Bitmap& bits) const override;
+};
+
+//The specification is not satisfied
+struct ItemNotFilterSpecification : public ItemBitmapFilterSpecification {
+    ItemFilterSpecification const* specification;
+
+    ItemNotFilterSpecification(ItemFilterSpecification const* specification);
+    bool is_satisfied(Item const* item) const override;
+    bool bitmap(ItemRepository& repository, Bitmap& bits) const override;
 };
 
 //This class uses a spefication class (TitleSpec, StockSpec or all Spec)
 //to filter the list of items and include only those which satistfies the spec
 struct ItemFilterer {
     std::vector<Item*> filter(std::vector<Item*> const& items, ItemFilterSpecification const*);
+    std::vector<Item*> filter(ItemColumnView const& view, ItemFilterSpecification const*);
+
+    //Plan the filter on a repository: get the candidates from the most selective index
+    //the specification can use and check the specification on them only, or scan the
+    //items when there is no such index. The plan is written into plan
+    std::vector<Item*> filter(ItemRepository& repository, ItemFilterSpecification const*, QueryPlan& plan);
 };
 
 //Aggregated class
 //Each attributes: repo, displayer, filterer and persistence
 //can be switched out and replaced by another implementation
 //to satisfy the Open-Closed principle
+class Journal;
+
 class ItemService {
     ItemRepository* repository;
     ItemDisplayer* displayer;
     ItemFilterer* filterer;
     ItemPersistence* persistence;
 
+    //Journal the changes are written to, if any
+    Journal* journal = nullptr;
+
+    //Version of the repository the data file holds, as of the last load, save or checkpoint
+    std::uint64_t saved_version = 0;
+
+    //Plan of the last filter, for profiling
+    QueryPlan last_plan;
+    //Print the plan of every filter
+    bool profiling = false;
+
 public:
     //Destruct and construct
     ItemService(ItemRepository* repo, ItemDisplayer* display, ItemFilterer* filterer, ItemPersistence* persistence);
@@ -250,14 +700,25 @@ public:
 
     //Methods
     void load();
+    //Save the items, unless they did not change since they were loaded or saved
     void save();
+    //Render the data file without writing it, for a checkpoint of the journal
+    PendingFile render();
+    inline void set_journal(Journal* new_journal) { journal = new_journal; }
     Item* get(std::string const&);
     bool check_if_exists(std::string const&);
-    std::vector<Item*> get_all();
+    std::vector<Item*> const& get_all();
     void add(Item* item);
     void remove(std::string const& id);
     void update(std::string const& id, ItemModificationIntent& intent);
     void update_genre(std::string const& id, GenredItemModificationIntent& intent);
     void display(ItemOrder const* order);
+    //Get the page of page_size items after the cursor (forward) or before it, the first page without cursor
+    ItemPage page(ItemOrder const* order, ItemCursor const* cursor, bool forward, std::size_t page_size);
+    void display_page(ItemPage const& page);
     void filter(ItemFilterSpecification const* spec);
+    //Count the items satisfying a specification, with popcounts when the bitmap index can answer it
+    std::size_t count(ItemFilterSpecification const* spec);
+    inline QueryPlan const& get_last_plan() const { return last_plan; }
+    inline void set_profiling(bool enabled) { profiling = enabled; }
 };
\ No newline at end of file
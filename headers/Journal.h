@@ -0,0 +1,125 @@
+#pragma once
+#include "ItemRepository.h"
+#include "CustomerRepository.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+	This component contains the write-ahead journal of the items and customers.
+	Instead of rewriting the data files, every change made through the services
+	(adding, removing and modifying items and customers, borrowing and
+	returning) is appended to the journal as one compact record as soon as it
+	is made, so a session which ends without saving (or crashes) loses nothing.
+	On startup, the journals left next to the data files are replayed on top of
+	what was loaded from them.
+	A record holds the values of the record after the change, not the change
+	itself, so replaying a record twice gives the same result: this is what
+	lets a checkpoint fold the journal into new data files without having to
+	write both atomically.
+	A checkpoint starts a new journal file, renders the data files in memory,
+	then writes them and deletes the folded journal files on a background thread.
+	It runs once the journal files not folded yet, the ones replayed at startup
+	included, reach checkpoint_size: at startup, or when a record is written.
+	The rental status of the items is recorded, but only restored when the data
+	files store it (the snapshots do, items.txt does not), so a checkpoint to
+	items.txt does not lose a status the replay restored.
+	Records are framed by their size and a checksum, a record cut by a crash
+	ends the replay of its file.
+	The journal file is synced to the disk every sync_batch records (and when
+	it is closed or folded), so a burst of changes waits for the disk once.
+	A record which can not be written (full disk, I/O error) is cut off the
+	file and the journal is closed: the changes of the session are then saved
+	by writing the data files in full at exit (fold), which also drops the
+	journal files, since replaying them over newer data files would undo changes
+*/
+class Journal {
+public:
+    //Kinds of records
+    enum class Kind : std::uint8_t {
+        ItemPut = 1, ItemRemoved, CustomerPut, CustomerRemoved, Borrowed, Returned
+    };
+
+    //Journal files are journal.<generation>.log, next to the data files
+    static constexpr char const *directory = "../textfiles";
+
+    //Size of the journals from which they are folded into the data files
+    static const std::size_t default_checkpoint_size = 4 * 1024 * 1024;
+
+    //Number of records written between two syncs of the journal file, 1 syncs every record
+    static const std::size_t default_sync_batch = 8;
+
+private:
+    ItemService &item_service;
+    CustomerService &customer_service;
+    bool restore_rental_status;
+    std::size_t checkpoint_size;
+    std::size_t sync_batch;
+
+    //Size of the journal files replayed at startup and not folded yet
+    std::size_t replayed_size = 0;
+
+    //Current journal file, and the number of records written to it since it was last synced
+    int descriptor = -1;
+    std::uint64_t generation = 0;
+    std::size_t size = 0;
+    std::size_t unsynced = 0;
+
+    //Thread writing the last checkpoint
+    std::thread checkpoint_thread;
+
+    //Record being built
+    std::string record;
+
+public:
+    Journal(ItemService &item_service, CustomerService &customer_service, bool restore_rental_status = false,
+            std::size_t checkpoint_size = default_checkpoint_size, std::size_t sync_batch = default_sync_batch);
+    ~Journal();
+
+    Journal(Journal const &) = delete;
+    Journal &operator=(Journal const &) = delete;
+
+    //Replay the journals of the previous sessions, then start a new journal file
+    //(checkpointing first if they are too large)
+    void open();
+
+    //Wait for the checkpoint being written and close the journal file
+    void close();
+
+    inline bool is_open() const { return descriptor != -1; }
+
+    //Records of the changes, written once the change is made
+    void item_put(Item const *item);
+    void item_removed(ItemId id);
+    void customer_put(Customer const *customer);
+    void customer_removed(CustomerId id);
+    void borrowed(Customer const *customer, Item const *item);
+    void returned(Customer const *customer, Item const *item);
+
+    //Fold the journal into new data files, written on a background thread
+    void checkpoint();
+
+    //Write the data files in full now and drop every journal file, once the journal is closed
+    //(it could not be opened, or a write to it failed)
+    //Return false if the data files could not be written, the journal files are then kept
+    bool fold();
+
+private:
+    std::string file_name(std::uint64_t file_generation) const;
+    std::vector<std::uint64_t> list_generations() const;
+    bool open_file(std::uint64_t file_generation);
+    void sync();
+
+    //Replay the records of a journal file, return the number of records replayed
+    std::size_t replay(std::uint64_t file_generation);
+    void apply(Kind kind, std::string_view payload);
+
+    void begin(Kind kind);
+    void put_u32(std::uint32_t value);
+    void put_float(float value);
+    void put_string(std::string_view value);
+    void put_customer_rentals(Customer const *customer);
+    void end();
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/*
+	This component contains a read-only memory mapping of a whole file.
+	The loaders read their text files through it: the contents are one
+	string_view over the mapped pages, lines and fields are views into it,
+	and nothing is copied until a record is built from its fields.
+	The mapping lives as long as the object, so the views must not outlive it.
+	It uses mmap, like FileBatch and the journal use fsync: POSIX systems only
+*/
+class MappedFile {
+    char const* data = nullptr;
+    std::size_t size = 0;
+
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    //Map a file, return false if it can not be opened or mapped
+    bool open(std::string const& path);
+
+    //Unmap the file
+    void close();
+
+    inline std::string_view contents() const { return {data, size}; }
+};
+
+//Get the next line of a text (without its line break, and without the carriage return
+//of Windows line breaks) and move the text past it, return false when the text is empty
+bool next_line(std::string_view& text, std::string_view& line);
@@ -1,15 +1,29 @@
 #pragma once
 #include "ServiceBuilder.h"
+#include "Journal.h"
 #include "Customer.h"
 #include "Item.h"
 
+//How the menu stores its data, chosen by the options of the command line
+struct MenuOptions {
+    //The text files, or the binary snapshots
+    StorageFormat format = StorageFormat::Text;
+    //Read the customers on demand (only supported on the text files)
+    bool lazy_customers = false;
+    //Store the items column by column
+    bool columnar_items = false;
+    //Print how every filter was evaluated
+    bool profile = false;
+};
+
 
 class Menu {
     CustomerService* customer_service;
     ItemService* item_service;
+    Journal* journal;
 
 public:
-    Menu();
+    explicit Menu(MenuOptions const& options = MenuOptions());
     ~Menu();
     void start();
     static int process_input(const std::string& option);
@@ -20,4 +34,8 @@ public:
     void modify_customer(const std::string& id);
     void read_item(Item*& item);
     void modify_item(const std::string& id, ItemType type);
+    void browse_customers();
+    void browse_items();
+    static std::size_t read_page_size();
+    static int read_page_option(bool has_previous, bool has_next);
 };
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+/*
+	This component contains an ordered secondary index used by the repositories
+	to list their records in a given order without sorting them on every request.
+	The records are kept as a sorted vector of pointers: inserting or removing a
+	record is a binary search and a shift, and an ordered listing is a plain walk
+	over the vector.
+	Less must be a strict total order (ties broken by id) so every record has exactly
+	one position, and the fields it compares must not change while the record is in
+	the index: remove the record before changing them and insert it again after.
+	A record changed in place can still be removed with the key it was sorted by
+	before the change, when Less can compare the records with such a key.
+	Range queries are two binary searches: Less must then also compare a record with
+	a bound, in both directions
+*/
+template<typename T, typename Less>
+class OrderedIndex {
+    std::vector<T *> records;
+    Less less;
+
+public:
+    OrderedIndex() = default;
+
+    //Get the records in order
+    inline std::vector<T *> const &get() const { return records; }
+    inline std::size_t size() const { return records.size(); }
+
+    void clear() { records.clear(); }
+
+    //Replace every record, sorting them once
+    void assign(std::vector<T *> const &new_records) {
+        records = new_records;
+        std::sort(records.begin(), records.end(), less);
+    }
+
+    void insert(T *record) {
+        records.insert(std::upper_bound(records.begin(), records.end(), record, less), record);
+    }
+
+    //Get the records between two bounds (both included), in order
+    template<typename Bound>
+    std::pair<typename std::vector<T *>::const_iterator, typename std::vector<T *>::const_iterator>
+    range(Bound const &low, Bound const &high) const {
+        auto first = std::lower_bound(records.begin(), records.end(), low, less);
+        auto last = std::upper_bound(first, records.end(), high, less);
+        return {first, last};
+    }
+
+    //Remove a record, return false if it is not in the index
+    bool erase(T *record) {
+        auto position = std::lower_bound(records.begin(), records.end(), record, less);
+        if (position == records.end() || *position != record) {
+            return false;
+        }
+        records.erase(position);
+        return true;
+    }
+
+    //Remove a record whose fields changed while it was in the index, found with a binary
+    //search for the key it was sorted by before the change (Less must place the record
+    //itself at that key), return false if it is not in the index
+    template<typename Key>
+    bool erase_changed(Key const &old_key, T *record) {
+        auto position = std::lower_bound(records.begin(), records.end(), old_key, less);
+        if (position == records.end() || *position != record) {
+            return false;
+        }
+        records.erase(position);
+        return true;
+    }
+};
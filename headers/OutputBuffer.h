@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+/*
+	This component contains the output buffer the records are rendered into.
+	Records append their fields straight into one reusable buffer (numbers are
+	formatted in place, without streams or temporary strings), and the buffer
+	is written to its stream in large chunks instead of line by line.
+	It is used both for the console listings and for the text files
+	A buffer without a stream only accumulates, for the to_string methods
+*/
+class OutputBuffer {
+    std::string data;
+    std::ostream* sink = nullptr;
+    std::size_t chunk_size = 0;
+
+public:
+    //Chunk size a buffer with a stream writes at, the capacity it keeps between listings
+    static const std::size_t default_chunk_size = 64 * 1024;
+
+    OutputBuffer() = default;
+    explicit OutputBuffer(std::ostream& sink, std::size_t chunk_size = default_chunk_size);
+    ~OutputBuffer();
+
+    OutputBuffer(OutputBuffer const&) = delete;
+    OutputBuffer& operator=(OutputBuffer const&) = delete;
+
+    inline void append(std::string_view text) { data.append(text.data(), text.size()); }
+    inline void append(char c) { data.push_back(c); }
+    void append_unsigned(unsigned long long value);
+    void append_signed(long long value);
+
+    //Float formatted like an ostream with the default flags (shortest of fixed and
+    //scientific with 6 significant digits)
+    void append_general(float value);
+
+    //Float with a fixed number of decimals (at most 6), like printf("%.6f") and std::to_string
+    void append_fixed(float value, int decimals = 6);
+
+    //End of a record: write the buffer to the stream once it holds a chunk
+    inline void end_record() {
+        if (sink != nullptr && data.size() >= chunk_size) {
+            write();
+        }
+    }
+
+    //Write what is buffered and flush the stream
+    void flush();
+
+    //Get what is buffered
+    inline std::string_view view() const { return data; }
+    inline std::string str() const { return data; }
+
+    //Drop what is buffered, keeping the capacity
+    inline void clear() { data.clear(); }
+
+private:
+    void write();
+};
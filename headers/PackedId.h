@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+/*
+	This component contains the packed representation of item and customer ids.
+	Ids always follow a fixed format (Ixxx-yyyy for items and Cxxx for customers),
+	so they are stored, compared, hashed and sorted as a single integer and only
+	turned back into text when they are displayed or written to a file.
+	The packing keeps the order of the text ids: comparing two packed ids gives
+	the same result as comparing the two strings
+*/
+
+//Item id Ixxx-yyyy packed as xxx * 10000 + yyyy
+struct ItemId {
+    std::uint32_t value = 0;
+
+    ItemId() = default;
+    explicit ItemId(std::uint32_t value) : value(value) {}
+
+    //Number of characters of the text form
+    static const std::size_t length = 9;
+};
+
+//Customer id Cxxx packed as xxx
+struct CustomerId {
+    std::uint32_t value = 0;
+
+    CustomerId() = default;
+    explicit CustomerId(std::uint32_t value) : value(value) {}
+
+    //Number of characters of the text form
+    static const std::size_t length = 4;
+};
+
+//Encode a text id, return false if the text does not have the id format
+//(the range of the year is checked by item_id_is_valid, not here)
+bool encode_item_id(std::string_view id, ItemId &packed);
+bool encode_customer_id(std::string_view id, CustomerId &packed);
+
+//Write the text form of a packed id into out (which must hold ItemId::length
+//or CustomerId::length characters), no terminating null is written
+void write_item_id(ItemId id, char *out);
+void write_customer_id(CustomerId id, char *out);
+
+//Decode a packed id back into its text form
+std::string decode_item_id(ItemId id);
+std::string decode_customer_id(CustomerId id);
+
+//Print the text form of a packed id
+std::ostream &operator<<(std::ostream &os, ItemId id);
+std::ostream &operator<<(std::ostream &os, CustomerId id);
+
+//Comparisons are single integer compares
+inline bool operator==(ItemId a, ItemId b) { return a.value == b.value; }
+inline bool operator!=(ItemId a, ItemId b) { return a.value != b.value; }
+inline bool operator<(ItemId a, ItemId b) { return a.value < b.value; }
+inline bool operator==(CustomerId a, CustomerId b) { return a.value == b.value; }
+inline bool operator!=(CustomerId a, CustomerId b) { return a.value != b.value; }
+inline bool operator<(CustomerId a, CustomerId b) { return a.value < b.value; }
+
+//Mix the bits of a packed id so that consecutive ids spread over the whole
+//hash table (std::hash of an integer is the identity)
+inline std::size_t mix_packed_id(std::uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return (std::size_t) key;
+}
+
+namespace std {
+    template<>
+    struct hash<ItemId> {
+        std::size_t operator()(ItemId id) const { return mix_packed_id(id.value); }
+    };
+
+    template<>
+    struct hash<CustomerId> {
+        std::size_t operator()(CustomerId id) const { return mix_packed_id(id.value); }
+    };
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+/*
+	This component contains the keyset pagination shared by the item and
+	customer listings. A page remembers the positions of its first and last
+	records as cursors, which keep the sort fields of the records by value:
+	the next page starts after the last record shown even if that record was
+	changed or removed since, and records added or removed elsewhere do not
+	shift the pages.
+	When the repository keeps the listing in order, a page is a binary search
+	and a copy of the page; otherwise only the records of the page are sorted
+	out of the remaining ones (top-K with a partial sort), never the whole list.
+	Order must provide less(T const*, T const*), a strict total order, and
+	compare(T const*, Cursor const&), negative if the record comes before the
+	cursor, zero at it and positive after it
+*/
+template<typename T, typename Cursor>
+struct Page {
+    std::vector<T *> records;
+
+    //Positions of the first and last records, to get the previous and next pages
+    Cursor first;
+    Cursor last;
+
+    bool has_previous = false;
+    bool has_next = false;
+};
+
+//Get the page of at most page_size records after the cursor (forward) or before it
+//Without cursor, the first page (forward) or the last one
+//sorted tells whether the records are already in the order of the listing
+template<typename T, typename Cursor, typename Order>
+Page<T, Cursor> get_page(std::vector<T *> const &records, bool sorted, Order const &order,
+                         Cursor const *cursor, bool forward, std::size_t page_size) {
+    Page<T, Cursor> page;
+
+    if (sorted) {
+        auto begin = records.begin();
+        auto end = records.end();
+        auto first = begin;
+        auto last = end;
+        if (forward) {
+            if (cursor != nullptr) {
+                first = std::partition_point(begin, end, [&](T *record) { return order.compare(record, *cursor) <= 0; });
+            }
+            last = first + (std::ptrdiff_t) std::min(page_size, (std::size_t) (end - first));
+        } else {
+            if (cursor != nullptr) {
+                last = std::partition_point(begin, end, [&](T *record) { return order.compare(record, *cursor) < 0; });
+            }
+            first = last - (std::ptrdiff_t) std::min(page_size, (std::size_t) (last - begin));
+        }
+        page.records.assign(first, last);
+        page.has_previous = first != begin;
+        page.has_next = last != end;
+    } else {
+        //Keep the records on the requested side of the cursor, then sort only the page out of them
+        std::vector<T *> candidates;
+        for (auto record : records) {
+            if (cursor == nullptr || (forward ? order.compare(record, *cursor) > 0 : order.compare(record, *cursor) < 0)) {
+                candidates.push_back(record);
+            }
+        }
+
+        std::size_t count = std::min(page_size, candidates.size());
+        if (forward) {
+            std::partial_sort(candidates.begin(), candidates.begin() + (std::ptrdiff_t) count, candidates.end(),
+                              [&](T *a, T *b) { return order.less(a, b); });
+            page.records.assign(candidates.begin(), candidates.begin() + (std::ptrdiff_t) count);
+            page.has_previous = candidates.size() < records.size();
+            page.has_next = candidates.size() > count;
+        } else {
+            //The last records of the listing are the first ones in reverse order
+            std::partial_sort(candidates.begin(), candidates.begin() + (std::ptrdiff_t) count, candidates.end(),
+                              [&](T *a, T *b) { return order.less(b, a); });
+            page.records.assign(candidates.rbegin() + (std::ptrdiff_t) (candidates.size() - count), candidates.rend());
+            page.has_previous = candidates.size() > count;
+            page.has_next = candidates.size() < records.size();
+        }
+    }
+
+    //An empty page stays at the cursor, so the other direction still works
+    if (!page.records.empty()) {
+        page.first = Cursor(page.records.front());
+        page.last = Cursor(page.records.back());
+    } else if (cursor != nullptr) {
+        page.first = *cursor;
+        page.last = *cursor;
+    }
+    return page;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+/*
+	This component contains the report of how a filter was evaluated.
+	The filterers plan a filter by asking the specification for the most
+	selective index it can use; the remaining conditions are then only
+	checked on the candidates that index gives. The services keep the
+	plan of their last filter so it can be inspected when profiling
+*/
+struct QueryPlan {
+    //Index used to get the candidates, or the kind of scan when no index could be used
+    std::string access;
+
+    //Number of candidates the planner expected from the index
+    std::size_t estimate = 0;
+
+    //Number of records the conditions were checked on, and how many satisfied them
+    std::size_t candidates = 0;
+    std::size_t results = 0;
+};
+
+inline std::ostream &operator<<(std::ostream &os, QueryPlan const &plan) {
+    return os << "[PLAN] access: " << plan.access << ", estimate: " << plan.estimate
+              << ", candidates: " << plan.candidates << ", results: " << plan.results;
+}
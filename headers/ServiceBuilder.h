@@ -2,13 +2,29 @@
 #include "ItemRepository.h"
 #include "CustomerRepository.h"
 
+//Where the standard services load and save their data: the text files, or
+//the binary snapshots (which fall back to the text files when missing)
+enum class StorageFormat { Text, Snapshot };
+
 class ItemServiceBuilder {
 public:
     virtual ItemService* create() = 0;
 };
 
 class StandardItemServiceBuilder : ItemServiceBuilder {
+    StorageFormat format;
+
+public:
+    explicit StandardItemServiceBuilder(StorageFormat format = StorageFormat::Text) : format(format) {}
+    ItemService* create() override;
+};
+
+//Same as the standard builder but the items are stored column by column
+class ColumnarItemServiceBuilder : ItemServiceBuilder {
+    StorageFormat format;
+
 public:
+    explicit ColumnarItemServiceBuilder(StorageFormat format = StorageFormat::Text) : format(format) {}
     ItemService* create() override;
 };
 
@@ -18,6 +34,15 @@ public:
 };
 
 class StandardCustomerServiceBuilder : CustomerServiceBuilder {
+    StorageFormat format;
+
+public:
+    explicit StandardCustomerServiceBuilder(StorageFormat format = StorageFormat::Text) : format(format) {}
+    CustomerService* create() override;
+};
+
+//Same as the standard builder (on the text files) but the customers are read on demand
+class LazyCustomerServiceBuilder : CustomerServiceBuilder {
 public:
     CustomerService* create() override;
 };
@@ -0,0 +1,61 @@
+#pragma once
+#include "ItemRepository.h"
+#include "CustomerRepository.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+	This component contains the binary snapshots of the items and customers.
+	A snapshot is written as it is laid out in memory, so loading it is a
+	memory mapping and a pass over fixed-width records, without any parsing
+	or validation of text:
+	- a header with a magic, the format version, the number of records, the
+	  sizes of the sections and a checksum of everything after the header
+	- the fixed-width records (ids are stored packed, strings as an offset
+	  and a length in the string heap)
+	- the string heap
+	- for customers, the references to their rentals, already resolved to
+	  the position of the item in the item snapshot (with the item id, used
+	  when the items were not loaded from that snapshot)
+	Numbers are stored in the byte order of the machine writing them.
+	A missing, outdated or corrupted snapshot is never loaded: the text file
+	is loaded instead and the snapshot is written again from it
+*/
+
+//Write the snapshots, return false if the file can not be written
+bool write_item_snapshot(std::string const &path, std::vector<Item *> const &items);
+bool write_customer_snapshot(std::string const &path, std::vector<Customer *> const &customers,
+                             std::string const &item_path);
+
+//Read the snapshots into the arena, return false (and load nothing) if the file is missing or invalid
+bool read_item_snapshot(std::string const &path, Arena &arena, std::vector<Item *> &items);
+bool read_customer_snapshot(std::string const &path, std::vector<Item *> const &items, Arena &arena,
+                            std::vector<Customer *> &customers);
+
+//Convert the text files into snapshots and back, return false if a file can not be written
+bool convert_text_to_snapshots();
+bool convert_snapshots_to_text();
+
+//Implementation of ItemPersistence
+//This is responsible for loading and saving
+//items from and to a binary snapshot (items.txt when there is no snapshot yet)
+struct SnapshotItemPersistence : public ItemPersistence {
+    static constexpr char const *path = "../textfiles/items.bin";
+
+    std::vector<Item *> load(Arena &arena) override;
+    void save(std::vector<Item *> const &) override;
+    PendingFile render(std::vector<Item *> const &) override;
+};
+
+//Implementation of CustomerPersistence
+//This is responsible for loading and saving
+//customers from and to a binary snapshot (customers.txt when there is no snapshot yet)
+//The rentals are resolved against the item snapshot, so items are saved first
+struct SnapshotCustomerPersistence : public CustomerPersistence {
+    static constexpr char const *path = "../textfiles/customers.bin";
+
+    std::vector<Customer *> load(std::vector<Item *> const &, Arena &arena) override;
+    void save(std::vector<Customer *> const &) override;
+    PendingFile render(std::vector<Customer *> const &, std::vector<Item *> const &items) override;
+};
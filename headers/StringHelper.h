@@ -1,4 +1,9 @@
 #pragma once
 #include <string>
+#include <string_view>
 
-bool check_field_contains(std::string, std::string);
+//Fold an ASCII uppercase letter to lowercase, every other character is kept
+inline char fold_ascii(char c) { return (c >= 'A' && c <= 'Z') ? (char) (c | 0x20) : c; }
+
+//Check if the target contains the query, ignoring the ASCII case
+bool check_field_contains(std::string_view, std::string_view);
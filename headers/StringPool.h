@@ -0,0 +1,70 @@
+#pragma once
+#include "HashIndex.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+/*
+	This component contains the interning string pool used for item titles,
+	customer names and customer addresses. Every distinct value is stored once
+	and referred to by a small handle; the characters never move, so the views
+	handed out stay valid for the whole program and reading, comparing or
+	filtering on these fields does not allocate.
+	Values are never removed: a title, name or address replaced by an update,
+	or the text of a removed record, stays in the pool until the program ends
+	(the handles are not counted, so the pool can not know a value is unused).
+	The pool grows with the distinct values seen during a session: the data
+	files (and the text ids indexed for search) plus what the session edits.
+	A restart, which loads only the values still in the files, reclaims the rest.
+	Interning is synchronized, so the parallel items.txt loader can create items
+	on its parse threads. Reading is not: view() must not run while another
+	thread interns (which may grow the handle table), the loader only interns
+	until its threads are joined
+*/
+
+//Handle of an interned string, the default handle is the empty string
+struct InternedString {
+    std::uint32_t handle = 0;
+};
+
+inline bool operator==(InternedString a, InternedString b) { return a.handle == b.handle; }
+inline bool operator!=(InternedString a, InternedString b) { return a.handle != b.handle; }
+
+class StringPool {
+    //Characters are stored in chunks which are never reallocated
+    std::vector<std::unique_ptr<char[]>> chunks;
+    std::size_t chunk_used = 0;
+    std::size_t chunk_size = 0;
+
+    //Handle -> characters, and characters -> handle
+    std::vector<std::string_view> strings;
+    HashIndex<std::string_view, std::uint32_t> handles;
+
+    //Held by intern
+    std::mutex mutex;
+
+    static const std::size_t default_chunk_size = 64 * 1024;
+
+    std::string_view store(std::string_view value);
+
+public:
+    StringPool();
+    StringPool(StringPool const&) = delete;
+    StringPool& operator=(StringPool const&) = delete;
+
+    //Get the handle of a value, storing it if it is not in the pool yet
+    //Safe to call from several threads at once
+    InternedString intern(std::string_view value);
+
+    //Get the characters of a handle
+    inline std::string_view view(InternedString string) const { return strings[string.handle]; }
+
+    //Number of distinct values in the pool
+    inline std::size_t size() const { return strings.size(); }
+};
+
+//The pool shared by every item and customer
+StringPool& string_pool();
@@ -0,0 +1,74 @@
+#pragma once
+#include "HashIndex.h"
+#include "PackedId.h"
+#include "StringPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+	This component contains a trigram inverted index used for substring search
+	on text fields (titles, names and ids), ignoring the ASCII case. Every indexed
+	text is split into its overlapping three-character sequences (folded to lowercase),
+	and each trigram keeps the sorted list of the documents containing it. A substring query intersects the lists of its
+	own trigrams, starting from the shortest one, and only the remaining candidates
+	are checked against their text, so a search costs the size of the result
+	instead of the size of the catalog.
+	Documents are identified by a key (a packed id) and the results come back in
+	the order the documents were added. Their text is kept as a handle of the
+	string pool rather than a copy: titles and names are already in the pool,
+	so indexing them stores nothing more
+*/
+class TrigramIndex {
+    //An indexed document: its key, its interned text and whether it was removed
+    struct Document {
+        std::uint32_t key = 0;
+        InternedString text;
+        bool live = false;
+    };
+
+    //Mix the trigram bits so the lists spread over the whole table
+    struct TrigramHash {
+        std::size_t operator()(std::uint32_t trigram) const { return mix_packed_id(trigram); }
+    };
+
+    //Documents by number, numbers are given in insertion order
+    std::vector<Document> documents;
+    std::size_t live_count = 0;
+
+    //Document key -> document number
+    HashIndex<std::uint32_t, std::uint32_t> numbers;
+
+    //Trigram -> sorted numbers of the documents containing it
+    HashIndex<std::uint32_t, std::vector<std::uint32_t>, TrigramHash> postings;
+
+    void index_text(std::uint32_t number, std::string_view text);
+    void unindex_text(std::uint32_t number, std::string_view text);
+    void compact();
+
+public:
+    TrigramIndex() = default;
+
+    //Get the number of indexed documents
+    inline std::size_t size() const { return live_count; }
+
+    //Remove every document
+    void clear();
+
+    //Index the text of a document, or replace it if the key is already indexed
+    //(the text is interned in the string pool)
+    void set(std::uint32_t key, std::string_view text);
+
+    //Remove a document, return false if the key is not indexed
+    bool remove(std::uint32_t key);
+
+    //Append the keys of the documents whose text contains the query, in insertion order
+    //Queries shorter than a trigram can not use the lists and check every document
+    void search(std::string_view query, std::vector<std::uint32_t> &keys) const;
+
+    //Get the number of candidates a search would check: the length of the shortest
+    //list of the query's trigrams, or every document for queries shorter than a trigram
+    std::size_t estimate(std::string_view query) const;
+};
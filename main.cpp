@@ -1,11 +1,41 @@
 #include "headers/Item.h"
 #include "headers/ItemRepository.h"
 #include "headers/Menu.h"
+#include "headers/Snapshot.h"
+#include <iostream>
 
 using namespace std;
 
-int main() {
-    Menu menu;
+int main(int argc, char **argv) {
+    //--snapshot runs on the binary snapshots, --lazy-customers reads the customers on demand,
+    //--columnar stores the items column by column, --profile prints the plan of every filter,
+    //the conversions run without the menu
+    MenuOptions options;
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        if (option == "--text-to-snapshot") {
+            return convert_text_to_snapshots() ? 0 : 1;
+        } else if (option == "--snapshot-to-text") {
+            return convert_snapshots_to_text() ? 0 : 1;
+        } else if (option == "--snapshot") {
+            options.format = StorageFormat::Snapshot;
+        } else if (option == "--lazy-customers") {
+            options.lazy_customers = true;
+        } else if (option == "--columnar") {
+            options.columnar_items = true;
+        } else if (option == "--profile") {
+            options.profile = true;
+        } else {
+            cerr << "Unknown option: " << option << endl;
+            return 1;
+        }
+    }
+    if (options.lazy_customers && options.format == StorageFormat::Snapshot) {
+        cerr << "--lazy-customers reads customers.txt and can not be used with --snapshot" << endl;
+        return 1;
+    }
+
+    Menu menu(options);
     menu.start();
 
     /*
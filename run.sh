@@ -1,2 +1,2 @@
-g++ main.cpp sources/*.cpp -std=c++11
+g++ main.cpp sources/*.cpp -std=c++17
 ./a.out
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "../headers/Arena.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+
+const std::size_t Arena::initial_block_size;
+const std::size_t Arena::max_block_size;
+
+Arena::Arena() : next_block_size(initial_block_size) {}
+
+Arena::~Arena() {
+    release();
+}
+
+void Arena::add_block(std::size_t minimum_size) {
+    //Blocks double in size up to a maximum, bigger requests get their own block
+    std::size_t size = std::max(next_block_size, minimum_size);
+    next_block_size = std::min(next_block_size * 2, max_block_size);
+
+    Block block{static_cast<char *>(::operator new(size)), size};
+    auto position = std::upper_bound(blocks.begin(), blocks.end(), block, [](Block const &a, Block const &b) {
+        return std::less<char *>()(a.begin, b.begin);
+    });
+    blocks.insert(position, block);
+
+    current = block.begin;
+    end = block.begin + size;
+}
+
+void *Arena::allocate(std::size_t size, std::size_t alignment) {
+    //Align the current position, get a new block if there is no room left
+    auto address = reinterpret_cast<std::uintptr_t>(current);
+    std::size_t padding = (alignment - address % alignment) % alignment;
+    if (current == nullptr || padding + size > (std::size_t) (end - current)) {
+        add_block(size + alignment);
+        address = reinterpret_cast<std::uintptr_t>(current);
+        padding = (alignment - address % alignment) % alignment;
+    }
+
+    char *result = current + padding;
+    current = result + size;
+    return result;
+}
+
+bool Arena::owns(void const *object) const {
+    //Find the last block starting at or before the object
+    auto pointer = static_cast<char const *>(object);
+    auto position = std::upper_bound(blocks.begin(), blocks.end(), pointer,
+                                     [](char const *p, Block const &block) {
+                                         return std::less<char const *>()(p, block.begin);
+                                     });
+    if (position == blocks.begin()) {
+        return false;
+    }
+    --position;
+    return std::less<char const *>()(pointer, position->begin + position->size);
+}
+
+void Arena::adopt(Arena &other) {
+    if (&other == this) {
+        return;
+    }
+
+    //Merge the sorted blocks, this arena keeps allocating from its current block
+    std::vector<Block> merged;
+    merged.reserve(blocks.size() + other.blocks.size());
+    std::merge(blocks.begin(), blocks.end(), other.blocks.begin(), other.blocks.end(), std::back_inserter(merged),
+               [](Block const &a, Block const &b) {
+                   return std::less<char *>()(a.begin, b.begin);
+               });
+    blocks = std::move(merged);
+
+    //Chain the other's destructors before this arena's
+    if (other.finalizers != nullptr) {
+        Finalizer *last = other.finalizers;
+        while (last->next != nullptr) {
+            last = last->next;
+        }
+        last->next = finalizers;
+        finalizers = other.finalizers;
+    }
+
+    other.blocks.clear();
+    other.current = nullptr;
+    other.end = nullptr;
+    other.next_block_size = initial_block_size;
+    other.finalizers = nullptr;
+}
+
+void Arena::release() {
+    //Run the destructors, most recently created object first
+    while (finalizers != nullptr) {
+        Finalizer *finalizer = finalizers;
+        finalizers = finalizer->next;
+        finalizer->destroy(finalizer->object);
+    }
+
+    //Then free the blocks
+    for (auto const &block : blocks) {
+        ::operator delete(block.begin);
+    }
+    blocks.clear();
+    current = nullptr;
+    end = nullptr;
+    next_block_size = initial_block_size;
+}
@@ -0,0 +1,150 @@
+#include "../headers/Bitmap.h"
+#include <algorithm>
+#include <utility>
+
+void Bitmap::resize(std::size_t new_bit_count) {
+    words.resize((new_bit_count + 63) / 64, 0);
+    bit_count = new_bit_count;
+
+    //Clear the bits past the end of the last word so they never count
+    if (bit_count % 64 != 0) {
+        words.back() &= (std::uint64_t(1) << (bit_count % 64)) - 1;
+    }
+}
+
+std::size_t Bitmap::count() const {
+    std::size_t total = 0;
+    for (auto word : words) {
+        total += (std::size_t) __builtin_popcountll(word);
+    }
+    return total;
+}
+
+Bitmap &Bitmap::operator&=(Bitmap const &other) {
+    for (std::size_t w = 0; w < words.size(); w++) {
+        words[w] &= other.words[w];
+    }
+    return *this;
+}
+
+Bitmap &Bitmap::operator|=(Bitmap const &other) {
+    for (std::size_t w = 0; w < words.size(); w++) {
+        words[w] |= other.words[w];
+    }
+    return *this;
+}
+
+Bitmap &Bitmap::and_not(Bitmap const &other) {
+    for (std::size_t w = 0; w < words.size(); w++) {
+        words[w] &= ~other.words[w];
+    }
+    return *this;
+}
+
+BitmapIndex::BitmapIndex(std::vector<std::size_t> cardinalities) : cardinalities(std::move(cardinalities)) {
+    std::size_t total = 0;
+    for (auto cardinality : this->cardinalities) {
+        offsets.push_back(total);
+        total += cardinality;
+    }
+    values.resize(total);
+}
+
+void BitmapIndex::clear() {
+    for (auto &bitmap : values) {
+        bitmap.clear();
+    }
+    live.clear();
+    live_count = 0;
+    keys.clear();
+    slot_values.clear();
+    slots.clear();
+}
+
+void BitmapIndex::set(std::uint32_t key, std::uint8_t const *record_values) {
+    std::size_t attributes = cardinalities.size();
+
+    //Change the values of an indexed record
+    std::uint32_t const *existing = slots.find(key);
+    if (existing != nullptr) {
+        std::uint32_t slot = *existing;
+        for (std::size_t a = 0; a < attributes; a++) {
+            std::uint8_t &current = slot_values[slot * attributes + a];
+            if (current != record_values[a]) {
+                values[offsets[a] + current].reset(slot);
+                values[offsets[a] + record_values[a]].set(slot);
+                current = record_values[a];
+            }
+        }
+        return;
+    }
+
+    //Give the record the next slot, every bitmap grows by one bit
+    auto slot = (std::uint32_t) keys.size();
+    keys.push_back(key);
+    slot_values.insert(slot_values.end(), record_values, record_values + attributes);
+    slots.insert(key, slot);
+    live.resize(slot + 1);
+    for (auto &bitmap : values) {
+        bitmap.resize(slot + 1);
+    }
+
+    live.set(slot);
+    live_count++;
+    for (std::size_t a = 0; a < attributes; a++) {
+        values[offsets[a] + record_values[a]].set(slot);
+    }
+}
+
+bool BitmapIndex::remove(std::uint32_t key) {
+    std::uint32_t const *existing = slots.find(key);
+    if (existing == nullptr) {
+        return false;
+    }
+
+    std::uint32_t slot = *existing;
+    std::size_t attributes = cardinalities.size();
+    for (std::size_t a = 0; a < attributes; a++) {
+        values[offsets[a] + slot_values[slot * attributes + a]].reset(slot);
+    }
+    live.reset(slot);
+    live_count--;
+    slots.erase(key);
+
+    //Renumber once most of the slots belong to removed records
+    if (keys.size() > 64 && live_count * 2 < keys.size()) {
+        compact();
+    }
+    return true;
+}
+
+void BitmapIndex::compact() {
+    //Keep the remaining records in their order
+    std::size_t attributes = cardinalities.size();
+    std::vector<std::uint32_t> remaining_keys;
+    std::vector<std::uint8_t> remaining_values;
+    remaining_keys.reserve(live_count);
+    remaining_values.reserve(live_count * attributes);
+    live.for_each([&](std::size_t slot) {
+        remaining_keys.push_back(keys[slot]);
+        remaining_values.insert(remaining_values.end(), slot_values.begin() + slot * attributes,
+                                slot_values.begin() + (slot + 1) * attributes);
+    });
+
+    clear();
+    for (std::size_t i = 0; i < remaining_keys.size(); i++) {
+        set(remaining_keys[i], remaining_values.data() + i * attributes);
+    }
+}
+
+void BitmapIndex::keys_of(Bitmap const &bits, std::vector<std::uint32_t> &result) const {
+    bits.for_each([&](std::size_t slot) {
+        result.push_back(keys[slot]);
+    });
+}
+
+void BitmapIndex::sort_keys(std::vector<std::uint32_t> &keys) const {
+    std::sort(keys.begin(), keys.end(), [this](std::uint32_t a, std::uint32_t b) {
+        return *slots.find(a) < *slots.find(b);
+    });
+}
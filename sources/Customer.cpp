@@ -1,6 +1,7 @@
 #include <iostream>
 #include <utility>
 #include <sstream>
+#include <stdexcept>
 #include "../headers/Customer.h"
 #include "../headers/CustomerHelpers.h"
 
@@ -89,7 +90,7 @@ void GuestState::borrow(Item *item) {
 }
 
 //Return state in string for printing and writing for files
-std::string GuestState::to_string() const {
+char const *GuestState::to_string() const {
     return "Guest";
 }
 
@@ -138,7 +139,7 @@ void RegularState::borrow(Item *item) {
 }
 
 //Return the state in string
-std::string RegularState::to_string() const {
+char const *RegularState::to_string() const {
     return "Regular";
 }
 
@@ -193,22 +194,36 @@ void VIPState::set_context(Customer *customer) {
     current_points = customer->get_number_of_rentals() * 10;
 }
 
-std::string VIPState::to_string() const {
+char const *VIPState::to_string() const {
     return "VIP";
 }
 
 //Customer constructor
-Customer::Customer(std::string id, std::string name, std::string address, std::string phone, int total_rentals,
-                   std::vector<Item *> items, CustomerState *state)
-        : id(std::move(id)), name(std::move(name)), address(std::move(address)), phone(std::move(phone)),
-          number_of_rentals(total_rentals), items(std::move(items)), state(state) {
+Customer::Customer(std::string const &id, std::string_view name, std::string_view address, std::string phone,
+                   int total_rentals, std::vector<Item *> items, CustomerState *state, bool owns_state)
+        : name(string_pool().intern(name)), address(string_pool().intern(address)), phone(std::move(phone)),
+          number_of_rentals(total_rentals), items(std::move(items)), state(state), owns_state(owns_state) {
+    if (!encode_customer_id(id, this->id)) {
+        //The destructor does not run for a constructor which throws, so the state is freed here
+        if (owns_state) {
+            delete state;
+        }
+        throw std::invalid_argument("Customer ID is incorrect format: " + id);
+    }
+    state->set_context(this);
+}
+
+Customer::Customer(CustomerId id, std::string_view name, std::string_view address, std::string phone,
+                   int total_rentals, std::vector<Item *> items, CustomerState *state, bool owns_state)
+        : id(id), name(string_pool().intern(name)), address(string_pool().intern(address)), phone(std::move(phone)),
+          number_of_rentals(total_rentals), items(std::move(items)), state(state), owns_state(owns_state) {
     state->set_context(this);
 }
 
 //Destructor
 Customer::~Customer() {
-    //Delete the state
-    if (state != nullptr) {
+    //Delete the state (unless an arena owns it)
+    if (state != nullptr && owns_state) {
         delete state;
     }
 }
@@ -216,13 +231,14 @@ Customer::~Customer() {
 //Change the customer state
 //Guest -> Regular or Regular -> VIP
 void Customer::change_state(CustomerState *new_state) {
-    //Delete the current state
-    if (state != nullptr) {
+    //Delete the current state (unless an arena owns it)
+    if (state != nullptr && owns_state) {
         delete state;
     }
 
     //Set the new state
     state = new_state;
+    owns_state = true;
 
     //Also set the context of the state to this (customer)
     state->set_context(this);
@@ -248,7 +264,7 @@ Category Customer::get_state() const {
 bool Customer::borrow(Item *item) {
     //Check if item is already borrowed
     for (int i = 0; i != items.size(); ++i) {
-        if (items[i]->get_id() == item->get_id()) {
+        if (items[i]->get_key() == item->get_key()) {
             std::cerr << "Item is already borrowed by customer" << std::endl;
             return false;
         }
@@ -264,7 +280,7 @@ bool Customer::return_item(Item *item) {
     //Check if item id in rental
     int position = -1;
     for (int i = 0; i != items.size(); ++i) {
-        if (items[i]->get_id() == item->get_id()) {
+        if (items[i]->get_key() == item->get_key()) {
             position = i;
             break;
         }
@@ -308,40 +324,62 @@ void Customer::add_rental(Item *item) {
 }
 
 //Display the customer
-std::ostream &operator<<(std::ostream &os, Customer const &customer) {
-    std::string state;
-    switch ((customer.state)->get_state()) {
+void Customer::render_console(OutputBuffer &out) const {
+    char id_text[CustomerId::length];
+    write_customer_id(id, id_text);
+    out.append("Id: ");
+    out.append(std::string_view(id_text, CustomerId::length));
+    out.append(", Name: ");
+    out.append(get_name());
+    out.append(", State: ");
+    switch (state->get_state()) {
         case Category::guest:
-            state = "guest";
+            out.append("guest");
             break;
         case Category::regular:
-            state = "regular";
+            out.append("regular");
             break;
         case Category::vip:
-            state = "vip";
+            out.append("vip");
             break;
     }
-    os << "Id: " << customer.id << ", Name: " << customer.name << ", State: " << state;
-    return os;
+}
+
+std::ostream &operator<<(std::ostream &os, Customer const &customer) {
+    OutputBuffer out;
+    customer.render_console(out);
+    return os << out.view();
 }
 
 //Convert customer into string representation to write to string
-std::string Customer::to_string_file() const {
-    std::stringstream out_stream;
-    out_stream << id << ","
-               << name << ","
-               << address << ","
-               << phone << ","
-               << number_of_rentals << ","
-               << state->to_string()
-               << std::endl;
-
-    for (unsigned int i = 0;  i < items.size() ; i++) {
-        out_stream << items[i] -> get_id();
+void Customer::render_file(OutputBuffer &out) const {
+    char id_text[CustomerId::length];
+    write_customer_id(id, id_text);
+    out.append(std::string_view(id_text, CustomerId::length));
+    out.append(',');
+    out.append(get_name());
+    out.append(',');
+    out.append(get_address());
+    out.append(',');
+    out.append(phone);
+    out.append(',');
+    out.append_signed(number_of_rentals);
+    out.append(',');
+    out.append(state->to_string());
+    out.append('\n');
+
+    char item_text[ItemId::length];
+    for (unsigned int i = 0; i < items.size(); i++) {
+        write_item_id(items[i]->get_key(), item_text);
+        out.append(std::string_view(item_text, ItemId::length));
         if (i < items.size() - 1) {
-            out_stream << "\n";
+            out.append('\n');
         }
     }
+}
 
-    return out_stream.str();
+std::string Customer::to_string_file() const {
+    OutputBuffer out;
+    render_file(out);
+    return out.str();
 }
@@ -6,22 +6,27 @@
 
 std::vector<std::string> get_customer_as_vector(const std::string &str) {
     std::vector<std::string> tokens;
+    split_customer_fields(str, tokens);
+    return tokens;
+}
+
+void split_customer_fields(const std::string &line, std::vector<std::string> &fields) {
+    fields.clear();
     size_t prev = 0, pos = 0;
     do {
-        pos = str.find(',', prev);
-        if (pos == std::string::npos) pos = str.length();
-        std::string token = str.substr(prev, pos - prev);
-        if (token[token.length() - 1] == 32) token.erase(token.length() - 1, 1);
-        if (!token.empty()) tokens.push_back(token);
+        pos = line.find(',', prev);
+        if (pos == std::string::npos) pos = line.length();
+        size_t length = pos - prev;
+        if (length != 0 && line[pos - 1] == 32) length--;
+        if (length != 0) fields.emplace_back(line, prev, length);
         prev = pos + 1;
-    } while (pos < str.length() && prev < str.length());
-    return tokens;
+    } while (pos < line.length() && prev < line.length());
 }
 
-bool correct_customer_info_length(const std::string &line) {
+bool correct_customer_info_length(const std::string &line, std::ostream &log) {
     const unsigned int comma_count = std::count(line.begin(), line.end(), ',');
     if (comma_count != 5) {
-        std::cout << "[ERROR] Customer info must have 5 commas, received: " << line << std::endl;
+        log << "[ERROR] Customer info must have 5 commas, received: " << line << std::endl;
         return false;
     }
     return true;
@@ -55,7 +60,7 @@ bool customer_id_number_is_not_numeric(const std::string &id_number) {
     return id_number.find_first_not_of(numerics) != std::string::npos;
 }
 
-bool customer_id_is_valid(const std::string &id, bool from_menu) {
+bool customer_id_is_valid(const std::string &id, bool from_menu, std::ostream &log) {
     // format: Cxxx
     std::vector<std::string> id_pool;
     std::string default_error = "[ERROR] Customer ID is incorrect format ";
@@ -63,7 +68,7 @@ bool customer_id_is_valid(const std::string &id, bool from_menu) {
 
     // id length of item must be 4
     if (id.length() != 4) {
-        std::cout << default_error << "(wrong length)" << custom_text << std::endl;
+        log << default_error << "(wrong length)" << custom_text << std::endl;
         return false;
     }
 
@@ -72,27 +77,27 @@ bool customer_id_is_valid(const std::string &id, bool from_menu) {
 
     // first letter must be "C".
     if (first_letter != 'C') {
-        std::cout << default_error << "(must begin with 'C')!" << std::endl;
+        log << default_error << "(must begin with 'C')!" << std::endl;
         return false;
     }
 
     // ‘xxx’ is a unique code of 3 digits (e.g. 123)
     if (customer_id_number_is_not_numeric(id_number)) {
-        std::cout << default_error << "(ID number in Item ID must be numerics)!" << std::endl;
+        log << default_error << "(ID number in Item ID must be numerics)!" << std::endl;
         return false;
     }
 
     return true;
 }
 
-bool customer_name_is_valid(const std::string &name) {
+bool customer_name_is_valid(const std::string &name, std::ostream &log) {
     if (name.length() < 4) {
-        std::cout << "[ERROR] Customer name must have at least 4 characters." << std::endl;
+        log << "[ERROR] Customer name must have at least 4 characters." << std::endl;
         return false;
     }
     for (char c : name) {
         if (!std::isalnum(c) && c != 32) {
-            std::cout << "[ERROR] Customer name must not have special characters/digits, received " << name
+            log << "[ERROR] Customer name must not have special characters/digits, received " << name
                       << std::endl;
             return false;
         }
@@ -100,14 +105,14 @@ bool customer_name_is_valid(const std::string &name) {
     return true;
 }
 
-bool customer_address_is_valid(const std::string &address) {
+bool customer_address_is_valid(const std::string &address, std::ostream &log) {
     if (address.length() < 6) {
-        std::cout << "[ERROR] Customer address must have at least 6 characters." << std::endl;
+        log << "[ERROR] Customer address must have at least 6 characters." << std::endl;
         return false;
     }
     for (char c : address) {
         if (!std::isalnum(c) && c != 32) {
-            std::cout << "[ERROR] Customer address must not have special characters/digits, received: " << address
+            log << "[ERROR] Customer address must not have special characters/digits, received: " << address
                       << std::endl;
             return false;
         }
@@ -115,27 +120,27 @@ bool customer_address_is_valid(const std::string &address) {
     return true;
 }
 
-bool customer_rental_number_is_valid(const std::string &rental_num) {
+bool customer_rental_number_is_valid(const std::string &rental_num, std::ostream &log) {
     const std::string default_error = "[ERROR] Customer number of rentals is invalid ";
     try {
         const int int_rental_num = std::stoi(rental_num);
         if (int_rental_num >= 0) {
             return true;
         }
-        std::cout << default_error
+        log << default_error
                   << ", rental number must be bigger or equals to 0, received: "
                   << rental_num
                   << std::endl;
         return false;
     } catch (std::invalid_argument &e) {
-        std::cout << default_error << ", received: " << rental_num << std::endl;
+        log << default_error << ", received: " << rental_num << std::endl;
         return false;
     }
 }
 
-bool customer_type_is_valid(const std::string &type) {
+bool customer_type_is_valid(const std::string &type, std::ostream &log) {
     if (type != "Guest" && type != "Regular" && type != "VIP") {
-        std::cout << "Customer must be either Guest, Regular, or VIP, received: " << type << std::endl;
+        log << "Customer must be either Guest, Regular, or VIP, received: " << type << std::endl;
         return false;
     }
 
@@ -143,15 +148,24 @@ bool customer_type_is_valid(const std::string &type) {
 }
 
 bool valid_customer_data(const std::string &line) {
-    if (!correct_customer_info_length(line)) {
+    std::vector<std::string> customer_vector;
+    return valid_customer_data(line, customer_vector);
+}
+
+bool valid_customer_data(const std::string &line, std::vector<std::string> &customer_vector, std::ostream &log) {
+    if (!correct_customer_info_length(line, log)) {
+        return false;
+    }
+    split_customer_fields(line, customer_vector);
+    if (customer_vector.size() != 6) {
+        log << "[ERROR] Customer info is missing info, received: " << line << std::endl;
         return false;
     }
-    const std::vector<std::string> customer_vector = get_customer_as_vector(line);
-    return customer_id_is_valid(customer_vector[0], false) &&
-           customer_name_is_valid(customer_vector[1]) &&
-           customer_address_is_valid(customer_vector[2]) &&
-           customer_rental_number_is_valid(customer_vector[4]) &&
-           customer_type_is_valid(customer_vector[5]);
+    return customer_id_is_valid(customer_vector[0], false, log) &&
+           customer_name_is_valid(customer_vector[1], log) &&
+           customer_address_is_valid(customer_vector[2], log) &&
+           customer_rental_number_is_valid(customer_vector[4], log) &&
+           customer_type_is_valid(customer_vector[5], log);
 }
 
 int get_number_of_videos(Customer const *customer) {
@@ -2,7 +2,10 @@
 #include "../headers/Customer.h"
 #include "../headers/ItemHelpers.h"
 #include "../headers/CustomerHelpers.h"
+#include "../headers/Journal.h"
 #include <algorithm>
+#include <cstring>
+#include <filesystem>
 #include <string>
 #include <utility>
 #include <vector>
@@ -48,102 +51,322 @@ void AddressModificationIntent::modify() {
     customer->set_address(address);
 }
 
+//Child of Modification intent
+//Used when we want to promote a customer to the next level
+void PromotionModificationIntent::modify() {
+    customer->promote();
+}
+
 //Implementation of Repository pattern
 //Where all CRUD operation will be done using an in-memory vector
 InMemoryCustomerRepository::InMemoryCustomerRepository(std::vector<Customer *> const &customers) : customers(
-        customers) {}
+        customers) {
+    rebuild_index();
+}
+
+InMemoryCustomerRepository::~InMemoryCustomerRepository() {
+    //Customers created in the arena are released together with it
+    for (auto customer_ptr : customers) {
+        if (customer_ptr != nullptr && !arena.owns(customer_ptr)) {
+            delete customer_ptr;
+        }
+    }
+}
 
 void InMemoryCustomerRepository::set_customers(std::vector<Customer *> const &new_customers) {
     customers = new_customers;
+    rebuild_index();
 }
 
-Customer *InMemoryCustomerRepository::get_customer(std::string const &id) {
-    for (auto customer_ptr : customers) {
-        if (customer_ptr != nullptr && customer_ptr->get_id() == id) {
-            return customer_ptr;
+void InMemoryCustomerRepository::rebuild_index() {
+    index.clear();
+    index.reserve(customers.size());
+    name_index.clear();
+    id_index.clear();
+    bitmaps.clear();
+    for (std::size_t i = 0; i != customers.size(); ++i) {
+        index.insert(customers[i]->get_key(), i);
+        index_text(customers[i]);
+        bitmaps.set_customer(customers[i]);
+    }
+    by_name.assign(customers);
+    by_id.assign(customers);
+    by_level.assign(customers);
+}
+
+void InMemoryCustomerRepository::index_text(Customer const *customer) {
+    name_index.set(customer->get_key().value, customer->get_name());
+    id_index.set(customer->get_key().value, customer->get_id());
+}
+
+bool InMemoryCustomerRepository::search_names(std::string_view query, std::vector<Customer *> &found) {
+    std::vector<std::uint32_t> keys;
+    name_index.search(query, keys);
+    collect(keys, found);
+    return true;
+}
+
+bool InMemoryCustomerRepository::search_ids(std::string_view query, std::vector<Customer *> &found) {
+    std::vector<std::uint32_t> keys;
+    id_index.search(query, keys);
+    collect(keys, found);
+    return true;
+}
+
+//Positions are changed by removals, so the positions found are sorted to keep the vector order
+void InMemoryCustomerRepository::collect(std::vector<std::uint32_t> const &keys,
+                                         std::vector<Customer *> &found) const {
+    std::vector<std::size_t> positions;
+    positions.reserve(keys.size());
+    for (auto key : keys) {
+        std::size_t const *position = index.find(CustomerId(key));
+        if (position != nullptr) {
+            positions.push_back(*position);
         }
     }
+    std::sort(positions.begin(), positions.end());
+
+    found.reserve(found.size() + positions.size());
+    for (auto position : positions) {
+        found.push_back(customers[position]);
+    }
+}
+
+void InMemoryCustomerRepository::collect_bitmap(Bitmap const &bits, std::vector<Customer *> &found) {
+    std::vector<std::uint32_t> keys;
+    bitmaps.keys_of(bits, keys);
+    collect(keys, found);
+}
+
+int InMemoryCustomerRepository::get_customer_index(std::string const &customer_id) const {
+    //An id that can not be packed does not belong to any customer
+    CustomerId key;
+    if (!encode_customer_id(customer_id, key)) {
+        return -1;
+    }
+
+    std::size_t const *position = index.find(key);
+    return position == nullptr ? -1 : (int) *position;
+}
+
+Customer *InMemoryCustomerRepository::get_customer(std::string const &id) {
+    int position = get_customer_index(id);
     //No customer found
-    return nullptr;
+    return position == -1 ? nullptr : customers[position];
 }
 
 void InMemoryCustomerRepository::add_customer(Customer *customer) {
+    //Nothing to add (e.g. the user cancelled the input)
+    if (customer == nullptr) {
+        return;
+    }
+
+    //Ignore the customer if the id is already taken
+    if (!index.insert(customer->get_key(), customers.size())) {
+        std::cerr << "Customer with the same id already exists" << std::endl;
+        return;
+    }
     customers.push_back(customer);
+    index_text(customer);
+    by_name.insert(customer);
+    by_id.insert(customer);
+    by_level.insert(customer);
+    bitmaps.set_customer(customer);
+    mark_changed();
 }
 
 void InMemoryCustomerRepository::remove_customer(std::string const &customer_id) {
     //Find the position of the customer
-    int position = -1;
-    for (int i = 0; i != customers.size(); ++i) {
-        if (customer_id == customers[i]->get_id()) {
-            position = i;
-            break;
-        }
-    }
+    int position = get_customer_index(customer_id);
 
-    //Remove if element exists
-    if (position != -1) {
-        customers.erase(customers.begin() + position);
-    } else {
+    //Display error if element does not exist
+    if (position == -1) {
         std::cerr << "User does not exist" << std::endl;
+        return;
+    }
+
+    //Swap and pop: move the last customer into the freed position
+    //and update its position in the index
+    CustomerId key = customers[position]->get_key();
+    index.erase(key);
+    name_index.remove(key.value);
+    id_index.remove(key.value);
+    by_name.erase(customers[position]);
+    by_id.erase(customers[position]);
+    by_level.erase(customers[position]);
+    bitmaps.remove(key.value);
+    if (position != (int) customers.size() - 1) {
+        customers[position] = customers.back();
+        index.insert_or_assign(customers[position]->get_key(), position);
     }
+    customers.pop_back();
+    mark_changed();
 }
 
 void InMemoryCustomerRepository::update_customer(std::string const &customer_id, ModificationIntent &intent) {
-    //Find the position of the customer
-    int position = -1;
-    for (int i = 0; i != customers.size(); ++i) {
-        if (customer_id == customers[i]->get_id()) {
-            position = i;
-            break;
-        }
-    }
+    //Find the customer
+    Customer *customer = get_customer(customer_id);
 
-    //Update if element exists
-    if (position != -1) {
-        intent.set_customer(customers[position]);
+    //Update if element exists, then re-index its name in case it changed
+    //(the customer leaves the name and level orders while they may change)
+    if (customer != nullptr) {
+        by_name.erase(customer);
+        by_level.erase(customer);
+        intent.set_customer(customer);
         intent.modify();
+        by_name.insert(customer);
+        by_level.insert(customer);
+        bitmaps.set_customer(customer);
+        name_index.set(customer->get_key().value, customer->get_name());
+        mark_changed();
     } else {
         std::cerr << "User does not exist" << std::endl;
     }
 }
 
+//Position of a key relative to the key of a cursor
+static int compare_keys(CustomerId key, CustomerId cursor_key) {
+    return key < cursor_key ? -1 : (key == cursor_key ? 0 : 1);
+}
+
 //Displayer
 void CustomerNameOrder::order(std::vector<Customer *> &customers) const {
-    std::sort(customers.begin(), customers.end(), [](Customer const *a, Customer const *b) {
-        return a->get_name() < b->get_name();
-    });
+    std::sort(customers.begin(), customers.end(), CustomerNameLess());
+}
+
+std::vector<Customer *> const *CustomerNameOrder::ordered(CustomerRepository &repository) const {
+    return repository.get_customers_by_name();
+}
+
+bool CustomerNameOrder::less(Customer const *a, Customer const *b) const {
+    return CustomerNameLess()(a, b);
+}
+
+int CustomerNameOrder::compare(Customer const *customer, CustomerCursor const &cursor) const {
+    int name = customer->get_name().compare(cursor.name);
+    if (name != 0) {
+        return name;
+    }
+    return compare_keys(customer->get_key(), cursor.key);
 }
 
 void CustomerIdOrder::order(std::vector<Customer *> &customers) const {
-    std::sort(customers.begin(), customers.end(), [](Customer const *a, Customer const *b) {
-        return a->get_id() < b->get_id();
-    });
+    std::sort(customers.begin(), customers.end(), CustomerIdLess());
+}
+
+std::vector<Customer *> const *CustomerIdOrder::ordered(CustomerRepository &repository) const {
+    return repository.get_customers_by_id();
+}
+
+bool CustomerIdOrder::less(Customer const *a, Customer const *b) const {
+    return CustomerIdLess()(a, b);
+}
+
+int CustomerIdOrder::compare(Customer const *customer, CustomerCursor const &cursor) const {
+    return compare_keys(customer->get_key(), cursor.key);
 }
 
 void CustomerLevelOrder::order(std::vector<Customer *> &customers) const {
-    std::sort(customers.begin(), customers.end(), [](Customer const *a, Customer const *b) {
-        return a->get_state() < b->get_state();
-    });
+    std::sort(customers.begin(), customers.end(), CustomerLevelLess());
+}
+
+std::vector<Customer *> const *CustomerLevelOrder::ordered(CustomerRepository &repository) const {
+    return repository.get_customers_by_level();
+}
+
+bool CustomerLevelOrder::less(Customer const *a, Customer const *b) const {
+    return CustomerLevelLess()(a, b);
+}
+
+int CustomerLevelOrder::compare(Customer const *customer, CustomerCursor const &cursor) const {
+    Category level = customer->get_state();
+    if (level != cursor.level) {
+        return level < cursor.level ? -1 : 1;
+    }
+    return compare_keys(customer->get_key(), cursor.key);
 }
 
 void CustomerNoOrder::order(std::vector<Customer *> &customers) const {
     //Do nothing
 }
 
-void ConsoleCustomerDisplayer::display(std::vector<Customer *> customers, CustomerOrder const *order) {
-    //Sort first
-    order->order(customers);
-    for (auto &customer : customers) {
-        std::cout << *customer << std::endl;
+std::vector<Customer *> const *CustomerNoOrder::ordered(CustomerRepository &repository) const {
+    return &repository.get_customers();
+}
+
+bool CustomerNoOrder::less(Customer const *a, Customer const *b) const {
+    return CustomerIdLess()(a, b);
+}
+
+int CustomerNoOrder::compare(Customer const *customer, CustomerCursor const &cursor) const {
+    return compare_keys(customer->get_key(), cursor.key);
+}
+
+//Cursor: the sort fields of a customer, by value
+CustomerCursor::CustomerCursor(Customer const *customer)
+        : name(customer->get_name()), level(customer->get_state()), key(customer->get_key()) {}
+
+//Bitmap index over the levels of the customers
+CustomerBitmapIndex::CustomerBitmapIndex() : BitmapIndex({3}) {}
+
+void CustomerBitmapIndex::set_customer(Customer const *customer) {
+    std::uint8_t values[1];
+    values[LEVEL_ATTRIBUTE] = (std::uint8_t) customer->get_state();
+    set(customer->get_key().value, values);
+}
+
+bool CustomerNameLess::operator()(Customer const *a, Customer const *b) const {
+    std::string_view name_a = a->get_name();
+    std::string_view name_b = b->get_name();
+    return name_a != name_b ? name_a < name_b : a->get_key() < b->get_key();
+}
+
+bool CustomerIdLess::operator()(Customer const *a, Customer const *b) const {
+    return a->get_key() < b->get_key();
+}
+
+bool CustomerLevelLess::operator()(Customer const *a, Customer const *b) const {
+    Category level_a = a->get_state();
+    Category level_b = b->get_state();
+    return level_a != level_b ? level_a < level_b : a->get_key() < b->get_key();
+}
+
+void ConsoleCustomerDisplayer::display(std::vector<Customer *> const &customers, CustomerOrder const *order) {
+    //Only copy the list when it has to be sorted first
+    if (!order->reorders()) {
+        render(customers);
+        return;
+    }
+    std::vector<Customer *> sorted(customers);
+    order->order(sorted);
+    render(sorted);
+}
+
+void ConsoleCustomerDisplayer::render(std::vector<Customer *> const &customers) {
+    for (auto customer : customers) {
+        customer->render_console(out);
+        out.append('\n');
+        out.end_record();
     }
+    out.flush();
 }
 
 //Filters
 IdFilterSpecification::IdFilterSpecification(std::string const &id) : id(id) {}
 
 bool IdFilterSpecification::is_satisfied(Customer const *customer) const {
-    return check_field_contains(customer->get_id(), id);
+    //Decode the packed id on the stack instead of building a string
+    char buffer[CustomerId::length];
+    write_customer_id(customer->get_key(), buffer);
+    return check_field_contains(std::string_view(buffer, CustomerId::length), id);
+}
+
+bool IdFilterSpecification::lookup(CustomerRepository &repository, std::vector<Customer *> &customers) const {
+    return repository.search_ids(id, customers);
+}
+
+FilterSpecification const *IdFilterSpecification::plan(CustomerRepository &repository, std::size_t &estimate) const {
+    return repository.estimate_ids(id, estimate) ? this : nullptr;
 }
 
 NameFilterSpecification::NameFilterSpecification(std::string const &name) : name(name) {}
@@ -152,16 +375,207 @@ bool NameFilterSpecification::is_satisfied(Customer const *customer) const {
     return check_field_contains(customer->get_name(), name);
 }
 
+bool NameFilterSpecification::lookup(CustomerRepository &repository, std::vector<Customer *> &customers) const {
+    return repository.search_names(name, customers);
+}
+
+FilterSpecification const *NameFilterSpecification::plan(CustomerRepository &repository,
+                                                         std::size_t &estimate) const {
+    return repository.estimate_names(name, estimate) ? this : nullptr;
+}
+
 StateFilterSpecification::StateFilterSpecification(Category state) : state(state) {}
 
 bool StateFilterSpecification::is_satisfied(Customer const *customer) const {
     return customer->get_state() == state;
 }
 
+bool StateFilterSpecification::bitmap(CustomerRepository &repository, Bitmap &bits) const {
+    CustomerBitmapIndex const *index = repository.get_bitmap_index();
+    if (index == nullptr) {
+        return false;
+    }
+    bits = index->get(LEVEL_ATTRIBUTE, (std::uint8_t) state);
+    return true;
+}
+
 bool AllFilterSpecification::is_satisfied(Customer const *customer) const {
     return true;
 }
 
+bool AllFilterSpecification::bitmap(CustomerRepository &repository, Bitmap &bits) const {
+    CustomerBitmapIndex const *index = repository.get_bitmap_index();
+    if (index == nullptr) {
+        return false;
+    }
+    bits = index->all();
+    return true;
+}
+
+//Specifications answered by the bitmap index
+bool BitmapFilterSpecification::lookup(CustomerRepository &repository, std::vector<Customer *> &customers) const {
+    Bitmap bits;
+    if (!bitmap(repository, bits)) {
+        return false;
+    }
+    repository.collect_bitmap(bits, customers);
+    return true;
+}
+
+FilterSpecification const *BitmapFilterSpecification::plan(CustomerRepository &repository,
+                                                           std::size_t &estimate) const {
+    Bitmap bits;
+    if (!bitmap(repository, bits)) {
+        return nullptr;
+    }
+    estimate = bits.count();
+    return this;
+}
+
+//Combinators
+AndFilterSpecification::AndFilterSpecification(std::vector<FilterSpecification const *> specifications)
+        : specifications(std::move(specifications)) {}
+
+bool AndFilterSpecification::is_satisfied(Customer const *customer) const {
+    for (auto specification : specifications) {
+        if (!specification->is_satisfied(customer)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//Any index of a specification gives candidates for the whole conjunction: take the most selective one
+FilterSpecification const *AndFilterSpecification::plan(CustomerRepository &repository, std::size_t &estimate) const {
+    FilterSpecification const *best = nullptr;
+    for (auto specification : specifications) {
+        std::size_t specification_estimate = 0;
+        FilterSpecification const *driver = specification->plan(repository, specification_estimate);
+        if (driver != nullptr && (best == nullptr || specification_estimate < estimate)) {
+            best = driver;
+            estimate = specification_estimate;
+        }
+    }
+
+    //The intersection of several bitmaps can be more selective than any single index
+    Bitmap bits;
+    if (intersect_bitmaps(repository, bits, nullptr) > 1) {
+        std::size_t bitmap_estimate = bits.count();
+        if (best == nullptr || bitmap_estimate < estimate) {
+            best = this;
+            estimate = bitmap_estimate;
+        }
+    }
+    return best;
+}
+
+//Get the candidates from the intersection of the bitmaps, then check the other specifications
+bool AndFilterSpecification::lookup(CustomerRepository &repository, std::vector<Customer *> &customers) const {
+    Bitmap bits;
+    std::vector<FilterSpecification const *> remaining;
+    if (intersect_bitmaps(repository, bits, &remaining) == 0) {
+        return false;
+    }
+
+    std::vector<Customer *> candidates;
+    repository.collect_bitmap(bits, candidates);
+    for (auto customer : candidates) {
+        bool satisfied = true;
+        for (std::size_t i = 0; i < remaining.size() && satisfied; i++) {
+            satisfied = remaining[i]->is_satisfied(customer);
+        }
+        if (satisfied) {
+            customers.push_back(customer);
+        }
+    }
+    return true;
+}
+
+bool AndFilterSpecification::bitmap(CustomerRepository &repository, Bitmap &bits) const {
+    std::vector<FilterSpecification const *> remaining;
+    std::size_t answered = intersect_bitmaps(repository, bits, &remaining);
+    if (!remaining.empty()) {
+        return false;
+    }
+
+    //No specification at all: every customer
+    if (answered == 0) {
+        CustomerBitmapIndex const *index = repository.get_bitmap_index();
+        if (index == nullptr) {
+            return false;
+        }
+        bits = index->all();
+    }
+    return true;
+}
+
+std::size_t AndFilterSpecification::intersect_bitmaps(CustomerRepository &repository, Bitmap &bits,
+                                                      std::vector<FilterSpecification const *> *remaining) const {
+    std::size_t answered = 0;
+    Bitmap specification_bits;
+    for (auto specification : specifications) {
+        if (specification->bitmap(repository, specification_bits)) {
+            if (answered == 0) {
+                bits = specification_bits;
+            } else {
+                bits &= specification_bits;
+            }
+            answered++;
+        } else if (remaining != nullptr) {
+            remaining->push_back(specification);
+        }
+    }
+    return answered;
+}
+
+OrFilterSpecification::OrFilterSpecification(std::vector<FilterSpecification const *> specifications)
+        : specifications(std::move(specifications)) {}
+
+bool OrFilterSpecification::is_satisfied(Customer const *customer) const {
+    for (auto specification : specifications) {
+        if (specification->is_satisfied(customer)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+//The union can only use bitmaps when every specification has one
+bool OrFilterSpecification::bitmap(CustomerRepository &repository, Bitmap &bits) const {
+    CustomerBitmapIndex const *index = repository.get_bitmap_index();
+    if (index == nullptr) {
+        return false;
+    }
+
+    bits = Bitmap(index->all().size());
+    Bitmap specification_bits;
+    for (auto specification : specifications) {
+        if (!specification->bitmap(repository, specification_bits)) {
+            return false;
+        }
+        bits |= specification_bits;
+    }
+    return true;
+}
+
+NotFilterSpecification::NotFilterSpecification(FilterSpecification const *specification)
+        : specification(specification) {}
+
+bool NotFilterSpecification::is_satisfied(Customer const *customer) const {
+    return !specification->is_satisfied(customer);
+}
+
+bool NotFilterSpecification::bitmap(CustomerRepository &repository, Bitmap &bits) const {
+    CustomerBitmapIndex const *index = repository.get_bitmap_index();
+    Bitmap specification_bits;
+    if (index == nullptr || !specification->bitmap(repository, specification_bits)) {
+        return false;
+    }
+    bits = index->all();
+    bits.and_not(specification_bits);
+    return true;
+}
+
 std::vector<Customer *>
 CustomerFilterer::filter(std::vector<Customer *> const &customers, FilterSpecification const *spec) {
     std::vector<Customer *> result;
@@ -175,6 +589,39 @@ CustomerFilterer::filter(std::vector<Customer *> const &customers, FilterSpecifi
     return result;
 }
 
+//Planner: get the candidates through the most selective index, or scan
+std::vector<Customer *> CustomerFilterer::filter(CustomerRepository &repository, FilterSpecification const *spec,
+                                                 QueryPlan &plan) {
+    std::vector<Customer *> result;
+    std::size_t estimate = 0;
+    FilterSpecification const *driver = spec->plan(repository, estimate);
+    std::vector<Customer *> candidates;
+    if (driver != nullptr && driver->lookup(repository, candidates)) {
+        plan.access = driver->index_name();
+        plan.estimate = estimate;
+        plan.candidates = candidates.size();
+
+        //The index answers the whole specification, otherwise check it on the candidates
+        if (driver == spec) {
+            result = std::move(candidates);
+        } else {
+            for (auto customer : candidates) {
+                if (spec->is_satisfied(customer)) {
+                    result.push_back(customer);
+                }
+            }
+        }
+    } else {
+        plan.access = "scan";
+        plan.candidates = repository.get_customers().size();
+        plan.estimate = plan.candidates;
+        result = filter(repository.get_customers(), spec);
+    }
+
+    plan.results = result.size();
+    return result;
+}
+
 //Customer service
 CustomerService::CustomerService(CustomerRepository *repo, CustomerDisplayer *display, CustomerFilterer *filterer,
                                  CustomerPersistence *persistence) :
@@ -198,12 +645,39 @@ CustomerService::~CustomerService() {
     }
 }
 
-void CustomerService::load(std::vector<Item *> items) {
-    repository->set_customers(persistence->load(std::move(items)));
+void CustomerService::load(std::vector<Item *> const &items) {
+    if (!repository->open(items)) {
+        repository->set_customers(persistence->load(items, repository->get_arena()));
+    }
+    saved_version = repository->get_version();
 }
 
 void CustomerService::save() {
-    persistence->save(repository->get_customers());
+    if (repository->get_version() == saved_version) {
+        std::cout << "[INFO] No changes to the customers, nothing to save" << std::endl;
+        return;
+    }
+    PendingFile file;
+    if (repository->render(file)) {
+        if (!replace_file(file.path, file.contents)) {
+            std::cerr << "[ERROR] Cannot write to file customers.txt" << std::endl;
+            return;
+        }
+        std::cout << "[SUCCESS] Successfully saved customers.txt!" << std::endl;
+    } else {
+        persistence->save(repository->get_customers());
+    }
+    saved_version = repository->get_version();
+}
+
+PendingFile CustomerService::render(std::vector<Item *> const &items) {
+    //The checkpoint writes what is rendered here
+    saved_version = repository->get_version();
+    PendingFile file;
+    if (repository->render(file)) {
+        return file;
+    }
+    return persistence->render(repository->get_customers(), items);
 }
 
 Customer *CustomerService::get(std::string const &id) {
@@ -212,23 +686,86 @@ Customer *CustomerService::get(std::string const &id) {
 
 void CustomerService::add(Customer *customer) {
     repository->add_customer(customer);
+    //The customer is not added if its id is taken
+    if (journal != nullptr && customer != nullptr && repository->get_customer(customer->get_id()) == customer) {
+        journal->customer_put(customer);
+    }
 }
 
 void CustomerService::remove(std::string const &id) {
+    Customer *customer = repository->get_customer(id);
     repository->remove_customer(id);
+    if (journal != nullptr && customer != nullptr) {
+        journal->customer_removed(customer->get_key());
+    }
 }
 
 void CustomerService::update(std::string const &id, ModificationIntent &intent) {
     repository->update_customer(id, intent);
+    Customer *customer = repository->get_customer(id);
+    if (journal != nullptr && customer != nullptr) {
+        journal->customer_put(customer);
+    }
+}
+
+bool CustomerService::borrow(Customer *customer, Item *item) {
+    //The state of the customer may refuse the item, then the rentals do not change
+    std::size_t rentals = customer->get_items().size();
+    customer->borrow(item);
+    if (customer->get_items().size() == rentals) {
+        return false;
+    }
+    repository->customer_changed(customer);
+    if (journal != nullptr) {
+        journal->borrowed(customer, item);
+    }
+    return true;
+}
+
+bool CustomerService::return_item(Customer *customer, Item *item) {
+    if (!customer->return_item(item)) {
+        return false;
+    }
+    repository->customer_changed(customer);
+    if (journal != nullptr) {
+        journal->returned(customer, item);
+    }
+    return true;
 }
 
 void CustomerService::display(CustomerOrder const *order) {
-    displayer->display(repository->get_customers(), order);
+    //Walk the ordered index of the repository if it keeps this order, otherwise sort
+    std::vector<Customer *> const *ordered = order->ordered(*repository);
+    if (ordered != nullptr) {
+        CustomerNoOrder no_order;
+        displayer->display(*ordered, &no_order);
+    } else {
+        displayer->display(repository->get_customers(), order);
+    }
+}
+
+CustomerPage CustomerService::page(CustomerOrder const *order, CustomerCursor const *cursor, bool forward,
+                                   std::size_t page_size) {
+    //Binary search in the ordered index of the repository if it keeps this order,
+    //otherwise sort only the page out of the customers (the repository order is not sorted by any field)
+    std::vector<Customer *> const *ordered = order->reorders() ? order->ordered(*repository) : nullptr;
+    if (ordered != nullptr) {
+        return get_page(*ordered, true, *order, cursor, forward, page_size);
+    }
+    return get_page(repository->get_customers(), false, *order, cursor, forward, page_size);
+}
+
+void CustomerService::display_page(CustomerPage const &page) {
+    CustomerNoOrder no_order;
+    displayer->display(page.records, &no_order);
 }
 
 void CustomerService::filter(FilterSpecification const *spec) {
-    //Get filtered element
-    auto filtered = filterer->filter(repository->get_customers(), spec);
+    //Get filtered element through the most selective index the spec can use, or by a scan
+    auto filtered = filterer->filter(*repository, spec, last_plan);
+    if (profiling) {
+        std::cout << last_plan << std::endl;
+    }
 
     //Check if there is no item
     if (filtered.size() == 0) {
@@ -241,21 +778,27 @@ void CustomerService::filter(FilterSpecification const *spec) {
     displayer->display(filtered, &order);
 }
 
-bool already_have_item(const std::vector<std::string> &vector, const std::string &item) {
-    return std::count(vector.begin(), vector.end(), item) != 0;
+//Create an object in the arena, or on the heap without one
+template<typename T, typename... Args>
+static T *create_in(Arena *arena, Args &&... args) {
+    return arena != nullptr ? arena->create<T>(std::forward<Args>(args)...) : new T(std::forward<Args>(args)...);
 }
 
-Customer *load_customer(
+//Create a loaded customer from its fields and rentals, in the arena or on the heap
+//(owning its state) without one, reporting what was loaded and fixed to the log
+static Customer *load_customer(
         std::vector<std::string> &customer_vector,
-        std::vector<std::string> rentals_vector,
-        const std::vector<Item *> &items,
-        std::string items_quantity_msg
+        std::vector<ItemId> rentals_vector,
+        const ItemIndex &items,
+        std::string items_quantity_msg,
+        Arena *arena,
+        std::ostream &log = std::cout
 ) {
     std::vector<Item *> rental_items;
     items_quantity_msg = rentals_vector.empty() ? " with no items." : " with item(s):";
     if (customer_vector[5] == "Guest") {
         unsigned int video_count = 0;
-        for (const std::string &item_id : rentals_vector) {
+        for (ItemId item_id : rentals_vector) {
             Item *item = get_item_with_id(items, item_id);
             if (item->get_type() == ItemType::VIDEO) {
                 video_count++;
@@ -263,18 +806,18 @@ Customer *load_customer(
         }
 
         if (video_count > 2) {
-            std::cout << "[ERROR] " << customer_vector[0]
+            log << "[ERROR] " << customer_vector[0]
                       << " (Guest) can only borrow 2 Video Items at a time" << std::endl;
             unsigned int difference = video_count - 2;
             unsigned int delete_count = 0;
             for (unsigned int i = rentals_vector.size() - 1; i > 0; i--) {
                 Item *item = get_item_with_id(items, rentals_vector[i]);
                 if (delete_count == difference) {
-                    std::cout << "[LOG] Excess videos deleted." << std::endl;
+                    log << "[LOG] Excess videos deleted." << std::endl;
                     break;
                 }
                 if (item->get_type() == ItemType::VIDEO) {
-                    std::cout << "[LOG] " << "Removing video: " << rentals_vector[i] << std::endl;
+                    log << "[LOG] " << "Removing video: " << rentals_vector[i] << std::endl;
                     rentals_vector.erase(rentals_vector.begin() + i);
                     delete_count++;
                 }
@@ -283,179 +826,684 @@ Customer *load_customer(
     }
 
     if (std::stoi(customer_vector[4]) < rentals_vector.size()) {
-        std::cout
+        log
                 << "[ERROR] "
                 << customer_vector[0]
                 << "'s number of rentals is smaller than actual items after customer info!"
                 << std::endl;
-        std::cout << "[LOG] Number of rentals: " << customer_vector[4] << std::endl;
-        std::cout << "[LOG] Actual items: " << rentals_vector.size() << std::endl;
+        log << "[LOG] Number of rentals: " << customer_vector[4] << std::endl;
+        log << "[LOG] Actual items: " << rentals_vector.size() << std::endl;
         unsigned int difference = rentals_vector.size() - std::stoi(customer_vector[4]), i = 0;
         for (; i < difference; i++) {
             rentals_vector.pop_back();
         }
-        std::cout << "[LOG] Will only store " << rentals_vector.size() << " item(s): " << std::endl;
-        for (const std::string &item : rentals_vector) {
-            std::cout << "+ " << item << ::std::endl;
+        log << "[LOG] Will only store " << rentals_vector.size() << " item(s): " << std::endl;
+        for (ItemId item : rentals_vector) {
+            log << "+ " << item << ::std::endl;
         }
     } else if (std::stoi(customer_vector[4]) > rentals_vector.size()) {
-        std::cout
+        log
                 << "[ERROR] " << customer_vector[0]
                 << "'s number of rentals is bigger than actual items after customer info! "
                 << std::endl;
-        std::cout << "[LOG] Number of rentals: " << customer_vector[4] << std::endl;
-        std::cout << "[LOG] Actual items: " << rentals_vector.size() << std::endl;
+        log << "[LOG] Number of rentals: " << customer_vector[4] << std::endl;
+        log << "[LOG] Actual items: " << rentals_vector.size() << std::endl;
         customer_vector[4] = std::to_string(rentals_vector.size());
-        std::cout << "[LOG] Changed " << customer_vector[0] << " 's number of rentals to " << rentals_vector.size()
+        log << "[LOG] Changed " << customer_vector[0] << " 's number of rentals to " << rentals_vector.size()
                   << std::endl;
     }
 
-    std::cout << "[INFO] Loaded Customer: " << customer_vector[0] << items_quantity_msg << std::endl;
-    for (const std::string &item : rentals_vector) {
-        std::cout << "+ " << item << ::std::endl;
+    log << "[INFO] Loaded Customer: " << customer_vector[0] << items_quantity_msg << std::endl;
+    for (ItemId item : rentals_vector) {
+        log << "+ " << item << ::std::endl;
         Item *new_item = get_item_with_id(items, item);
         rental_items.push_back(new_item);
     }
 
 
     if (customer_vector[customer_vector.size() - 1] == "Guest") {
-        std::cout << "[SUCCESS] Successfully created Guest customer with ID: " << customer_vector[0] << std::endl;
-        CustomerState *guestState = new GuestState;
-        auto *guest_customer = new Customer(
+        log << "[SUCCESS] Successfully created Guest customer with ID: " << customer_vector[0] << std::endl;
+        CustomerState *guestState = create_in<GuestState>(arena);
+        auto *guest_customer = create_in<Customer>(arena,
                 customer_vector[0],
                 customer_vector[1],
                 customer_vector[2],
                 customer_vector[3],
                 std::stoi(customer_vector[4]),
                 rental_items,
-                guestState);
+                guestState,
+                arena == nullptr);
         return guest_customer;
     } else if (customer_vector[customer_vector.size() - 1] == "Regular") {
-        std::cout << "[SUCCESS] Successfully created Regular customer with ID: " << customer_vector[0] << std::endl;
-        CustomerState *regularState = new RegularState;
-        auto *regular_customer = new Customer(
+        log << "[SUCCESS] Successfully created Regular customer with ID: " << customer_vector[0] << std::endl;
+        CustomerState *regularState = create_in<RegularState>(arena);
+        auto *regular_customer = create_in<Customer>(arena,
                 customer_vector[0],
                 customer_vector[1],
                 customer_vector[2],
                 customer_vector[3],
                 std::stoi(customer_vector[4]),
                 rental_items,
-                regularState);
+                regularState,
+                arena == nullptr);
         return regular_customer;
     } else if (customer_vector[customer_vector.size() - 1] == "VIP") {
-        std::cout << "[SUCCESS] Successfully created VIP customer with ID: " << customer_vector[0] << std::endl;
-        CustomerState *vipState = new VIPState;
-        auto *vip_customer = new Customer(
+        log << "[SUCCESS] Successfully created VIP customer with ID: " << customer_vector[0] << std::endl;
+        CustomerState *vipState = create_in<VIPState>(arena);
+        auto *vip_customer = create_in<Customer>(arena,
                 customer_vector[0],
                 customer_vector[1],
                 customer_vector[2],
                 customer_vector[3],
                 std::stoi(customer_vector[4]),
                 rental_items,
-                vipState);
+                vipState,
+                arena == nullptr);
         return vip_customer;
     }
 
     return nullptr;
 }
 
+//Add the item of a rental line to the rentals of the customer being loaded,
+//unless its id is invalid, it is already rented or no item has this id
+static void add_loaded_rental(std::string_view line, unsigned int line_number, const ItemIndex &item_index,
+                              HashIndex<ItemId, bool> &rented, std::vector<ItemId> &rentals_vector,
+                              std::ostream &log = std::cout) {
+    ItemId item_key;
+    if (item_id_is_valid(line, {}, true, log) && encode_item_id(line, item_key)) {
+        // check for duplicate items
+        if (rented.contains(item_key)) {
+            log << "[ERROR] Duplicate item: " << line << ", ignoring line " << line_number << std::endl;
+            // check if item does not exists
+        } else if (!item_exists_with_id(item_index, item_key)) {
+            log << "[ERROR] No item exists with ID: " << line << " ignoring line " << line_number << std::endl;
+        } else {
+            rentals_vector.push_back(item_key);
+            rented.insert(item_key, true);
+        }
+    }
+}
+
 //Implementation of CustomerPersistence
 //This is responsible for loading and saving
 //customers from and to a text file
-std::vector<Customer *> TextFileCustomerPersistence::load(std::vector<Item *> items) {
+std::vector<Customer *> TextFileCustomerPersistence::load(std::vector<Item *> const &items, Arena &arena) {
     std::ifstream infile("../textfiles/customers.txt");
     if (!infile) {
         std::cerr << "Cannot read file customers.txt" << std::endl;
         return {};
     }
     std::cout << "[INFO] Loading customers from customer.txt..." << std::endl;
-    unsigned int count = 1;
-    unsigned int x = 0;
+    //Index the items once so every rental is resolved in O(1)
+    const ItemIndex item_index = build_item_index(items);
     std::vector<Customer *> mockCustomers;
+
+    //The file is read a line at a time, so only the current line and customer are held:
+    //a valid customer line opens a customer, the item lines after it are its rentals,
+    //and the next customer line (or the end of the file) creates it.
+    //Lines before the first customer and after an invalid one belong to no customer
+    enum class State { NoCustomer, InCustomer };
+    State state = State::NoCustomer;
     std::string line;
-    std::vector<std::string> lines;
+    unsigned int line_number = 0;
     std::vector<std::string> customer_vector;
-    std::vector<std::string> rentals_vector;
+    std::vector<ItemId> rentals_vector;
+    //Rentals of the current customer, to find the duplicates without a scan
+    HashIndex<ItemId, bool> rented;
     std::string items_quantity_msg;
 
+    auto create_customer = [&]() {
+        Customer *customer = load_customer(customer_vector, rentals_vector, item_index, items_quantity_msg, &arena);
+        if (customer != nullptr) {
+            mockCustomers.push_back(customer);
+        } else {
+            std::cout << "[FATAL] Something went wrong creating new customer" << std::endl;
+        }
+    };
+
     while (getline(infile, line)) {
         remove_carriage_return(line);
-        lines.push_back(line);
-    }
-
-    for (x = 0; x < lines.size(); x++) {
-        // search vector until C is reached, ignoring the rest of data prior to first C
-        if (lines[x][0] == '#') {
-            std::cout << "[LOG] Ignoring line " << count << " (starts with #): " << lines[x] << std::endl;
-        } else if (lines[x][0] == 'C') {
+        line_number++;
+        if (line.empty()) {
+            continue;
+        }
+        if (line[0] == '#') {
+            std::cout << "[LOG] Ignoring line " << line_number << " (starts with #): " << line << std::endl;
+        } else if (line[0] == 'C') {
             // customer and items have been loaded
-            if (!customer_vector.empty()) {
-                Customer *customer = load_customer(customer_vector, rentals_vector, items, items_quantity_msg);
-                if (customer != nullptr) {
-                    mockCustomers.push_back(customer);
-                } else {
-                    std::cout << "[FATAL] Something went wrong creating new customer" << std::endl;
-                }
+            if (state == State::InCustomer) {
+                create_customer();
             }
-            // clear customer_vector and rentals_vector for next customer
-            customer_vector.clear();
             rentals_vector.clear();
-            // change customer into a customer vector
-            if (valid_customer_data(lines[x])) customer_vector = get_customer_as_vector(lines[x]);
-            else
+            rented.clear();
+            // the line is tokenized once, by the validation
+            if (valid_customer_data(line, customer_vector)) {
+                state = State::InCustomer;
+            } else {
+                state = State::NoCustomer;
                 std::cout << "[ERROR] Invalid customer info at line ["
-                          << x + 1
+                          << line_number
                           << "]. Any dangling items or info that is not a customer info will be ignored"
                           << std::endl;
-
-        } else if (lines[x][0] == 'I') {
-            if (item_id_is_valid(lines[x])) {
-                // check for duplicate items
-                if (already_have_item(rentals_vector, lines[x])) {
-                    std::cout << "[ERROR] Duplicate item: " << lines[x] << ", ignoring line " << x << std::endl;
-                    // check if item does not exists
-                } else if (!item_exists_with_id(items, lines[x])) {
-                    std::cout << "[ERROR] No item exists with ID: " << lines[x] << " ignoring line " << x << std::endl;
-                } else {
-                    rentals_vector.push_back(lines[x]);
-                }
-            }
-        }
-        // for the final customer
-        if (!customer_vector.empty() && x == lines.size() - 1) {
-            Customer *customer = load_customer(customer_vector, rentals_vector, items, items_quantity_msg);
-            if (customer != nullptr) {
-                mockCustomers.push_back(customer);
-            } else {
-                std::cout << "[FATAL] Something went wrong creating new customer" << std::endl;
             }
+        } else if (line[0] == 'I' && state == State::InCustomer) {
+            add_loaded_rental(line, line_number, item_index, rented, rentals_vector);
         }
     }
+    // for the final customer
+    if (state == State::InCustomer) {
+        create_customer();
+    }
     std::cout << "[INFO] Done loading customers!" << std::endl;
     infile.close();
-    std::cout << "[INFO] Rewriting content of customers.txt..." << std::endl;
-    this->save(mockCustomers);
     return mockCustomers;
 }
 
+//Render the customers as they are written to customers.txt
+static void render_customer_file(std::vector<Customer *> const &customers, OutputBuffer &out) {
+    for (unsigned int i = 0; i < customers.size(); i++) {
+        customers[i]->render_file(out);
+        // no newline EOF
+        if (i < customers.size() - 1 && customers[i]->get_number_of_rentals() != 0) {
+            out.append('\n');
+        }
+        out.end_record();
+    }
+}
+
 //Implementation of CustomerPersistence
 //This is responsible for loading and saving
 //customers from and to a text file
-void TextFileCustomerPersistence::save(std::vector<Customer *> customers) {
-    std::ofstream outfile("../textfiles/customers.txt", std::ios::trunc);
-    if (!outfile) {
-        std::cerr << "[ERROR] Cannot write to file items_out.txt" << std::endl;
+void TextFileCustomerPersistence::save(std::vector<Customer *> const &customers) {
+    //Render every customer into one buffer, then replace the file with it so a failed
+    //write leaves the previous customers.txt in place
+    OutputBuffer out;
+    render_customer_file(customers, out);
+    if (!replace_file("../textfiles/customers.txt", out.view())) {
+        std::cerr << "[ERROR] Cannot write to file customers.txt" << std::endl;
         return;
     }
-    unsigned int i = 0;
-    std::string state;
-    for (; i < customers.size(); i++) {
-        outfile << customers[i]->to_string_file();
-        // no newline EOF
-        if (i < customers.size() - 1 && customers[i]->get_number_of_rentals() != 0) {
-            outfile << "\n";
+    std::cout << "[SUCCESS] Successfully saved customers.txt!" << std::endl;
+}
+
+PendingFile TextFileCustomerPersistence::render(std::vector<Customer *> const &customers,
+                                                std::vector<Item *> const &items) {
+    OutputBuffer out;
+    render_customer_file(customers, out);
+    return {"../textfiles/customers.txt", out.str()};
+}
+
+std::size_t CustomerService::count(FilterSpecification const *spec) {
+    //Popcount of the bitmap when the bitmap index can answer, otherwise filter
+    Bitmap bits;
+    if (spec->bitmap(*repository, bits)) {
+        return bits.count();
+    }
+    return filterer->filter(*repository, spec, last_plan).size();
+}
+
+//Layout of customers.idx: a header, then one record per customer of customers.txt, sorted by id
+//The header holds the size and time of customers.txt when the index was built
+struct CustomerIndexHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t record_count;
+    std::uint64_t file_size;
+    std::int64_t file_time;
+};
+
+struct CustomerIndexRecord {
+    std::uint32_t id;
+    //Line number of the customer line, for the messages
+    std::uint32_t line;
+    //Position of the customer line in customers.txt
+    std::uint64_t offset;
+};
+
+static const char customer_index_magic[8] = {'C', 'S', 'T', 'M', 'I', 'D', 'X', '\0'};
+static const std::uint32_t customer_index_version = 1;
+
+static CustomerIndexRecord read_index_record(char const *records, std::uint32_t i) {
+    CustomerIndexRecord record;
+    std::memcpy(&record, records + (std::size_t) i * sizeof(CustomerIndexRecord), sizeof(record));
+    return record;
+}
+
+//Size and time of the data file, compared with the ones stored in the index
+static bool data_file_stamp(std::string const &path, std::uint64_t &size, std::int64_t &time) {
+    std::error_code error;
+    size = std::filesystem::file_size(path, error);
+    if (error) {
+        return false;
+    }
+    time = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+    return !error;
+}
+
+LazyCustomerRepository::LazyCustomerRepository(std::size_t cache_size) :
+        cache_size(cache_size == 0 ? 1 : cache_size) {}
+
+LazyCustomerRepository::~LazyCustomerRepository() {
+    clear();
+}
+
+void LazyCustomerRepository::clear() {
+    //Customers created in the arena are released together with it
+    cache.for_each([this](CustomerId, CachedCustomer const &entry) {
+        if (!arena.owns(entry.customer)) {
+            delete entry.customer;
+        }
+    });
+    for (Customer *customer : retired) {
+        if (!arena.owns(customer)) {
+            delete customer;
         }
     }
-    std::cout << "[SUCCESS] Successfully saved customers.txt!" << std::endl;
-    outfile.close();
+    cache.clear();
+    recently_used.clear();
+    removed.clear();
+    added.clear();
+    retired.clear();
+    customers.clear();
+}
+
+bool LazyCustomerRepository::open(std::vector<Item *> const &items) {
+    item_index = build_item_index(items);
+    if (!file.open(path)) {
+        std::cerr << "Cannot read file customers.txt" << std::endl;
+        return true;
+    }
+    if (!open_index()) {
+        std::cout << "[INFO] Indexing customers.txt..." << std::endl;
+        build_index();
+    }
+    std::cout << "[INFO] " << index_count << " customers indexed, loaded when they are used" << std::endl;
+    return true;
+}
+
+bool LazyCustomerRepository::open_index() {
+    if (!index_file.open(index_path)) {
+        return false;
+    }
+    std::string_view contents = index_file.contents();
+    CustomerIndexHeader header{};
+    if (contents.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, contents.data(), sizeof(header));
+
+    //The index must have been built from the customers.txt which is there now
+    std::uint64_t file_size;
+    std::int64_t file_time;
+    if (std::memcmp(header.magic, customer_index_magic, sizeof(header.magic)) != 0
+        || header.version != customer_index_version
+        || contents.size() != sizeof(header) + (std::size_t) header.record_count * sizeof(CustomerIndexRecord)
+        || !data_file_stamp(path, file_size, file_time)
+        || header.file_size != file_size || header.file_time != file_time) {
+        index_file.close();
+        return false;
+    }
+    index_records = contents.data() + sizeof(header);
+    index_count = header.record_count;
+    return true;
+}
+
+//Id of a customer line, return false if it can not be packed
+static bool customer_line_id(std::string_view line, CustomerId &key) {
+    std::string_view id = line.substr(0, line.find(','));
+    if (!id.empty() && id.back() == ' ') {
+        id.remove_suffix(1);
+    }
+    return encode_customer_id(id, key);
+}
+
+void LazyCustomerRepository::build_index() {
+    //One pass over the customer lines, only their ids are read
+    std::vector<CustomerIndexRecord> records;
+    std::string_view contents = file.contents();
+    std::string_view text = contents;
+    std::string_view line;
+    std::uint32_t line_number = 0;
+    while (next_line(text, line)) {
+        line_number++;
+        if (line.empty() || line[0] != 'C') {
+            continue;
+        }
+        CustomerId key;
+        if (customer_line_id(line, key)) {
+            records.push_back({key.value, line_number, (std::uint64_t) (line.data() - contents.data())});
+        }
+    }
+
+    //Sort by id, the first customer line of an id is the one loaded
+    std::stable_sort(records.begin(), records.end(), [](CustomerIndexRecord const &a, CustomerIndexRecord const &b) {
+        return a.id < b.id;
+    });
+    records.erase(std::unique(records.begin(), records.end(),
+                              [](CustomerIndexRecord const &a, CustomerIndexRecord const &b) {
+                                  return a.id == b.id;
+                              }), records.end());
+
+    CustomerIndexHeader header{};
+    std::memcpy(header.magic, customer_index_magic, sizeof(header.magic));
+    header.version = customer_index_version;
+    header.record_count = (std::uint32_t) records.size();
+    data_file_stamp(path, header.file_size, header.file_time);
+
+    built_index.assign(reinterpret_cast<char const *>(&header), sizeof(header));
+    built_index.append(reinterpret_cast<char const *>(records.data()), records.size() * sizeof(CustomerIndexRecord));
+    if (!replace_file(index_path, built_index)) {
+        std::cerr << "[ERROR] Cannot write to file customers.idx" << std::endl;
+    }
+    index_records = built_index.data() + sizeof(header);
+    index_count = header.record_count;
+}
+
+bool LazyCustomerRepository::find_record(CustomerId key, std::uint64_t &offset, std::uint32_t &line) const {
+    //Binary search over the records sorted by id
+    std::uint32_t low = 0, high = index_count;
+    while (low < high) {
+        std::uint32_t middle = low + (high - low) / 2;
+        CustomerIndexRecord record = read_index_record(index_records, middle);
+        if (record.id < key.value) {
+            low = middle + 1;
+        } else if (record.id > key.value) {
+            high = middle;
+        } else {
+            offset = record.offset;
+            line = record.line;
+            return true;
+        }
+    }
+    return false;
+}
+
+Customer *LazyCustomerRepository::read_customer(std::uint64_t offset, std::uint32_t line_number) {
+    std::string_view text = file.contents();
+    if (offset >= text.size()) {
+        return nullptr;
+    }
+    text.remove_prefix(offset);
+
+    //The customer line, then its rentals until the next customer line, read quietly so
+    //a lookup does not print the problems of the file in the middle of the menu
+    std::ostream quiet(nullptr);
+    std::string_view line;
+    next_line(text, line);
+    std::vector<std::string> customer_vector;
+    if (!valid_customer_data(std::string(line), customer_vector, quiet)) {
+        return nullptr;
+    }
+    std::vector<ItemId> rentals_vector;
+    HashIndex<ItemId, bool> rented;
+    while (next_line(text, line)) {
+        line_number++;
+        if (line.empty()) {
+            continue;
+        }
+        if (line[0] == 'C') {
+            break;
+        }
+        if (line[0] == 'I') {
+            add_loaded_rental(line, line_number, item_index, rented, rentals_vector, quiet);
+        }
+    }
+
+    //On the heap so it can be dropped from the cache
+    return load_customer(customer_vector, rentals_vector, item_index, "", nullptr, quiet);
+}
+
+void LazyCustomerRepository::cache_customer(Customer *customer, bool kept) {
+    CachedCustomer entry;
+    entry.customer = customer;
+    entry.kept = kept;
+    if (!kept) {
+        recently_used.push_front(customer->get_key());
+        entry.position = recently_used.begin();
+    }
+    cache.insert(customer->get_key(), entry);
+}
+
+void LazyCustomerRepository::keep(CustomerId key) {
+    CachedCustomer *entry = cache.find(key);
+    if (entry != nullptr && !entry->kept) {
+        recently_used.erase(entry->position);
+        entry->kept = true;
+    }
+}
+
+void LazyCustomerRepository::drop_least_recently_used() {
+    while (recently_used.size() > cache_size) {
+        CustomerId key = recently_used.back();
+        recently_used.pop_back();
+        CachedCustomer *entry = cache.find(key);
+        delete entry->customer;
+        cache.erase(key);
+    }
+}
+
+Customer *LazyCustomerRepository::get_customer(std::string const &id) {
+    //An id that can not be packed does not belong to any customer
+    CustomerId key;
+    if (!encode_customer_id(id, key)) {
+        return nullptr;
+    }
+
+    //Move a cached customer to the front of the recently used list
+    if (CachedCustomer *entry = cache.find(key)) {
+        if (!entry->kept) {
+            recently_used.splice(recently_used.begin(), recently_used, entry->position);
+        }
+        return entry->customer;
+    }
+
+    //Otherwise read it from the file
+    std::uint64_t offset;
+    std::uint32_t line;
+    if (complete || removed.contains(key) || !find_record(key, offset, line)) {
+        return nullptr;
+    }
+    Customer *customer = read_customer(offset, line);
+    if (customer == nullptr) {
+        return nullptr;
+    }
+    cache_customer(customer, false);
+    drop_least_recently_used();
+    return customer;
+}
+
+void LazyCustomerRepository::set_customers(std::vector<Customer *> const &new_customers) {
+    //Every customer is given, nothing is read from the file any more
+    clear();
+    for (Customer *customer : new_customers) {
+        if (!cache.contains(customer->get_key())) {
+            cache_customer(customer, true);
+            customers.push_back(customer);
+        }
+    }
+    complete = true;
+}
+
+void LazyCustomerRepository::add_customer(Customer *customer) {
+    //Nothing to add (e.g. the user cancelled the input)
+    if (customer == nullptr) {
+        return;
+    }
+
+    //Ignore the customer if the id is already taken
+    if (get_customer(customer->get_id()) != nullptr) {
+        std::cerr << "Customer with the same id already exists" << std::endl;
+        return;
+    }
+    cache_customer(customer, true);
+    added.push_back(customer);
+    if (complete) {
+        customers.push_back(customer);
+    }
+    mark_changed();
+}
+
+void LazyCustomerRepository::remove_customer(std::string const &customer_id) {
+    Customer *customer = get_customer(customer_id);
+
+    //Display error if element does not exist
+    if (customer == nullptr) {
+        std::cerr << "User does not exist" << std::endl;
+        return;
+    }
+
+    //The record of the file is hidden, the customer itself is deleted with the repository
+    CustomerId key = customer->get_key();
+    CachedCustomer *entry = cache.find(key);
+    if (!entry->kept) {
+        recently_used.erase(entry->position);
+    }
+    cache.erase(key);
+    std::uint64_t offset;
+    std::uint32_t line;
+    if (find_record(key, offset, line)) {
+        removed.insert(key, true);
+    }
+    added.erase(std::remove(added.begin(), added.end(), customer), added.end());
+    customers.erase(std::remove(customers.begin(), customers.end(), customer), customers.end());
+    retired.push_back(customer);
+    mark_changed();
+}
+
+void LazyCustomerRepository::update_customer(std::string const &customer_id, ModificationIntent &intent) {
+    //Find the customer
+    Customer *customer = get_customer(customer_id);
+
+    //Update if element exists, and keep it since the file does not have the change
+    if (customer != nullptr) {
+        intent.set_customer(customer);
+        intent.modify();
+        keep(customer->get_key());
+        mark_changed();
+    } else {
+        std::cerr << "User does not exist" << std::endl;
+    }
+}
+
+void LazyCustomerRepository::customer_changed(Customer *customer) {
+    keep(customer->get_key());
+    mark_changed();
+}
+
+bool LazyCustomerRepository::render(PendingFile &pending) {
+    //Once every customer is in memory the persistence renders them
+    if (complete) {
+        return false;
+    }
+
+    //Records are separated by a line break, like the persistence writes them
+    OutputBuffer out;
+    auto separate = [&out]() {
+        if (!out.view().empty() && out.view().back() != '\n') {
+            out.append('\n');
+        }
+    };
+
+    //The records of the file in file order: the customer line and its rentals, up to the
+    //next customer line. Kept customers are rendered from memory, the others are copied
+    //as they are, and the lines a load ignores (before the first customer, of a repeated
+    //id or of an invalid customer line) are dropped
+    std::ostream quiet(nullptr);
+    std::vector<std::string> fields;
+    std::string_view contents = file.contents();
+    std::string_view text = contents;
+    std::string_view line;
+    std::size_t begin = std::string_view::npos, end = 0;
+    auto copy_record = [&]() {
+        if (begin != std::string_view::npos) {
+            separate();
+            out.append(contents.substr(begin, end - begin));
+            out.end_record();
+            begin = std::string_view::npos;
+        }
+    };
+    while (next_line(text, line)) {
+        auto offset = (std::size_t) (line.data() - contents.data());
+        if (line.empty() || line[0] != 'C') {
+            if (begin != std::string_view::npos && !line.empty()) {
+                end = offset + line.size();
+            }
+            continue;
+        }
+        copy_record();
+
+        CustomerId key;
+        std::uint64_t record_offset;
+        std::uint32_t line_number;
+        if (!customer_line_id(line, key) || !find_record(key, record_offset, line_number)
+            || record_offset != offset || removed.contains(key)) {
+            continue;
+        }
+        CachedCustomer *entry = cache.find(key);
+        if (entry != nullptr && entry->kept) {
+            separate();
+            entry->customer->render_file(out);
+            out.end_record();
+        } else if (entry != nullptr || valid_customer_data(std::string(line), fields, quiet)) {
+            begin = offset;
+            end = offset + line.size();
+        }
+    }
+    copy_record();
+
+    //Then the customers which are not in the file
+    for (Customer *customer : added) {
+        separate();
+        customer->render_file(out);
+        out.end_record();
+    }
+    pending = {path, out.str()};
+    return true;
+}
+
+std::vector<Customer *> const &LazyCustomerRepository::get_customers() {
+    read_all();
+    return customers;
+}
+
+void LazyCustomerRepository::read_all() {
+    if (complete) {
+        return;
+    }
+
+    //The customers of the file in file order, then the ones added
+    std::vector<CustomerIndexRecord> records;
+    records.reserve(index_count);
+    for (std::uint32_t i = 0; i < index_count; i++) {
+        records.push_back(read_index_record(index_records, i));
+    }
+    std::sort(records.begin(), records.end(), [](CustomerIndexRecord const &a, CustomerIndexRecord const &b) {
+        return a.offset < b.offset;
+    });
+
+    customers.clear();
+    customers.reserve(records.size() + added.size());
+    for (CustomerIndexRecord const &record : records) {
+        CustomerId key(record.id);
+        if (removed.contains(key)) {
+            continue;
+        }
+        if (CachedCustomer *entry = cache.find(key)) {
+            customers.push_back(entry->customer);
+        } else if (Customer *customer = read_customer(record.offset, record.line)) {
+            cache_customer(customer, true);
+            customers.push_back(customer);
+        }
+    }
+    for (Customer *customer : added) {
+        customers.push_back(customer);
+    }
+
+    //Every customer is kept from now on
+    for (CustomerId key : recently_used) {
+        cache.find(key)->kept = true;
+    }
+    recently_used.clear();
+    complete = true;
 }
@@ -0,0 +1,107 @@
+#include "../headers/FileWriter.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <filesystem>
+#include <unistd.h>
+
+//Directory holding a file, to sync the renames made in it
+static std::string directory_of(std::string const &path) {
+    std::string directory = std::filesystem::path(path).parent_path().string();
+    return directory.empty() ? "." : directory;
+}
+
+bool write_all(int descriptor, std::string_view contents) {
+    while (!contents.empty()) {
+        std::size_t chunk = contents.size() < FileBatch::write_chunk_size ? contents.size()
+                                                                          : FileBatch::write_chunk_size;
+        ssize_t written = ::write(descriptor, contents.data(), chunk);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        contents.remove_prefix((std::size_t) written);
+    }
+    return true;
+}
+
+FileBatch::~FileBatch() {
+    discard();
+}
+
+bool FileBatch::add(std::string const &path, std::string_view contents) {
+    std::string temporary = path + ".tmp";
+    int descriptor = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (descriptor == -1) {
+        return false;
+    }
+    if (!write_all(descriptor, contents)) {
+        ::close(descriptor);
+        std::remove(temporary.c_str());
+        return false;
+    }
+    files.push_back({path, std::move(temporary), descriptor});
+    return true;
+}
+
+bool FileBatch::commit() {
+    //Every file is on the disk before any of them is renamed
+    for (auto const &file : files) {
+        if (::fsync(file.descriptor) != 0) {
+            discard();
+            return false;
+        }
+    }
+
+    std::vector<std::string> directories;
+    for (auto &file : files) {
+        ::close(file.descriptor);
+        file.descriptor = -1;
+        if (std::rename(file.temporary.c_str(), file.path.c_str()) != 0) {
+            discard();
+            return false;
+        }
+        std::string directory = directory_of(file.path);
+        if (std::find(directories.begin(), directories.end(), directory) == directories.end()) {
+            directories.push_back(std::move(directory));
+        }
+        file.temporary.clear();
+    }
+    files.clear();
+
+    bool synced = true;
+    for (auto const &directory : directories) {
+        synced = sync_path(directory, true) && synced;
+    }
+    return synced;
+}
+
+void FileBatch::discard() {
+    for (auto const &file : files) {
+        if (file.descriptor != -1) {
+            ::close(file.descriptor);
+        }
+        if (!file.temporary.empty()) {
+            std::remove(file.temporary.c_str());
+        }
+    }
+    files.clear();
+}
+
+bool replace_file(std::string const &path, std::string_view contents) {
+    FileBatch batch;
+    return batch.add(path, contents) && batch.commit();
+}
+
+bool sync_path(std::string const &path, bool directory) {
+    int descriptor = ::open(path.c_str(), directory ? O_RDONLY | O_DIRECTORY : O_RDONLY);
+    if (descriptor == -1) {
+        return false;
+    }
+    bool synced = ::fsync(descriptor) == 0;
+    ::close(descriptor);
+    return synced;
+}
@@ -2,23 +2,67 @@
 #include "../headers/ItemHelpers.h"
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
 
 //For items
-Item::Item(std::string id, std::string title, RentalType rental_type, unsigned int stock, float fee,
+Item::Item(std::string_view id, std::string_view title, RentalType rental_type, unsigned int stock, float fee,
            RentalStatus status) :
-        id(std::move(id)), title(std::move(title)), rental_type(rental_type), number_in_stock(stock), rental_fee(fee),
+        title(string_pool().intern(title)), rental_type(rental_type), number_in_stock(stock), rental_fee(fee),
+        rental_status(status) {
+    if (!encode_item_id(id, this->id)) {
+        throw std::invalid_argument("Item ID is incorrect format: " + std::string(id));
+    }
+}
+
+Item::Item(ItemId id, std::string_view title, RentalType rental_type, unsigned int stock, float fee,
+           RentalStatus status) :
+        id(id), title(string_pool().intern(title)), rental_type(rental_type), number_in_stock(stock), rental_fee(fee),
         rental_status(status) {}
 
-std::string Item::to_string_console() const {
-    std::ostringstream oss;
-    oss << "ID: " << id << ", ";
-    oss << "Title: " << title << ", ";
-    oss << "Rental type: " << (rental_type == Item::RentalType::TwoDay ? "Two day" : "One week") << ", ";
-    oss << "Stock: " << number_in_stock << ", ";
-    oss << "Fee: " << rental_fee << ", ";
-    oss << "Rental status: " << (rental_status == Item::RentalStatus::Available ? "Available" : "Borrowed");
+void Item::render_console_fields(OutputBuffer &out) const {
+    char id_text[ItemId::length];
+    write_item_id(id, id_text);
+    out.append("ID: ");
+    out.append(std::string_view(id_text, ItemId::length));
+    out.append(", Title: ");
+    out.append(get_title());
+    out.append(", Rental type: ");
+    out.append(rental_type == Item::RentalType::TwoDay ? "Two day" : "One week");
+    out.append(", Stock: ");
+    out.append_unsigned(number_in_stock);
+    out.append(", Fee: ");
+    out.append_general(rental_fee);
+    out.append(", Rental status: ");
+    out.append(rental_status == Item::RentalStatus::Available ? "Available" : "Borrowed");
+}
+
+//File fields: id, title, type, rental type, stock and fee
+void Item::render_file_fields(OutputBuffer &out, std::string_view type) const {
+    char id_text[ItemId::length];
+    write_item_id(id, id_text);
+    out.append(std::string_view(id_text, ItemId::length));
+    out.append(',');
+    out.append(get_title());
+    out.append(',');
+    out.append(type);
+    out.append(',');
+    out.append(rental_type_to_string(rental_type));
+    out.append(',');
+    out.append_unsigned(number_in_stock);
+    out.append(',');
+    out.append_fixed(rental_fee);
+}
+
+std::string Item::to_string_file() const {
+    OutputBuffer out;
+    render_file(out);
+    return out.str();
+}
 
-    return oss.str();
+std::string Item::to_string_console() const {
+    OutputBuffer out;
+    render_console(out);
+    return out.str();
 }
 
 std::ostream &operator<<(std::ostream &os, Item const &item) {
@@ -26,12 +70,24 @@ std::ostream &operator<<(std::ostream &os, Item const &item) {
 }
 
 //For Genred Item
-GenredItem::GenredItem(std::string id, std::string title, RentalType rental_type, unsigned int stock, float fee,
+GenredItem::GenredItem(std::string_view id, std::string_view title, RentalType rental_type, unsigned int stock, float fee,
+                       RentalStatus status, Genre genre) :
+        Item(id, title, rental_type, stock, fee, status), genre(genre) {}
+
+GenredItem::GenredItem(ItemId id, std::string_view title, RentalType rental_type, unsigned int stock, float fee,
                        RentalStatus status, Genre genre) :
-        Item(std::move(id), std::move(title), rental_type, stock, fee, status), genre(genre) {}
+        Item(id, title, rental_type, stock, fee, status), genre(genre) {}
 
-std::string GenredItem::to_string_console() const {
-    return {Item::to_string_console() + ", Genre: " + genre_to_string(genre)};
+void GenredItem::render_file_fields(OutputBuffer &out, std::string_view type) const {
+    Item::render_file_fields(out, type);
+    out.append(',');
+    out.append(genre_to_string(genre));
+}
+
+void GenredItem::render_console_fields(OutputBuffer &out) const {
+    Item::render_console_fields(out);
+    out.append(", Genre: ");
+    out.append(genre_to_string(genre));
 }
 
 std::ostream &operator<<(std::ostream &os, GenredItem const &genredItem) {
@@ -39,19 +95,14 @@ std::ostream &operator<<(std::ostream &os, GenredItem const &genredItem) {
 }
 
 //For game
-std::string Game::to_string_console() const {
-    return {"Game: [" + Item::to_string_console() + "]"};
+void Game::render_console(OutputBuffer &out) const {
+    out.append("Game: [");
+    render_console_fields(out);
+    out.append(']');
 }
 
-std::string Game::to_string_file() const {
-    return {
-            this->get_id() + "," +
-            this->get_title() + "," +
-            "Game" + "," +
-            rental_type_to_string(this->rental_type) + "," +
-            std::to_string(this->get_number_in_stock()) + "," +
-            std::to_string(this->get_rental_fee())
-    };
+void Game::render_file(OutputBuffer &out) const {
+    render_file_fields(out, "Game");
 }
 
 ItemType Game::get_type() const { return GAME; }
@@ -61,20 +112,14 @@ std::ostream &operator<<(std::ostream &os, Game const &game) {
 }
 
 //For record
-std::string VideoRecord::to_string_console() const {
-    return {"Video record: [" + GenredItem::to_string_console() + "]"};
+void VideoRecord::render_console(OutputBuffer &out) const {
+    out.append("Video record: [");
+    render_console_fields(out);
+    out.append(']');
 }
 
-std::string VideoRecord::to_string_file() const {
-    return {
-            this->get_id() + "," +
-            this->get_title() + "," +
-            "Record" + "," +
-            rental_type_to_string(this->rental_type) + "," +
-            std::to_string(this->get_number_in_stock()) + "," +
-            std::to_string(this->get_rental_fee()) + "," +
-            genre_to_string(this->get_genre())
-    };
+void VideoRecord::render_file(OutputBuffer &out) const {
+    render_file_fields(out, "Record");
 }
 
 ItemType VideoRecord::get_type() const { return VIDEO; }
@@ -84,20 +129,14 @@ std::ostream &operator<<(std::ostream &os, VideoRecord const &videoRecord) {
 }
 
 //For dvd
-std::string DVD::to_string_console() const {
-    return {"DVD: [" + GenredItem::to_string_console() + "]"};
-}
-
-std::string DVD::to_string_file() const {
-    return {
-            this->get_id() + "," +
-            this->get_title() + "," +
-            "DVD" + "," +
-            rental_type_to_string(this->rental_type) + "," +
-            std::to_string(this->get_number_in_stock()) + "," +
-            std::to_string(this->get_rental_fee()) + "," +
-            genre_to_string(this->get_genre())
-    };
+void DVD::render_console(OutputBuffer &out) const {
+    out.append("DVD: [");
+    render_console_fields(out);
+    out.append(']');
+}
+
+void DVD::render_file(OutputBuffer &out) const {
+    render_file_fields(out, "DVD");
 }
 
 ItemType DVD::get_type() const { return DISC; }
@@ -0,0 +1,46 @@
+#include "../headers/ItemColumns.h"
+
+/*
+	This component contains the selections and aggregations over
+	a column view of the items. Each one is a single pass over one or two
+	contiguous arrays, which the compiler can vectorize
+*/
+
+void ItemColumnView::select_stock_equal(unsigned int stock, std::vector<std::uint32_t> &rows) const {
+    for (std::uint32_t row = 0; row < size; row++) {
+        if (stocks[row] == stock) {
+            rows.push_back(row);
+        }
+    }
+}
+
+void ItemColumnView::select_all(std::vector<std::uint32_t> &rows) const {
+    rows.reserve(rows.size() + size);
+    for (std::uint32_t row = 0; row < size; row++) {
+        rows.push_back(row);
+    }
+}
+
+unsigned long long ItemColumnView::total_stock() const {
+    unsigned long long total = 0;
+    for (std::size_t row = 0; row < size; row++) {
+        total += stocks[row];
+    }
+    return total;
+}
+
+std::size_t ItemColumnView::count_in_stock() const {
+    std::size_t count = 0;
+    for (std::size_t row = 0; row < size; row++) {
+        count += stocks[row] > 0;
+    }
+    return count;
+}
+
+std::size_t ItemColumnView::count_available() const {
+    std::size_t count = 0;
+    for (std::size_t row = 0; row < size; row++) {
+        count += statuses[row] == (std::uint8_t) Item::RentalStatus::Available;
+    }
+    return count;
+}
@@ -3,8 +3,9 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <charconv>
 
-Item::RentalType string_to_rental_type(const std::string &string_rental_type) {
+Item::RentalType string_to_rental_type(std::string_view string_rental_type) {
     if (string_rental_type == "2-day") {
         return Item::RentalType::TwoDay;
     } else if (string_rental_type == "1-week") {
@@ -15,7 +16,7 @@ Item::RentalType string_to_rental_type(const std::string &string_rental_type) {
     return Item::RentalType::TwoDay;
 }
 
-std::string rental_type_to_string(Item::RentalType rental_type) {
+char const *rental_type_to_string(Item::RentalType rental_type) {
     switch (rental_type) {
         case Item::RentalType::TwoDay:
             return "2-day";
@@ -48,7 +49,7 @@ std::string rental_status_to_string(Item::RentalStatus rental_status) {
     }
 }
 
-GenredItem::Genre string_to_genre(const std::string &string_genre) {
+GenredItem::Genre string_to_genre(std::string_view string_genre) {
     if (string_genre == "Action") {
         return GenredItem::Genre::Action;
     } else if (string_genre == "Comedy") {
@@ -65,7 +66,7 @@ GenredItem::Genre string_to_genre(const std::string &string_genre) {
     }
 }
 
-std::string genre_to_string(GenredItem::Genre genre) {
+char const *genre_to_string(GenredItem::Genre genre) {
     switch (genre) {
         case GenredItem::Genre::Action:
             return "Action";
@@ -81,16 +82,10 @@ std::string genre_to_string(GenredItem::Genre genre) {
 }
 
 void remove_carriage_return(std::string &string) {
-    int index = 0;
-    for (char i : string) {
-        if (i == 13) {
-            string.erase(index, 1);
-        }
-        index++;
-    }
+    string.erase(std::remove(string.begin(), string.end(), '\r'), string.end());
 }
 
-bool correct_info_length(const std::string &line) {
+bool correct_info_length(std::string_view line) {
     const unsigned int comma_count = std::count(line.begin(), line.end(), ',');
     if (comma_count < 5 || comma_count > 6) {
         return false;
@@ -98,64 +93,63 @@ bool correct_info_length(const std::string &line) {
     return true;
 }
 
-bool id_number_is_not_numeric(const std::string &id_number) {
-    const std::string numerics = "0123456789";
-    return id_number.find_first_not_of(numerics) != std::string::npos;
+bool id_number_is_not_numeric(std::string_view id_number) {
+    return id_number.find_first_not_of("0123456789") != std::string_view::npos;
 }
 
-bool item_id_is_valid(const std::string &id, const std::vector<Item *> &mockItems, bool format_only) {
+bool item_id_is_valid(std::string_view id, const ItemIndex &loaded_items, bool format_only, std::ostream &log) {
     // format: Ixxx-yyyy
-    std::vector<std::string> id_pool;
-    std::string default_error = "[ERROR] Item ID is incorrect format ";
-    // id must be unique
-    if (!format_only) {
-        for (Item *item : mockItems) {
-            if (item != nullptr && item->get_id() == id) {
-                std::cout << default_error << "(already exists), received: " << id << std::endl;
-                return false;
-            }
-        }
-    }
+    const char *default_error = "[ERROR] Item ID is incorrect format ";
     // id length of item must be 9
     if (id.length() != 9) {
-        std::cout << default_error << "(wrong length), received: " << id << std::endl;
+        log << default_error << "(wrong length), received: " << id << std::endl;
         return false;
     }
 
     char first_letter = id[0];
-    const std::string id_number = id.substr(1, 3);
+    std::string_view id_number = id.substr(1, 3);
     char hyphen = id[4];
-    const std::string year = id.substr(5, 4);
+    std::string_view year = id.substr(5, 4);
 
     // first letter must be "I" (‘I’ is the capital letter I).
     if (first_letter != 'I') {
-        std::cout << default_error << "(must begin with 'I'), received: " << id << std::endl;
+        log << default_error << "(must begin with 'I'), received: " << id << std::endl;
         return false;
     }
 
     // ‘xxx’ is a unique code of 3 digits (e.g. 123)
     if (id_number_is_not_numeric(id_number)) {
-        std::cout << default_error << "(ID number in Item ID must be numerics), received: " << id << std::endl;
+        log << default_error << "(ID number in Item ID must be numerics), received: " << id << std::endl;
         return false;
     }
 
     // ‘-‘ is a single hyphen character
     if (hyphen != '-') {
-        std::cout << default_error << "(hyphen is missing), received: " << id << std::endl;
+        log << default_error << "(hyphen is missing), received: " << id << std::endl;
         return false;
     }
 
     // `yyyy` is the year the item was published (e.g. 1980)
     // first year ever made was in 1888, current year is 2021
     const unsigned int MAX_YEAR = 2021, MIN_YEAR = 1888;
-    try {
-        const unsigned int int_year = std::stoi(year, nullptr, 10);
-        if (int_year < MIN_YEAR || int_year > MAX_YEAR) {
-            std::cout << default_error << "(year must be between 1888 and 2021), received" << id << std::endl;
-            return false;
-        }
-    } catch (const std::invalid_argument &e) {
-        std::cout << default_error << "(year is in invalid format), received" << id << std::endl;
+    unsigned int int_year = 0;
+    if (std::from_chars(year.data(), year.data() + year.size(), int_year).ec != std::errc()) {
+        log << default_error << "(year is in invalid format), received" << id << std::endl;
+        return false;
+    }
+    if (int_year < MIN_YEAR || int_year > MAX_YEAR) {
+        log << default_error << "(year must be between 1888 and 2021), received" << id << std::endl;
+        return false;
+    }
+
+    // id must be unique, the check is done on the packed id
+    ItemId key;
+    if (!encode_item_id(id, key)) {
+        log << default_error << "(year is in invalid format), received" << id << std::endl;
+        return false;
+    }
+    if (!format_only && loaded_items.contains(key)) {
+        log << default_error << "(already exists), received: " << id << std::endl;
         return false;
     }
 
@@ -163,14 +157,15 @@ bool item_id_is_valid(const std::string &id, const std::vector<Item *> &mockItem
 }
 
 bool item_type_and_genre_is_valid(
-        const std::string &type,
-        const std::string &genre,
-        std::vector<std::string>::size_type item_info_length
+        std::string_view type,
+        std::string_view genre,
+        std::size_t item_info_length,
+        std::ostream &log
 ) {
-    const std::string &default_error = "[ERROR] Item Type/Genre is in invalid ";
-    const std::vector<std::string> allowed_games = {"Game", "game"};
-    const std::vector<std::string> allowed_videos_dvds = {"Record", "record", "DVD", "dvd"};
-    const std::vector<std::string> allowed_genres = {
+    const char *default_error = "[ERROR] Item Type/Genre is in invalid ";
+    static const std::string_view allowed_games[] = {"Game", "game"};
+    static const std::string_view allowed_videos_dvds[] = {"Record", "record", "DVD", "dvd"};
+    static const std::string_view allowed_genres[] = {
             "Action",
             "action",
             "Horror",
@@ -181,13 +176,13 @@ bool item_type_and_genre_is_valid(
             "comedy"
     };
 
-    bool is_game = std::count(allowed_games.begin(), allowed_games.end(), type) != 0;
-    bool is_video_or_dvd = std::count(allowed_videos_dvds.begin(), allowed_videos_dvds.end(), type) != 0;
-    bool correct_genre = std::count(allowed_genres.begin(), allowed_genres.end(), genre);
+    bool is_game = std::count(std::begin(allowed_games), std::end(allowed_games), type) != 0;
+    bool is_video_or_dvd = std::count(std::begin(allowed_videos_dvds), std::end(allowed_videos_dvds), type) != 0;
+    bool correct_genre = std::count(std::begin(allowed_genres), std::end(allowed_genres), genre) != 0;
 
     if (item_info_length == 6) {
         if (!is_game) {
-            std::cout << default_error << "(item type is invalid), received: " << type << std::endl;
+            log << default_error << "(item type is invalid), received: " << type << std::endl;
             return false;
         }
         return true;
@@ -197,119 +192,140 @@ bool item_type_and_genre_is_valid(
         // if either dvd or video but genre is not of action, horror, comedy, and drama => false
         // otherwise true
         if (is_game) {
-            std::cout << default_error
+            log << default_error
                       << "(received game but game has genre/or other data at the end of line)!"
                       << std::endl;
             return false;
         }
         if (!is_video_or_dvd) {
-            std::cout << default_error << "(item type is invalid), received: " << type << std::endl;
+            log << default_error << "(item type is invalid), received: " << type << std::endl;
             return false;
         }
         if (!correct_genre) {
-            std::cout << default_error << "(item genre is invalid), received: " << genre << std::endl;
+            log << default_error << "(item genre is invalid), received: " << genre << std::endl;
             return false;
         }
 
         return true;
     } else {
-        std::cout << default_error << "(item info length is invalid), received" << genre << " - " << type << std::endl;
+        log << default_error << "(item info length is invalid), received" << genre << " - " << type << std::endl;
         return false;
     }
 
 }
 
-bool item_loan_type_is_valid(const std::string &loan_type) {
+bool item_loan_type_is_valid(std::string_view loan_type, std::ostream &log) {
     if (loan_type != "1-week" && loan_type != "2-day") {
-        std::cout << "Item loan type is invalid, received: " << loan_type << std::endl;
+        log << "Item loan type is invalid, received: " << loan_type << std::endl;
         return false;
     }
     return true;
 }
 
 
-bool is_not_numeric(const std::string &str) {
-    const std::string allowed = "0123456789.";
-    if (str[0] == '-') {
-        return str.substr(1, str.length() - 1).find_first_not_of(allowed) != std::string::npos;
+bool is_not_numeric(std::string_view str) {
+    const char *allowed = "0123456789.";
+    if (!str.empty() && str[0] == '-') {
+        return str.substr(1).find_first_not_of(allowed) != std::string_view::npos;
     }
-    return str.find_first_not_of(allowed) != std::string::npos;
+    return str.find_first_not_of(allowed) != std::string_view::npos;
 }
 
-bool item_stock_is_valid(const std::string &stock) {
-    const std::string default_error = "[ERROR] Item stock is invalid";
-    try {
-        if (is_not_numeric(stock)) {
-            std::cout << default_error << ", received: " << stock << std::endl;
-            return false;
-        }
-        const int int_stock = std::stoi(stock, nullptr, 10);
-        if (int_stock < 0) {
-            std::cout << default_error << ", stock must be bigger than 0, received: " << stock << std::endl;
-            return false;
-        }
-        return true;
-    } catch (std::invalid_argument &e) {
-        std::cout << default_error << ", received: " << stock << std::endl;
+//Numbers are parsed in place from the loaded text, without temporary strings
+bool parse_item_stock(std::string_view stock, unsigned int &value) {
+    long long number = 0;
+    auto result = std::from_chars(stock.data(), stock.data() + stock.size(), number);
+    if (result.ec != std::errc() || number < 0 || number > 0xFFFFFFFFll) {
+        return false;
+    }
+    value = (unsigned int) number;
+    return true;
+}
+
+bool parse_item_price(std::string_view price, float &value) {
+    return std::from_chars(price.data(), price.data() + price.size(), value).ec == std::errc();
+}
+
+bool item_stock_is_valid(std::string_view stock, std::ostream &log) {
+    const char *default_error = "[ERROR] Item stock is invalid";
+    if (is_not_numeric(stock)) {
+        log << default_error << ", received: " << stock << std::endl;
+        return false;
+    }
+    if (!stock.empty() && stock[0] == '-') {
+        log << default_error << ", stock must be bigger than 0, received: " << stock << std::endl;
+        return false;
+    }
+    unsigned int value;
+    if (!parse_item_stock(stock, value)) {
+        log << default_error << ", received: " << stock << std::endl;
         return false;
     }
+    return true;
 }
 
-bool has_more_than_one_decimal(const std::string &price) {
+bool has_more_than_one_decimal(std::string_view price) {
     return std::count(price.begin(), price.end(), '.') > 1;
 }
 
-bool item_price_is_valid(const std::string &price) {
-    const std::string default_error = "[ERROR] Item price is invalid";
-    try {
-        if (has_more_than_one_decimal(price) || is_not_numeric(price)) {
-            std::cout << default_error << ", received: " << price << std::endl;
-            return false;
-        }
-        const float float_price = std::stof(price);
-        if (float_price < 0) {
-            std::cout << default_error << ", price must be greater than 0, received: " << float_price << std::endl;
-            return false;
-        }
-        return true;
-    } catch (std::invalid_argument &e) {
-        std::cout << default_error << ", received: " << price << std::endl;
+bool item_price_is_valid(std::string_view price, std::ostream &log) {
+    const char *default_error = "[ERROR] Item price is invalid";
+    float float_price = 0;
+    if (has_more_than_one_decimal(price) || is_not_numeric(price) || !parse_item_price(price, float_price)) {
+        log << default_error << ", received: " << price << std::endl;
         return false;
     }
+    if (float_price < 0) {
+        log << default_error << ", price must be greater than 0, received: " << float_price << std::endl;
+        return false;
+    }
+    return true;
 }
 
 bool valid_item_data(
-        const std::string &id,
-        const std::vector<Item *> &mockItems,
-        const std::string &type,
-        const std::string &genre,
-        std::vector<std::string>::size_type item_info_length,
-        const std::string &loan_type,
-        const std::string &stock,
-        const std::string &price
+        std::string_view id,
+        const ItemIndex &loaded_items,
+        std::string_view type,
+        std::string_view genre,
+        std::size_t item_info_length,
+        std::string_view loan_type,
+        std::string_view stock,
+        std::string_view price
+) {
+    return item_id_is_valid(id, loaded_items, false)
+           && valid_item_fields(type, genre, item_info_length, loan_type, stock, price);
+}
+
+bool valid_item_fields(
+        std::string_view type,
+        std::string_view genre,
+        std::size_t item_info_length,
+        std::string_view loan_type,
+        std::string_view stock,
+        std::string_view price,
+        std::ostream &log
 ) {
-    return item_id_is_valid(id, mockItems, false)
-           && item_type_and_genre_is_valid(type, genre, item_info_length)
-           && item_loan_type_is_valid(loan_type)
-           && item_stock_is_valid(stock)
-           && item_price_is_valid(price);
+    return item_type_and_genre_is_valid(type, genre, item_info_length, log)
+           && item_loan_type_is_valid(loan_type, log)
+           && item_stock_is_valid(stock, log)
+           && item_price_is_valid(price, log);
 }
 
-Item * get_item_with_id(const std::vector<Item *> &items, const std::string &id) {
+//Build the id -> item index once so that every lookup afterwards is O(1)
+ItemIndex build_item_index(const std::vector<Item *> &items) {
+    ItemIndex index;
+    index.reserve(items.size());
     for (Item *item : items) {
-        if (item->get_id() == id) {
-            return item;
-        }
+        index.insert(item->get_key(), item);
     }
+    return index;
+}
 
-    return nullptr;
+Item * get_item_with_id(const ItemIndex &items, ItemId id) {
+    Item *const *item = items.find(id);
+    return item == nullptr ? nullptr : *item;
 }
 
-bool item_exists_with_id(std::vector<Item *> &items, const std::string &id) {
-    for (Item *item : items) {
-        if (item->get_id() == id) {
-            return true;
-        }
-    }
-    return false;
+bool item_exists_with_id(const ItemIndex &items, ItemId id) {
+    return items.contains(id);
 }
\ No newline at end of file
@@ -1,9 +1,13 @@
 #include "../headers/ItemRepository.h"
 #include "../headers/ItemHelpers.h"
+#include "../headers/MappedFile.h"
+#include "../headers/Journal.h"
 #include <iostream>
 #include <algorithm>
-#include <fstream>
+#include <functional>
+#include <sstream>
 #include <string>
+#include <thread>
 
 /*
 	This class contains the Item Service class
@@ -78,27 +82,84 @@ void GenredItemGenreModificationIntent::modify() {
 
 //Implementation of Repository pattern
 //Where all CRUD operation will be done using an in-memory vector
-InMemoryItemRepository::InMemoryItemRepository(std::vector<Item *> items) : items(std::move(items)) {}
+//and the items are looked up through an id-keyed hash index
+InMemoryItemRepository::InMemoryItemRepository(std::vector<Item *> items) : items(std::move(items)) {
+    rebuild_index();
+}
 InMemoryItemRepository::~InMemoryItemRepository() {
+    //Items created in the arena are released together with it
     for (auto item_ptr : items) {
-        if (item_ptr != nullptr) {
+        if (item_ptr != nullptr && !arena.owns(item_ptr)) {
             delete item_ptr;
         }
     }
 }
 
 void InMemoryItemRepository::set_items(std::vector<Item *> const &new_items) {
+    //Stop observing the items being replaced
+    for (auto item_ptr : items) {
+        item_ptr->observer = nullptr;
+    }
     items = new_items;
+    rebuild_index();
+}
+
+void InMemoryItemRepository::rebuild_index() {
+    index.clear();
+    index.reserve(items.size());
+    title_index.clear();
+    id_index.clear();
+    bitmaps.clear();
+    for (std::size_t i = 0; i < items.size(); i++) {
+        Item *item_ptr = items[i];
+        index.insert(item_ptr->get_key(), i);
+        index_text(item_ptr);
+        bitmaps.set_item(item_ptr);
+        item_ptr->observer = this;
+    }
+    by_title.assign(items);
+    by_id.assign(items);
+    by_stock.assign(items);
+    by_fee.assign(items);
+}
+
+void InMemoryItemRepository::index_text(Item const *item) {
+    title_index.set(item->get_key().value, item->get_title());
+    id_index.set(item->get_key().value, item->get_id());
 }
 
 void InMemoryItemRepository::add_item(Item *item) {
+    //Nothing to add (e.g. the user cancelled the input)
+    if (item == nullptr) {
+        return;
+    }
+
+    //Ignore the item if its id is already taken
+    if (!index.insert(item->get_key(), items.size())) {
+        std::cerr << "Item with the same id already exists" << std::endl;
+        return;
+    }
     items.push_back(item);
+    index_text(item);
+    by_title.insert(item);
+    by_id.insert(item);
+    by_stock.insert(item);
+    by_fee.insert(item);
+    bitmaps.set_item(item);
+    item->observer = this;
+    mark_changed();
 }
 
 void InMemoryItemRepository::remove_item(std::string const &item_id) {
     //Find the position of the item
     int position = get_item_index(item_id);
 
+    //Display error if element does not exist
+    if (position == -1) {
+        std::cerr << "Item does not exist" << std::endl;
+        return;
+    }
+
     //Get the item and check if it is borrowed or not
     if (!items[position]->is_available()) {
         //Display error message
@@ -106,228 +167,882 @@ void InMemoryItemRepository::remove_item(std::string const &item_id) {
         return;
     }
 
-    //Remove if element exists
-    if (position != -1) {
-        items.erase(items.begin() + position);
-    } else {
-        std::cerr << "User does not exist" << std::endl;
+    //Remove from the indexes, then swap and pop: move the last item into the
+    //freed position and update its position in the index
+    ItemId key = items[position]->get_key();
+    index.erase(key);
+    title_index.remove(key.value);
+    id_index.remove(key.value);
+    by_title.erase(items[position]);
+    by_id.erase(items[position]);
+    by_stock.erase(items[position]);
+    by_fee.erase(items[position]);
+    bitmaps.remove(key.value);
+    items[position]->observer = nullptr;
+    if (position != (int) items.size() - 1) {
+        items[position] = items.back();
+        index.insert_or_assign(items[position]->get_key(), position);
     }
+    items.pop_back();
+    mark_changed();
 }
 
 void InMemoryItemRepository::update_item(std::string const &item_id, ItemModificationIntent &intent) {
-    //Find the position of the item
-    int position = get_item_index(item_id);
+    //Find the item
+    Item *item = get_item(item_id);
 
-    //Update if element exists
-    if (position != -1) {
-        intent.set_item(items[position]);
+    //Update if element exists, then re-index its title in case it changed
+    //(the item leaves the title, stock and fee orders while they may change)
+    if (item != nullptr) {
+        by_title.erase(item);
+        by_stock.erase(item);
+        by_fee.erase(item);
+        intent.set_item(item);
         intent.modify();
+        by_title.insert(item);
+        by_stock.insert(item);
+        by_fee.insert(item);
+        title_index.set(item->get_key().value, item->get_title());
+        mark_changed();
     } else {
         std::cerr << "Item does not exist" << std::endl;
     }
 }
 
 void InMemoryItemRepository::update_genred_item(std::string const &item_id, GenredItemModificationIntent &intent) {
-    //Find the position of the item
-    int position = get_item_index(item_id);
+    //Find the item
+    Item *item = get_item(item_id);
 
     //Update if element exists
-    if (position != -1) {
-        intent.set_item((GenredItem *) items[position]);
+    if (item != nullptr) {
+        intent.set_item((GenredItem *) item);
         intent.modify();
+        mark_changed();
     } else {
         std::cerr << "Item does not exist" << std::endl;
     }
 }
 
 Item *InMemoryItemRepository::get_item(std::string const &id) {
-    //Get the item position
-    int position = get_item_index(id);
+    //An id that can not be packed does not belong to any item
+    ItemId key;
+    if (!encode_item_id(id, key)) {
+        return nullptr;
+    }
+
+    //Look the item up in the hash index
+    std::size_t const *position = index.find(key);
+    return position == nullptr ? nullptr : items[*position];
+}
+
+bool InMemoryItemRepository::search_titles(std::string_view query, std::vector<Item *> &found) {
+    std::vector<std::uint32_t> keys;
+    title_index.search(query, keys);
+    collect(keys, found);
+    return true;
+}
+
+bool InMemoryItemRepository::search_ids(std::string_view query, std::vector<Item *> &found) {
+    std::vector<std::uint32_t> keys;
+    id_index.search(query, keys);
+    collect(keys, found);
+    return true;
+}
 
-    //Then get item at that position
-    return position == -1 ? nullptr : items[position];
+//Positions are changed by removals, so the positions found are sorted to keep the vector order
+void InMemoryItemRepository::collect(std::vector<std::uint32_t> const &keys, std::vector<Item *> &found) {
+    std::vector<std::size_t> positions;
+    positions.reserve(keys.size());
+    for (auto key : keys) {
+        std::size_t const *position = index.find(ItemId(key));
+        if (position != nullptr) {
+            positions.push_back(*position);
+        }
+    }
+    std::sort(positions.begin(), positions.end());
+    found.reserve(found.size() + positions.size());
+    for (auto position : positions) {
+        found.push_back(items[position]);
+    }
+}
+
+//The ordered indexes give the items in stock or fee order, collect puts them back in the order of the vector
+void InMemoryItemRepository::collect_range(std::vector<Item *>::const_iterator first,
+                                           std::vector<Item *>::const_iterator last, std::vector<Item *> &found) {
+    std::vector<std::uint32_t> keys;
+    keys.reserve(last - first);
+    for (auto it = first; it != last; ++it) {
+        keys.push_back((*it)->get_key().value);
+    }
+    collect(keys, found);
+}
+
+bool InMemoryItemRepository::range_stocks(unsigned int low, unsigned int high, std::vector<Item *> &found) {
+    auto range = by_stock.range(low, high);
+    collect_range(range.first, range.second, found);
+    return true;
+}
+
+bool InMemoryItemRepository::range_fees(float low, float high, std::vector<Item *> &found) {
+    auto range = by_fee.range(low, high);
+    collect_range(range.first, range.second, found);
+    return true;
+}
+
+bool InMemoryItemRepository::estimate_stocks(unsigned int low, unsigned int high, std::size_t &estimate) {
+    auto range = by_stock.range(low, high);
+    estimate = range.second - range.first;
+    return true;
+}
+
+bool InMemoryItemRepository::estimate_fees(float low, float high, std::size_t &estimate) {
+    auto range = by_fee.range(low, high);
+    estimate = range.second - range.first;
+    return true;
+}
+
+void InMemoryItemRepository::collect_bitmap(Bitmap const &bits, std::vector<Item *> &found) {
+    std::vector<std::uint32_t> keys;
+    bitmaps.keys_of(bits, keys);
+    collect(keys, found);
+}
+
+//Observer: an item changed (e.g. it was borrowed), update its bitmap values
+void InMemoryItemRepository::item_changed(Item const *item, unsigned int old_stock) {
+    std::size_t const *position = index.find(item->get_key());
+    if (position != nullptr && items[*position] == item) {
+        Item *found = items[*position];
+        bitmaps.set_item(item);
+        //Borrowing and returning change the stock outside of update_item, which
+        //takes the item out of the stock order itself while it changes
+        if (old_stock != item->get_number_in_stock()
+            && by_stock.erase_changed(ItemStockKey{old_stock, item->get_key()}, found)) {
+            by_stock.insert(found);
+        }
+        mark_changed();
+    }
 }
 
 int InMemoryItemRepository::get_item_index(std::string const &item_id) {
-    int position = 0;
+    //An id that can not be packed does not belong to any item
+    ItemId key;
+    if (!encode_item_id(item_id, key)) {
+        return -1;
+    }
 
-    for (; position < items.size(); position++) {
-        if (item_id == items[position]->get_id()) {
-            return position;
+    std::size_t const *position = index.find(key);
+    return position == nullptr ? -1 : (int) *position;
+}
+
+//Implementation of Repository pattern
+//Where the items are stored column by column
+ColumnarItemRepository::~ColumnarItemRepository() {
+    //Items created in the arena are released together with it
+    for (auto item_ptr : items) {
+        if (item_ptr != nullptr && !arena.owns(item_ptr)) {
+            delete item_ptr;
         }
     }
+}
 
-    return -1;
+void ColumnarItemRepository::set_items(std::vector<Item *> const &new_items) {
+    //Drop every row, then append the new items
+    for (auto item_ptr : items) {
+        item_ptr->observer = nullptr;
+    }
+    items.clear();
+    ids.clear();
+    stocks.clear();
+    fees.clear();
+    statuses.clear();
+    rental_types.clear();
+    genres.clear();
+    types.clear();
+    titles.clear();
+    rows.clear();
+    rows.reserve(new_items.size());
+    title_index.clear();
+    id_index.clear();
+    bitmaps.clear();
+
+    //Sort the ordered indexes once instead of inserting the items one by one
+    for (auto item_ptr : new_items) {
+        append_item(item_ptr);
+    }
+    by_title.assign(items);
+    by_id.assign(items);
+    by_stock.assign(items);
+    by_fee.assign(items);
+}
+
+void ColumnarItemRepository::add_item(Item *item) {
+    if (append_item(item)) {
+        by_title.insert(item);
+        by_id.insert(item);
+        by_stock.insert(item);
+        by_fee.insert(item);
+        mark_changed();
+    }
 }
 
-std::vector<std::string> get_item_as_vector(std::string &line) {
-    std::vector<std::string> item_as_vector;
-    std::string delimiter = ",";
-    size_t pos = 0;
-    std::string token;
+bool ColumnarItemRepository::append_item(Item *item) {
+    //Nothing to add (e.g. the user cancelled the input)
+    if (item == nullptr) {
+        return false;
+    }
+
+    //Ignore the item if its id is already taken
+    if (!rows.insert(item->get_key(), (std::uint32_t) items.size())) {
+        std::cerr << "Item with the same id already exists" << std::endl;
+        return false;
+    }
+    append_row(item);
+    return true;
+}
 
-    while ((pos = line.find(delimiter)) != std::string::npos) {
-        token = line.substr(0, pos);
-        if (token.empty()) {
-            return {};
+void ColumnarItemRepository::remove_item(std::string const &item_id) {
+    //Find the row of the item
+    int row = get_row(item_id);
+
+    //Display error if element does not exist
+    if (row == -1) {
+        std::cerr << "Item does not exist" << std::endl;
+        return;
+    }
+
+    //Check if the item is borrowed or not
+    if (statuses[row] != (std::uint8_t) Item::RentalStatus::Available) {
+        std::cerr << "Item is currently borrowed and can not be deleted" << std::endl;
+        return;
+    }
+
+    //Move the last row into the freed row so no column is shifted
+    items[row]->observer = nullptr;
+    rows.erase(ids[row]);
+    title_index.remove(ids[row].value);
+    id_index.remove(ids[row].value);
+    by_title.erase(items[row]);
+    by_id.erase(items[row]);
+    by_stock.erase(items[row]);
+    by_fee.erase(items[row]);
+    bitmaps.remove(ids[row].value);
+    std::uint32_t last = (std::uint32_t) items.size() - 1;
+    if ((std::uint32_t) row != last) {
+        move_row(last, row);
+        rows.insert_or_assign(ids[row], row);
+    }
+    pop_row();
+    mark_changed();
+}
+
+void ColumnarItemRepository::update_item(std::string const &item_id, ItemModificationIntent &intent) {
+    //Find the item, the columns are updated when the item notifies the change
+    Item *item = get_item(item_id);
+
+    //Update if element exists (the item leaves the title, stock and fee orders while they may change)
+    if (item != nullptr) {
+        by_title.erase(item);
+        by_stock.erase(item);
+        by_fee.erase(item);
+        intent.set_item(item);
+        intent.modify();
+        by_title.insert(item);
+        by_stock.insert(item);
+        by_fee.insert(item);
+        mark_changed();
+    } else {
+        std::cerr << "Item does not exist" << std::endl;
+    }
+}
+
+void ColumnarItemRepository::update_genred_item(std::string const &item_id, GenredItemModificationIntent &intent) {
+    //Find the item, the columns are updated when the item notifies the change
+    Item *item = get_item(item_id);
+
+    //Update if element exists
+    if (item != nullptr) {
+        intent.set_item((GenredItem *) item);
+        intent.modify();
+        mark_changed();
+    } else {
+        std::cerr << "Item does not exist" << std::endl;
+    }
+}
+
+Item *ColumnarItemRepository::get_item(std::string const &id) {
+    int row = get_row(id);
+    return row == -1 ? nullptr : items[row];
+}
+
+bool ColumnarItemRepository::search_titles(std::string_view query, std::vector<Item *> &found) {
+    std::vector<std::uint32_t> keys;
+    title_index.search(query, keys);
+    collect(keys, found);
+    return true;
+}
+
+bool ColumnarItemRepository::search_ids(std::string_view query, std::vector<Item *> &found) {
+    std::vector<std::uint32_t> keys;
+    id_index.search(query, keys);
+    collect(keys, found);
+    return true;
+}
+
+//Rows are reordered by removals, so the rows found are sorted to keep the repository order
+void ColumnarItemRepository::collect(std::vector<std::uint32_t> const &keys, std::vector<Item *> &found) {
+    std::vector<std::uint32_t> found_rows;
+    found_rows.reserve(keys.size());
+    for (auto key : keys) {
+        std::uint32_t const *row = rows.find(ItemId(key));
+        if (row != nullptr) {
+            found_rows.push_back(*row);
+        }
+    }
+    std::sort(found_rows.begin(), found_rows.end());
+
+    found.reserve(found.size() + found_rows.size());
+    for (auto row : found_rows) {
+        found.push_back(items[row]);
+    }
+}
+
+//collect puts the items found back in row order
+void ColumnarItemRepository::collect_range(std::vector<Item *>::const_iterator first,
+                                           std::vector<Item *>::const_iterator last, std::vector<Item *> &found) {
+    std::vector<std::uint32_t> keys;
+    keys.reserve(last - first);
+    for (auto it = first; it != last; ++it) {
+        keys.push_back((*it)->get_key().value);
+    }
+    collect(keys, found);
+}
+
+bool ColumnarItemRepository::range_stocks(unsigned int low, unsigned int high, std::vector<Item *> &found) {
+    auto range = by_stock.range(low, high);
+    collect_range(range.first, range.second, found);
+    return true;
+}
+
+bool ColumnarItemRepository::range_fees(float low, float high, std::vector<Item *> &found) {
+    auto range = by_fee.range(low, high);
+    collect_range(range.first, range.second, found);
+    return true;
+}
+
+bool ColumnarItemRepository::estimate_stocks(unsigned int low, unsigned int high, std::size_t &estimate) {
+    auto range = by_stock.range(low, high);
+    estimate = range.second - range.first;
+    return true;
+}
+
+bool ColumnarItemRepository::estimate_fees(float low, float high, std::size_t &estimate) {
+    auto range = by_fee.range(low, high);
+    estimate = range.second - range.first;
+    return true;
+}
+
+void ColumnarItemRepository::collect_bitmap(Bitmap const &bits, std::vector<Item *> &found) {
+    std::vector<std::uint32_t> keys;
+    bitmaps.keys_of(bits, keys);
+    collect(keys, found);
+}
+
+bool ColumnarItemRepository::get_columns(ItemColumnView &view) {
+    view.size = items.size();
+    view.ids = ids.data();
+    view.stocks = stocks.data();
+    view.fees = fees.data();
+    view.statuses = statuses.data();
+    view.rental_types = rental_types.data();
+    view.genres = genres.data();
+    view.types = types.data();
+    view.titles = titles.data();
+    view.items = items.data();
+    return true;
+}
+
+//Observer: re-read the row of an item which has been changed
+void ColumnarItemRepository::item_changed(Item const *item, unsigned int old_stock) {
+    std::uint32_t const *row = rows.find(item->get_key());
+    if (row != nullptr) {
+        write_row(*row, item);
+        title_index.set(item->get_key().value, item->get_title());
+        bitmaps.set_item(item);
+        //Borrowing and returning change the stock outside of update_item, which
+        //takes the item out of the stock order itself while it changes
+        if (old_stock != item->get_number_in_stock()
+            && by_stock.erase_changed(ItemStockKey{old_stock, items[*row]->get_key()}, items[*row])) {
+            by_stock.insert(items[*row]);
+        }
+        mark_changed();
+    }
+}
+
+int ColumnarItemRepository::get_row(std::string const &item_id) const {
+    //An id that can not be packed does not belong to any item
+    ItemId key;
+    if (!encode_item_id(item_id, key)) {
+        return -1;
+    }
+
+    std::uint32_t const *row = rows.find(key);
+    return row == nullptr ? -1 : (int) *row;
+}
+
+void ColumnarItemRepository::append_row(Item *item) {
+    items.push_back(item);
+    ids.push_back(item->get_key());
+    stocks.push_back(0);
+    fees.push_back(0);
+    statuses.push_back(0);
+    rental_types.push_back(0);
+    genres.push_back(NO_GENRE);
+    types.push_back(0);
+    titles.emplace_back();
+    write_row((std::uint32_t) items.size() - 1, item);
+    title_index.set(item->get_key().value, item->get_title());
+    id_index.set(item->get_key().value, item->get_id());
+    bitmaps.set_item(item);
+    item->observer = this;
+}
+
+void ColumnarItemRepository::write_row(std::uint32_t row, Item const *item) {
+    stocks[row] = item->get_number_in_stock();
+    fees[row] = item->get_rental_fee();
+    statuses[row] = (std::uint8_t) item->get_rental_status();
+    rental_types[row] = (std::uint8_t) item->get_rental_type();
+    types[row] = (std::uint8_t) item->get_type();
+    genres[row] = item->get_type() == GAME ? NO_GENRE
+                                           : (std::uint8_t) static_cast<GenredItem const *>(item)->get_genre();
+    titles[row] = item->title;
+}
+
+void ColumnarItemRepository::move_row(std::uint32_t from, std::uint32_t to) {
+    items[to] = items[from];
+    ids[to] = ids[from];
+    stocks[to] = stocks[from];
+    fees[to] = fees[from];
+    statuses[to] = statuses[from];
+    rental_types[to] = rental_types[from];
+    genres[to] = genres[from];
+    types[to] = types[from];
+    titles[to] = titles[from];
+}
+
+void ColumnarItemRepository::pop_row() {
+    items.pop_back();
+    ids.pop_back();
+    stocks.pop_back();
+    fees.pop_back();
+    statuses.pop_back();
+    rental_types.pop_back();
+    genres.pop_back();
+    types.pop_back();
+    titles.pop_back();
+}
+
+//Split a line into at most max_fields comma separated views into it
+//Return the number of fields, or 0 if a field before the last one is empty
+static std::size_t split_item_fields(std::string_view line, std::string_view *fields, std::size_t max_fields) {
+    std::size_t count = 0;
+    std::size_t pos;
+    while ((pos = line.find(',')) != std::string_view::npos) {
+        if (pos == 0 || count + 1 == max_fields) {
+            return 0;
         }
-        remove_carriage_return(token);
-        item_as_vector.push_back(token);
-        line.erase(0, pos + delimiter.length());
+        fields[count++] = line.substr(0, pos);
+        line.remove_prefix(pos + 1);
     }
-    remove_carriage_return(line);
-    item_as_vector.push_back(line.substr(0, line.length()));
-    return item_as_vector;
+    fields[count++] = line;
+    return count;
+}
+
+//A line of items.txt once parsed and checked on its own, everything but
+//the uniqueness of its id (which depends on the lines before it)
+struct ParsedItemLine {
+    enum class Status { Comment, Empty, WrongLength, MissingInfo, Invalid, Checked };
+
+    Status status = Status::Empty;
+    std::string_view fields[7];
+    std::size_t size = 0;
+    unsigned int stock = 0;
+    float fee = 0;
+
+    //Whether the fields after the id are valid, for a line with a valid id
+    bool fields_valid = false;
+
+    //The item of a valid line, created in the arena of the chunk
+    Item *item = nullptr;
+
+    //End of the messages of the line in the log of its chunk
+    std::size_t log_end = 0;
+};
+
+//The lines of a chunk of items.txt, with the messages of their checks and their items
+struct ParsedItemChunk {
+    std::vector<ParsedItemLine> lines;
+    std::ostringstream log;
+    Arena arena;
+};
+
+//Create the item of a valid line, logging it
+static Item *create_loaded_item(Arena &arena, ParsedItemLine const &line, std::ostream &log) {
+    std::string_view const *item_fields = line.fields;
+    // 6 means video game
+    if (line.size == 6) {
+        Item *game = arena.create<Game>(
+                item_fields[0],
+                item_fields[1],
+                string_to_rental_type(item_fields[3]),
+                line.stock,
+                line.fee,
+                Item::RentalStatus::Available
+        );
+        log << "[SUCCESS] Successfully created Game listing with ID: "
+                  << item_fields[0]
+                  << '\n';
+        return game;
+    }
+        // 7 means dvd or record
+    else if (line.size == 7) {
+        if (item_fields[2] == "DVD") {
+            Item *dvd = arena.create<DVD>(
+                    item_fields[0],
+                    item_fields[1],
+                    string_to_rental_type(item_fields[3]),
+                    line.stock,
+                    line.fee,
+                    Item::RentalStatus::Available,
+                    string_to_genre(item_fields[6])
+            );
+            log << "[SUCCESS] Successfully created DVD listing with ID: "
+                      << item_fields[0]
+                      << '\n';
+            return dvd;
+        } else if (item_fields[2] == "Record") {
+            Item *videoRecord = arena.create<VideoRecord>(
+                    item_fields[0],
+                    item_fields[1],
+                    string_to_rental_type(item_fields[3]),
+                    line.stock,
+                    line.fee,
+                    Item::RentalStatus::Available,
+                    string_to_genre(item_fields[6])
+            );
+            log << "[SUCCESS] Successfully created Video Record listing with ID: "
+                      << item_fields[0]
+                      << '\n';
+            return videoRecord;
+        }
+    } else {
+        std::cerr << "Unexpected length of item :/" << std::endl;
+    }
+    return nullptr;
+}
+
+//Parse and check the lines of a chunk and create the items of the valid lines in the
+//arena of the chunk, so chunks can be parsed on different threads
+static void parse_item_chunk(std::string_view text, ParsedItemChunk &chunk) {
+    std::string_view line;
+    while (next_line(text, line)) {
+        ParsedItemLine parsed;
+        if (line.empty()) {
+            parsed.status = ParsedItemLine::Status::Empty;
+        } else if (line[0] == '#') {
+            parsed.status = ParsedItemLine::Status::Comment;
+        } else if (!correct_info_length(line)) {
+            parsed.status = ParsedItemLine::Status::WrongLength;
+        } else if ((parsed.size = split_item_fields(line, parsed.fields, 7)) == 0) {
+            parsed.status = ParsedItemLine::Status::MissingInfo;
+        } else if (!item_id_is_valid(parsed.fields[0], {}, true, chunk.log)) {
+            parsed.status = ParsedItemLine::Status::Invalid;
+        } else {
+            parsed.status = ParsedItemLine::Status::Checked;
+            parsed.fields_valid = valid_item_fields(parsed.fields[2], parsed.fields[parsed.size - 1], parsed.size,
+                                                    parsed.fields[3], parsed.fields[4], parsed.fields[5], chunk.log);
+            if (parsed.fields_valid) {
+                parse_item_stock(parsed.fields[4], parsed.stock);
+                parse_item_price(parsed.fields[5], parsed.fee);
+                parsed.item = create_loaded_item(chunk.arena, parsed, chunk.log);
+            }
+        }
+        parsed.log_end = (std::size_t) chunk.log.tellp();
+        chunk.lines.push_back(parsed);
+    }
+}
+
+//Split a text into at most count chunks of whole lines
+static std::vector<std::string_view> split_lines_into_chunks(std::string_view text, std::size_t count) {
+    std::vector<std::string_view> chunks;
+    std::size_t begin = 0;
+    for (std::size_t i = 1; i <= count && begin < text.size(); i++) {
+        std::size_t end = text.size();
+        if (i < count) {
+            end = text.find('\n', std::max(begin, text.size() / count * i));
+            end = end == std::string_view::npos ? text.size() : end + 1;
+        }
+        chunks.push_back(text.substr(begin, end - begin));
+        begin = end;
+    }
+    return chunks;
 }
 
 //Implementation of ItemPersistence
 //This is responsible for loading and saving
 //customers from and to a text file
-std::vector<Item *> TextFileItemPersistence::load() {
-    std::ifstream infile("../textfiles/items.txt");
-    if (!infile) {
+std::vector<Item *> TextFileItemPersistence::load(Arena &arena) {
+    //The file is mapped and read in place: lines and fields are views into
+    //the mapping, and only the records built from them copy anything
+    MappedFile file;
+    if (!file.open("../textfiles/items.txt")) {
         std::cerr << "Cannot read file items.txt..." << std::endl;
         return {};
     }
     std::cout << "[INFO] Loading items from items.txt..." << std::endl;
+    std::string_view text = file.contents();
+
+    //Parse the chunks, the first one on this thread
+    std::size_t workers = threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+    workers = std::max<std::size_t>(1, std::min(workers, text.size() / min_chunk_size));
+    std::vector<std::string_view> texts = split_lines_into_chunks(text, workers);
+    std::vector<ParsedItemChunk> chunks(texts.size());
+    std::vector<std::thread> pool;
+    for (std::size_t i = 1; i < texts.size(); i++) {
+        pool.emplace_back(parse_item_chunk, texts[i], std::ref(chunks[i]));
+    }
+    if (!texts.empty()) {
+        parse_item_chunk(texts[0], chunks[0]);
+    }
+    for (auto &worker : pool) {
+        worker.join();
+    }
+
+    //Keep the items in the order of the file, the ids are unique across the chunks.
+    //The item of a line with a repeated id stays unused in the arena until it is released
+    std::size_t total_lines = 0;
+    for (auto const &chunk : chunks) {
+        total_lines += chunk.lines.size();
+    }
     unsigned int count = 1;
     std::vector<Item *> mockItems;
-    std::string line;
-    const std::string default_ignore = "[LOG] Ignoring line ";
-    while (std::getline(infile, line)) {
-        if (line[0] == '#') {
-            std::cout << default_ignore << count << " (has # in the beginning)" << std::endl;
-        } else if (line.empty()) {
-            std::cout << default_ignore << count << " (line is empty)." << std::endl;
-        } else if (!correct_info_length(line)) {
-            std::cout << default_ignore << count << " (line can only have 5-6 commas)." << std::endl;
-        } else {
-            std::vector<std::string> item_vector = get_item_as_vector(line);
-            if (item_vector.empty()) {
-                std::cout << default_ignore << count << " (line is missing info)." << std::endl;
-            } else {
-                if (valid_item_data(
-                        item_vector[0],
-                        mockItems,
-                        item_vector[2],
-                        item_vector[item_vector.size() - 1],
-                        item_vector.size(),
-                        item_vector[3],
-                        item_vector[4],
-                        item_vector[5]
-                )) {
-
-                    // 6 means video game
-                    if (item_vector.size() == 6) {
-                        Item *game = new Game(
-                                item_vector[0],
-                                item_vector[1],
-                                string_to_rental_type(item_vector[3]),
-                                std::stoi(item_vector[4]),
-                                std::stof(item_vector[5]),
-                                Item::RentalStatus::Available
-                        );
-                        mockItems.push_back(game);
-                        std::cout << "[SUCCESS] Successfully created Game listing with ID: "
-                                  << item_vector[0]
-                                  << std::endl;
+    mockItems.reserve(total_lines);
+    ItemIndex loaded_items;
+    loaded_items.reserve(total_lines);
+    const char *default_ignore = "[LOG] Ignoring line ";
+    for (auto &chunk : chunks) {
+        arena.adopt(chunk.arena);
+        std::string log = chunk.log.str();
+        std::size_t log_begin = 0;
+        for (auto const &line : chunk.lines) {
+            std::string_view messages(log.data() + log_begin, line.log_end - log_begin);
+            log_begin = line.log_end;
+            switch (line.status) {
+                case ParsedItemLine::Status::Empty:
+                    std::cout << default_ignore << count << " (line is empty)." << '\n';
+                    break;
+                case ParsedItemLine::Status::Comment:
+                    std::cout << default_ignore << count << " (has # in the beginning)" << '\n';
+                    break;
+                case ParsedItemLine::Status::WrongLength:
+                    std::cout << default_ignore << count << " (line can only have 5-6 commas)." << '\n';
+                    break;
+                case ParsedItemLine::Status::MissingInfo:
+                    std::cout << default_ignore << count << " (line is missing info)." << '\n';
+                    break;
+                case ParsedItemLine::Status::Invalid:
+                    std::cout << messages;
+                    continue;
+                case ParsedItemLine::Status::Checked:
+                    //A repeated id is reported instead of the other fields, like valid_item_data does
+                    if (!item_id_is_valid(line.fields[0], loaded_items, false)) {
+                        continue;
                     }
-                        // 7 means dvd or record
-                    else if (item_vector.size() == 7) {
-                        if (item_vector[2] == "DVD") {
-                            Item *dvd = new DVD(
-                                    item_vector[0],
-                                    item_vector[1],
-                                    string_to_rental_type(item_vector[3]),
-                                    std::stoi(item_vector[3]),
-                                    std::stof(item_vector[4]),
-                                    Item::RentalStatus::Available,
-                                    string_to_genre(item_vector[6])
-                            );
-                            mockItems.push_back(dvd);
-                            std::cout << "[SUCCESS] Successfully created DVD listing with ID: "
-                                      << item_vector[0]
-                                      << std::endl;
-                        } else if (item_vector[2] == "Record") {
-                            Item *videoRecord = new VideoRecord(
-                                    item_vector[0],
-                                    item_vector[1],
-                                    string_to_rental_type(item_vector[3]),
-                                    std::stoi(item_vector[3]),
-                                    std::stof(item_vector[4]),
-                                    Item::RentalStatus::Available,
-                                    string_to_genre(item_vector[6])
-                            );
-                            mockItems.push_back(videoRecord);
-                            std::cout << "[SUCCESS] Successfully created Video Record listing with ID: "
-                                      << item_vector[0]
-                                      << std::endl;
-                        }
-                    } else {
-                        std::cerr << "Unexpected length of item :/" << std::endl;
+                    std::cout << messages;
+                    if (!line.fields_valid) {
+                        continue;
                     }
-                } else {
-                    continue;
-                }
+                    if (line.item != nullptr) {
+                        mockItems.push_back(line.item);
+                        loaded_items.insert(line.item->get_key(), line.item);
+                    }
+                    break;
             }
+            count++;
         }
-        count++;
     }
     std::cout << "[INFO] Done loading items!" << std::endl;
-    infile.close();
-    std::cout << "[INFO] Rewriting content of items.txt..." << std::endl;
-    this->save(mockItems);
+    file.close();
     return mockItems;
 }
 
 //Implementation of ItemPersistence
 //This is responsible for loading and saving
 //customers from and to a text file
-void TextFileItemPersistence::save(std::vector<Item *> items) {
-    std::ofstream outfile("../textfiles/items.txt", std::ios::trunc);
-    if (!outfile) {
-        std::cerr << "[ERROR] Cannot write to file items_out.txt" << std::endl;
-        return;
-    }
-    unsigned int i = 0;
-    for (; i < items.size(); i++) {
-        outfile << items[i]->to_string_file();
+//Render the items as they are written to items.txt
+static void render_item_file(std::vector<Item *> const &items, OutputBuffer &out) {
+    for (unsigned int i = 0; i < items.size(); i++) {
+        items[i]->render_file(out);
         // no newline EOF
         if (i < items.size() - 1) {
-            outfile << "\n";
+            out.append('\n');
         }
+        out.end_record();
+    }
+}
+
+void TextFileItemPersistence::save(std::vector<Item *> const &items) {
+    //Render every item into one buffer, then replace the file with it so a failed
+    //write leaves the previous items.txt in place
+    OutputBuffer out;
+    render_item_file(items, out);
+    if (!replace_file("../textfiles/items.txt", out.view())) {
+        std::cerr << "[ERROR] Cannot write to file items.txt" << std::endl;
+        return;
     }
     std::cout << "[SUCCESS] Successfully saved items.txt!" << std::endl;
-    outfile.close();
+}
+
+PendingFile TextFileItemPersistence::render(std::vector<Item *> const &items) {
+    OutputBuffer out;
+    render_item_file(items, out);
+    return {"../textfiles/items.txt", out.str()};
+}
+
+//Position of a key relative to the key of a cursor
+static int compare_keys(ItemId key, ItemId cursor_key) {
+    return key < cursor_key ? -1 : (key == cursor_key ? 0 : 1);
 }
 
 //Order by name: This class will sort the items based on their titles
 void ItemTitleOrder::order(std::vector<Item *> &items) const {
-    std::sort(items.begin(), items.end(), [](Item const *a, Item const *b) {
-        return a->get_title() < b->get_title();
-    });
+    std::sort(items.begin(), items.end(), ItemTitleLess());
+}
+std::vector<Item *> const *ItemTitleOrder::ordered(ItemRepository &repository) const {
+    return repository.get_items_by_title();
+}
+bool ItemTitleOrder::less(Item const *a, Item const *b) const {
+    return ItemTitleLess()(a, b);
+}
+int ItemTitleOrder::compare(Item const *item, ItemCursor const &cursor) const {
+    int title = std::string_view(item->get_title()).compare(cursor.title);
+    if (title != 0) {
+        return title;
+    }
+    return compare_keys(item->get_key(), cursor.key);
 }
 
 //Order by id: This class will sort the items based on their ids
 void ItemIdOrder::order(std::vector<Item *> &items) const {
-    std::sort(items.begin(), items.end(), [](Item const *a, Item const *b) {
-        return a->get_id() < b->get_id();
-    });
+    std::sort(items.begin(), items.end(), ItemIdLess());
+}
+std::vector<Item *> const *ItemIdOrder::ordered(ItemRepository &repository) const {
+    return repository.get_items_by_id();
+}
+bool ItemIdOrder::less(Item const *a, Item const *b) const {
+    return ItemIdLess()(a, b);
+}
+int ItemIdOrder::compare(Item const *item, ItemCursor const &cursor) const {
+    return compare_keys(item->get_key(), cursor.key);
 }
 
 //No order: This class will do nothing
 void ItemNoOrder::order(std::vector<Item *> &items) const {
     //Do nothing
 }
+std::vector<Item *> const *ItemNoOrder::ordered(ItemRepository &repository) const {
+    return &repository.get_items();
+}
+bool ItemNoOrder::less(Item const *a, Item const *b) const {
+    return ItemIdLess()(a, b);
+}
+int ItemNoOrder::compare(Item const *item, ItemCursor const &cursor) const {
+    return compare_keys(item->get_key(), cursor.key);
+}
+
+//Cursor: the sort fields of an item, by value
+ItemCursor::ItemCursor(Item const *item) : title(item->get_title()), key(item->get_key()) {}
+
+//Bitmap index over the low-cardinality attributes of the items
+ItemBitmapIndex::ItemBitmapIndex() : BitmapIndex({NO_GENRE_VALUE + 1, 2, 2, 3, 2}) {}
+
+void ItemBitmapIndex::set_item(Item const *item) {
+    std::uint8_t values[5];
+    values[GENRE_ATTRIBUTE] = item->get_type() == GAME
+                              ? NO_GENRE_VALUE
+                              : (std::uint8_t) static_cast<GenredItem const *>(item)->get_genre();
+    values[RENTAL_TYPE_ATTRIBUTE] = (std::uint8_t) item->get_rental_type();
+    values[RENTAL_STATUS_ATTRIBUTE] = (std::uint8_t) item->get_rental_status();
+    values[TYPE_ATTRIBUTE] = (std::uint8_t) item->get_type();
+    values[IN_STOCK_ATTRIBUTE] = item->get_number_in_stock() > 0 ? 1 : 0;
+    set(item->get_key().value, values);
+}
+
+bool ItemTitleLess::operator()(Item const *a, Item const *b) const {
+    std::string_view title_a = a->get_title();
+    std::string_view title_b = b->get_title();
+    return title_a != title_b ? title_a < title_b : a->get_key() < b->get_key();
+}
+
+bool ItemStockLess::operator()(Item const *a, Item const *b) const {
+    unsigned int stock_a = a->get_number_in_stock();
+    unsigned int stock_b = b->get_number_in_stock();
+    return stock_a != stock_b ? stock_a < stock_b : a->get_key() < b->get_key();
+}
+
+bool ItemStockLess::operator()(Item const *item, unsigned int stock) const {
+    return item->get_number_in_stock() < stock;
+}
+
+bool ItemStockLess::operator()(unsigned int stock, Item const *item) const {
+    return stock < item->get_number_in_stock();
+}
+
+bool ItemStockLess::operator()(Item const *item, ItemStockKey key) const {
+    if (item->get_key() == key.key) {
+        return false;
+    }
+    unsigned int stock = item->get_number_in_stock();
+    return stock != key.stock ? stock < key.stock : item->get_key() < key.key;
+}
+
+bool ItemFeeLess::operator()(Item const *a, Item const *b) const {
+    float fee_a = a->get_rental_fee();
+    float fee_b = b->get_rental_fee();
+    return fee_a != fee_b ? fee_a < fee_b : a->get_key() < b->get_key();
+}
+
+bool ItemFeeLess::operator()(Item const *item, float fee) const {
+    return item->get_rental_fee() < fee;
+}
+
+bool ItemFeeLess::operator()(float fee, Item const *item) const {
+    return fee < item->get_rental_fee();
+}
+
+bool ItemIdLess::operator()(Item const *a, Item const *b) const {
+    return a->get_key() < b->get_key();
+}
 
 //Implementation of ItemDisplayer
 //Responsible for displaying the items through the console
-void ConsoleItemDisplayer::display(std::vector<Item *> items, ItemOrder const *order) {
-    //Sort first
-    order->order(items);
-    for (auto &item : items) {
-        std::cout << *item << std::endl;
+void ConsoleItemDisplayer::display(std::vector<Item *> const &items, ItemOrder const *order) {
+    //Only copy the list when it has to be sorted first
+    if (!order->reorders()) {
+        render(items);
+        return;
+    }
+    std::vector<Item *> sorted(items);
+    order->order(sorted);
+    render(sorted);
+}
+
+void ConsoleItemDisplayer::render(std::vector<Item *> const &items) {
+    for (auto item : items) {
+        item->render_console(out);
+        out.append('\n');
+        out.end_record();
     }
+    out.flush();
 }
 
 //Filters
@@ -337,13 +1052,34 @@ ItemNumStockFilterSpecification::ItemNumStockFilterSpecification(unsigned int co
 bool ItemNumStockFilterSpecification::is_satisfied(Item const *item) const {
     return item->get_number_in_stock() == number_in_stock;
 }
+void ItemNumStockFilterSpecification::select(ItemColumnView const &view, std::vector<std::uint32_t> &rows) const {
+    view.select_stock_equal(number_in_stock, rows);
+}
+bool ItemNumStockFilterSpecification::bitmap(ItemRepository &repository, Bitmap &bits) const {
+    ItemBitmapIndex const *index = repository.get_bitmap_index();
+    if (index == nullptr || number_in_stock != 0) {
+        return false;
+    }
+    bits = index->get(IN_STOCK_ATTRIBUTE, 0);
+    return true;
+}
 
 //Filter item based on their id
 ItemIdFilterSpecification::ItemIdFilterSpecification(std::string id)
         : id(id) {}
 
 bool ItemIdFilterSpecification::is_satisfied(Item const *item) const {
-    return check_field_contains(item->get_id(), id);
+    //Decode the packed id on the stack instead of building a string
+    char buffer[ItemId::length];
+    write_item_id(item->get_key(), buffer);
+    return check_field_contains(std::string_view(buffer, ItemId::length), id);
+}
+bool ItemIdFilterSpecification::lookup(ItemRepository &repository, std::vector<Item *> &items) const {
+    return repository.search_ids(id, items);
+}
+ItemFilterSpecification const *ItemIdFilterSpecification::plan(ItemRepository &repository,
+                                                               std::size_t &estimate) const {
+    return repository.estimate_ids(id, estimate) ? this : nullptr;
 }
 
 //Filter item based on their title
@@ -352,11 +1088,332 @@ ItemTitleFilterSpecification::ItemTitleFilterSpecification(std::string title)
 bool ItemTitleFilterSpecification::is_satisfied(Item const *item) const {
     return check_field_contains(item->get_title(), title);
 }
+void ItemTitleFilterSpecification::select(ItemColumnView const &view, std::vector<std::uint32_t> &rows) const {
+    for (std::uint32_t row = 0; row < view.size; row++) {
+        if (check_field_contains(view.title(row), title)) {
+            rows.push_back(row);
+        }
+    }
+}
+bool ItemTitleFilterSpecification::lookup(ItemRepository &repository, std::vector<Item *> &items) const {
+    return repository.search_titles(title, items);
+}
+ItemFilterSpecification const *ItemTitleFilterSpecification::plan(ItemRepository &repository,
+                                                                  std::size_t &estimate) const {
+    return repository.estimate_titles(title, estimate) ? this : nullptr;
+}
+
+//Filter item based on a range of number of stock
+ItemStockRangeFilterSpecification::ItemStockRangeFilterSpecification(unsigned int low, unsigned int high)
+        : low(low), high(high) {}
+bool ItemStockRangeFilterSpecification::is_satisfied(Item const *item) const {
+    return item->get_number_in_stock() >= low && item->get_number_in_stock() <= high;
+}
+void ItemStockRangeFilterSpecification::select(ItemColumnView const &view, std::vector<std::uint32_t> &rows) const {
+    for (std::uint32_t row = 0; row < view.size; row++) {
+        if (view.stocks[row] >= low && view.stocks[row] <= high) {
+            rows.push_back(row);
+        }
+    }
+}
+bool ItemStockRangeFilterSpecification::lookup(ItemRepository &repository, std::vector<Item *> &items) const {
+    return repository.range_stocks(low, high, items);
+}
+ItemFilterSpecification const *ItemStockRangeFilterSpecification::plan(ItemRepository &repository,
+                                                                       std::size_t &estimate) const {
+    return repository.estimate_stocks(low, high, estimate) ? this : nullptr;
+}
+
+//Filter item based on a range of rental fee
+ItemFeeRangeFilterSpecification::ItemFeeRangeFilterSpecification(float low, float high) : low(low), high(high) {}
+bool ItemFeeRangeFilterSpecification::is_satisfied(Item const *item) const {
+    return item->get_rental_fee() >= low && item->get_rental_fee() <= high;
+}
+void ItemFeeRangeFilterSpecification::select(ItemColumnView const &view, std::vector<std::uint32_t> &rows) const {
+    for (std::uint32_t row = 0; row < view.size; row++) {
+        if (view.fees[row] >= low && view.fees[row] <= high) {
+            rows.push_back(row);
+        }
+    }
+}
+bool ItemFeeRangeFilterSpecification::lookup(ItemRepository &repository, std::vector<Item *> &items) const {
+    return repository.range_fees(low, high, items);
+}
+ItemFilterSpecification const *ItemFeeRangeFilterSpecification::plan(ItemRepository &repository,
+                                                                     std::size_t &estimate) const {
+    return repository.estimate_fees(low, high, estimate) ? this : nullptr;
+}
+
+//Filter item based on their genre
+ItemGenreFilterSpecification::ItemGenreFilterSpecification(GenredItem::Genre genre) : genre(genre) {}
+bool ItemGenreFilterSpecification::is_satisfied(Item const *item) const {
+    return item->get_type() != GAME && static_cast<GenredItem const *>(item)->get_genre() == genre;
+}
+void ItemGenreFilterSpecification::select(ItemColumnView const &view, std::vector<std::uint32_t> &rows) const {
+    for (std::uint32_t row = 0; row < view.size; row++) {
+        if (view.genres[row] == (std::uint8_t) genre) {
+            rows.push_back(row);
+        }
+    }
+}
+bool ItemGenreFilterSpecification::bitmap(ItemRepository &repository, Bitmap &bits) const {
+    ItemBitmapIndex const *index = repository.get_bitmap_index();
+    if (index == nullptr) {
+        return false;
+    }
+    bits = index->get(GENRE_ATTRIBUTE, (std::uint8_t) genre);
+    return true;
+}
+
+//Filter item based on their type
+ItemTypeFilterSpecification::ItemTypeFilterSpecification(ItemType type) : type(type) {}
+bool ItemTypeFilterSpecification::is_satisfied(Item const *item) const {
+    return item->get_type() == type;
+}
+void ItemTypeFilterSpecification::select(ItemColumnView const &view, std::vector<std::uint32_t> &rows) const {
+    for (std::uint32_t row = 0; row < view.size; row++) {
+        if (view.types[row] == (std::uint8_t) type) {
+            rows.push_back(row);
+        }
+    }
+}
+bool ItemTypeFilterSpecification::bitmap(ItemRepository &repository, Bitmap &bits) const {
+    ItemBitmapIndex const *index = repository.get_bitmap_index();
+    if (index == nullptr) {
+        return false;
+    }
+    bits = index->get(TYPE_ATTRIBUTE, (std::uint8_t) type);
+    return true;
+}
+
+//Filter item based on their rental type
+ItemRentalTypeFilterSpecification::ItemRentalTypeFilterSpecification(Item::RentalType rental_type)
+        : rental_type(rental_type) {}
+bool ItemRentalTypeFilterSpecification::is_satisfied(Item const *item) const {
+    return item->get_rental_type() == rental_type;
+}
+bool ItemRentalTypeFilterSpecification::bitmap(ItemRepository &repository, Bitmap &bits) const {
+    ItemBitmapIndex const *index = repository.get_bitmap_index();
+    if (index == nullptr) {
+        return false;
+    }
+    bits = index->get(RENTAL_TYPE_ATTRIBUTE, (std::uint8_t) rental_type);
+    return true;
+}
+
+//Filter item based on their rental status
+ItemRentalStatusFilterSpecification::ItemRentalStatusFilterSpecification(Item::RentalStatus rental_status)
+        : rental_status(rental_status) {}
+bool ItemRentalStatusFilterSpecification::is_satisfied(Item const *item) const {
+    return item->get_rental_status() == rental_status;
+}
+bool ItemRentalStatusFilterSpecification::bitmap(ItemRepository &repository, Bitmap &bits) const {
+    ItemBitmapIndex const *index = repository.get_bitmap_index();
+    if (index == nullptr) {
+        return false;
+    }
+    bits = index->get(RENTAL_STATUS_ATTRIBUTE, (std::uint8_t) rental_status);
+    return true;
+}
+
+//Specifications answered by the bitmap index
+bool ItemBitmapFilterSpecification::lookup(ItemRepository &repository, std::vector<Item *> &items) const {
+    Bitmap bits;
+    if (!bitmap(repository, bits)) {
+        return false;
+    }
+    repository.collect_bitmap(bits, items);
+    return true;
+}
+ItemFilterSpecification const *ItemBitmapFilterSpecification::plan(ItemRepository &repository,
+                                                                   std::size_t &estimate) const {
+    Bitmap bits;
+    if (!bitmap(repository, bits)) {
+        return nullptr;
+    }
+    estimate = bits.count();
+    return this;
+}
+
+//Combinators
+ItemAndFilterSpecification::ItemAndFilterSpecification(std::vector<ItemFilterSpecification const *> specifications)
+        : specifications(std::move(specifications)) {}
+bool ItemAndFilterSpecification::is_satisfied(Item const *item) const {
+    for (auto specification : specifications) {
+        if (!specification->is_satisfied(item)) {
+            return false;
+        }
+    }
+    return true;
+}
+void ItemAndFilterSpecification::select(ItemColumnView const &view, std::vector<std::uint32_t> &rows) const {
+    if (specifications.empty()) {
+        view.select_all(rows);
+        return;
+    }
+
+    //Select with the first specification, then check the others on the selected rows only
+    std::vector<std::uint32_t> selected;
+    specifications.front()->select(view, selected);
+    for (auto row : selected) {
+        bool satisfied = true;
+        for (std::size_t i = 1; i < specifications.size() && satisfied; i++) {
+            satisfied = specifications[i]->is_satisfied(view.items[row]);
+        }
+        if (satisfied) {
+            rows.push_back(row);
+        }
+    }
+}
+//Any index of a specification gives candidates for the whole conjunction: take the most selective one
+ItemFilterSpecification const *ItemAndFilterSpecification::plan(ItemRepository &repository,
+                                                                std::size_t &estimate) const {
+    ItemFilterSpecification const *best = nullptr;
+    for (auto specification : specifications) {
+        std::size_t specification_estimate = 0;
+        ItemFilterSpecification const *driver = specification->plan(repository, specification_estimate);
+        if (driver != nullptr && (best == nullptr || specification_estimate < estimate)) {
+            best = driver;
+            estimate = specification_estimate;
+        }
+    }
+
+    //The intersection of several bitmaps can be more selective than any single index
+    Bitmap bits;
+    if (intersect_bitmaps(repository, bits, nullptr) > 1) {
+        std::size_t bitmap_estimate = bits.count();
+        if (best == nullptr || bitmap_estimate < estimate) {
+            best = this;
+            estimate = bitmap_estimate;
+        }
+    }
+    return best;
+}
+//Get the candidates from the intersection of the bitmaps, then check the other specifications
+bool ItemAndFilterSpecification::lookup(ItemRepository &repository, std::vector<Item *> &items) const {
+    Bitmap bits;
+    std::vector<ItemFilterSpecification const *> remaining;
+    if (intersect_bitmaps(repository, bits, &remaining) == 0) {
+        return false;
+    }
+
+    std::vector<Item *> candidates;
+    repository.collect_bitmap(bits, candidates);
+    for (auto item : candidates) {
+        bool satisfied = true;
+        for (std::size_t i = 0; i < remaining.size() && satisfied; i++) {
+            satisfied = remaining[i]->is_satisfied(item);
+        }
+        if (satisfied) {
+            items.push_back(item);
+        }
+    }
+    return true;
+}
+bool ItemAndFilterSpecification::bitmap(ItemRepository &repository, Bitmap &bits) const {
+    std::vector<ItemFilterSpecification const *> remaining;
+    std::size_t answered = intersect_bitmaps(repository, bits, &remaining);
+    if (!remaining.empty()) {
+        return false;
+    }
+
+    //No specification at all: every item
+    if (answered == 0) {
+        ItemBitmapIndex const *index = repository.get_bitmap_index();
+        if (index == nullptr) {
+            return false;
+        }
+        bits = index->all();
+    }
+    return true;
+}
+std::size_t ItemAndFilterSpecification::intersect_bitmaps(ItemRepository &repository, Bitmap &bits,
+                                                          std::vector<ItemFilterSpecification const *> *remaining) const {
+    std::size_t answered = 0;
+    Bitmap specification_bits;
+    for (auto specification : specifications) {
+        if (specification->bitmap(repository, specification_bits)) {
+            if (answered == 0) {
+                bits = specification_bits;
+            } else {
+                bits &= specification_bits;
+            }
+            answered++;
+        } else if (remaining != nullptr) {
+            remaining->push_back(specification);
+        }
+    }
+    return answered;
+}
+
+ItemOrFilterSpecification::ItemOrFilterSpecification(std::vector<ItemFilterSpecification const *> specifications)
+        : specifications(std::move(specifications)) {}
+bool ItemOrFilterSpecification::is_satisfied(Item const *item) const {
+    for (auto specification : specifications) {
+        if (specification->is_satisfied(item)) {
+            return true;
+        }
+    }
+    return false;
+}
+//The union can only use bitmaps when every specification has one
+bool ItemOrFilterSpecification::bitmap(ItemRepository &repository, Bitmap &bits) const {
+    ItemBitmapIndex const *index = repository.get_bitmap_index();
+    if (index == nullptr) {
+        return false;
+    }
+
+    bits = Bitmap(index->all().size());
+    Bitmap specification_bits;
+    for (auto specification : specifications) {
+        if (!specification->bitmap(repository, specification_bits)) {
+            return false;
+        }
+        bits |= specification_bits;
+    }
+    return true;
+}
+
+ItemNotFilterSpecification::ItemNotFilterSpecification(ItemFilterSpecification const *specification)
+        : specification(specification) {}
+bool ItemNotFilterSpecification::is_satisfied(Item const *item) const {
+    return !specification->is_satisfied(item);
+}
+bool ItemNotFilterSpecification::bitmap(ItemRepository &repository, Bitmap &bits) const {
+    ItemBitmapIndex const *index = repository.get_bitmap_index();
+    Bitmap specification_bits;
+    if (index == nullptr || !specification->bitmap(repository, specification_bits)) {
+        return false;
+    }
+    bits = index->all();
+    bits.and_not(specification_bits);
+    return true;
+}
 
 //Filter base on no conditions -> Every item is satisfied
 bool ItemAllFilterSpecification::is_satisfied(Item const *item) const {
     return true;
 }
+void ItemAllFilterSpecification::select(ItemColumnView const &view, std::vector<std::uint32_t> &rows) const {
+    view.select_all(rows);
+}
+bool ItemAllFilterSpecification::bitmap(ItemRepository &repository, Bitmap &bits) const {
+    ItemBitmapIndex const *index = repository.get_bitmap_index();
+    if (index == nullptr) {
+        return false;
+    }
+    bits = index->all();
+    return true;
+}
+
+//Default column selection: check the item of every row
+void ItemFilterSpecification::select(ItemColumnView const &view, std::vector<std::uint32_t> &rows) const {
+    for (std::uint32_t row = 0; row < view.size; row++) {
+        if (is_satisfied(view.items[row])) {
+            rows.push_back(row);
+        }
+    }
+}
 
 //This class uses a spefication class (TitleSpec, StockSpec or all Spec)
 //to filter the list of items and include only those which satistfies the spec
@@ -372,6 +1429,60 @@ std::vector<Item *> ItemFilterer::filter(std::vector<Item *> const &items, ItemF
     return result;
 }
 
+//Filter the rows of a column view, then get the items of the selected rows
+std::vector<Item *> ItemFilterer::filter(ItemColumnView const &view, ItemFilterSpecification const *spec) {
+    std::vector<std::uint32_t> rows;
+    spec->select(view, rows);
+
+    std::vector<Item *> result;
+    result.reserve(rows.size());
+    for (auto row : rows) {
+        result.push_back(view.items[row]);
+    }
+
+    return result;
+}
+
+//Planner: get the candidates through the most selective index, or scan
+std::vector<Item *> ItemFilterer::filter(ItemRepository &repository, ItemFilterSpecification const *spec,
+                                         QueryPlan &plan) {
+    std::vector<Item *> result;
+    std::size_t estimate = 0;
+    ItemFilterSpecification const *driver = spec->plan(repository, estimate);
+    std::vector<Item *> candidates;
+    if (driver != nullptr && driver->lookup(repository, candidates)) {
+        plan.access = driver->index_name();
+        plan.estimate = estimate;
+        plan.candidates = candidates.size();
+
+        //The index answers the whole specification, otherwise check it on the candidates
+        if (driver == spec) {
+            result = std::move(candidates);
+        } else {
+            for (auto item : candidates) {
+                if (spec->is_satisfied(item)) {
+                    result.push_back(item);
+                }
+            }
+        }
+    } else {
+        ItemColumnView columns;
+        if (repository.get_columns(columns)) {
+            plan.access = "column scan";
+            plan.candidates = columns.size;
+            result = filter(columns, spec);
+        } else {
+            plan.access = "scan";
+            plan.candidates = repository.get_items().size();
+            result = filter(repository.get_items(), spec);
+        }
+        plan.estimate = plan.candidates;
+    }
+
+    plan.results = result.size();
+    return result;
+}
+
 //Aggregated class
 //Each attributes: repo, displayer, filterer and persistence
 //can be switched out and replaced by another implementation
@@ -399,11 +1510,23 @@ ItemService::~ItemService() {
 }
 
 void ItemService::load() {
-    repository->set_items(persistence->load());
+    repository->set_items(persistence->load(repository->get_arena()));
+    saved_version = repository->get_version();
 }
 
 void ItemService::save() {
+    if (repository->get_version() == saved_version) {
+        std::cout << "[INFO] No changes to the items, nothing to save" << std::endl;
+        return;
+    }
     persistence->save(repository->get_items());
+    saved_version = repository->get_version();
+}
+
+PendingFile ItemService::render() {
+    //The checkpoint writes what is rendered here
+    saved_version = repository->get_version();
+    return persistence->render(repository->get_items());
 }
 
 Item *ItemService::get(std::string const &id) {
@@ -414,33 +1537,75 @@ bool ItemService::check_if_exists(const std::string &id) {
     return get(id) != nullptr;
 }
 
-std::vector<Item *> ItemService::get_all() {
+std::vector<Item *> const &ItemService::get_all() {
     return repository->get_items();
 }
 
 void ItemService::add(Item *item) {
     repository->add_item(item);
+    //The item is not added if its id is taken
+    if (journal != nullptr && item != nullptr && repository->get_item(item->get_id()) == item) {
+        journal->item_put(item);
+    }
 }
 
 void ItemService::remove(std::string const &id) {
+    Item *item = repository->get_item(id);
     repository->remove_item(id);
+    //A borrowed item is not removed
+    if (journal != nullptr && item != nullptr && repository->get_item(id) == nullptr) {
+        journal->item_removed(item->get_key());
+    }
 }
 
 void ItemService::update(std::string const &id, ItemModificationIntent &intent) {
     repository->update_item(id, intent);
+    Item *item = repository->get_item(id);
+    if (journal != nullptr && item != nullptr) {
+        journal->item_put(item);
+    }
 }
 
 void ItemService::update_genre(std::string const &id, GenredItemModificationIntent &intent) {
     repository->update_genred_item(id, intent);
+    Item *item = repository->get_item(id);
+    if (journal != nullptr && item != nullptr) {
+        journal->item_put(item);
+    }
 }
 
 void ItemService::display(ItemOrder const *order) {
-    displayer->display(repository->get_items(), order);
+    //Walk the ordered index of the repository if it keeps this order, otherwise sort
+    std::vector<Item *> const *ordered = order->ordered(*repository);
+    if (ordered != nullptr) {
+        ItemNoOrder no_order;
+        displayer->display(*ordered, &no_order);
+    } else {
+        displayer->display(repository->get_items(), order);
+    }
+}
+
+ItemPage ItemService::page(ItemOrder const *order, ItemCursor const *cursor, bool forward, std::size_t page_size) {
+    //Binary search in the ordered index of the repository if it keeps this order,
+    //otherwise sort only the page out of the items (the repository order is not sorted by any field)
+    std::vector<Item *> const *ordered = order->reorders() ? order->ordered(*repository) : nullptr;
+    if (ordered != nullptr) {
+        return get_page(*ordered, true, *order, cursor, forward, page_size);
+    }
+    return get_page(repository->get_items(), false, *order, cursor, forward, page_size);
+}
+
+void ItemService::display_page(ItemPage const &page) {
+    ItemNoOrder no_order;
+    displayer->display(page.records, &no_order);
 }
 
 void ItemService::filter(ItemFilterSpecification const *spec) {
-    //Get filtered element
-    auto filtered = filterer->filter(repository->get_items(), spec);
+    //Get filtered element through the most selective index the spec can use, or by a scan
+    auto filtered = filterer->filter(*repository, spec, last_plan);
+    if (profiling) {
+        std::cout << last_plan << std::endl;
+    }
 
     //Check if length is not 0
     if (filtered.size() == 0) {
@@ -453,3 +1618,12 @@ void ItemService::filter(ItemFilterSpecification const *spec) {
     displayer->display(filtered, &order);
 }
 
+
+std::size_t ItemService::count(ItemFilterSpecification const *spec) {
+    //Popcount of the bitmap when the bitmap index can answer, otherwise filter
+    Bitmap bits;
+    if (spec->bitmap(*repository, bits)) {
+        return bits.count();
+    }
+    return filterer->filter(*repository, spec, last_plan).size();
+}
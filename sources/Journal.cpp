@@ -0,0 +1,578 @@
+#include "../headers/Journal.h"
+#include "../headers/MappedFile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <unistd.h>
+
+//A record is its payload size, its kind, its payload and the checksum of the kind and the payload
+static const std::size_t record_overhead = 4 + 1 + 4;
+
+//Write the rendered data files together, then drop the journals they contain
+//Both data files are synced, then renamed, before any journal is dropped
+static bool write_data_files(std::vector<PendingFile> const &files, std::vector<std::string> const &journals) {
+    FileBatch batch;
+    for (auto const &file : files) {
+        if (!batch.add(file)) {
+            //Keep the journals, they are replayed on top of the old data files
+            std::cerr << "[ERROR] Cannot write " << file.path << std::endl;
+            return false;
+        }
+    }
+    if (!batch.commit()) {
+        std::cerr << "[ERROR] Cannot replace the data files" << std::endl;
+        return false;
+    }
+    for (auto const &journal : journals) {
+        std::remove(journal.c_str());
+    }
+    return true;
+}
+
+//FNV-1a of the kind and the payload of a record
+static std::uint32_t record_checksum(char const *data, std::size_t size) {
+    std::uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < size; i++) {
+        hash = (hash ^ (unsigned char) data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+//Reads the fields of a payload in the order they were put, failing (ok is false)
+//instead of reading past the end
+struct PayloadReader {
+    std::string_view payload;
+    bool ok = true;
+
+    std::uint8_t get_u8() {
+        if (payload.empty()) {
+            ok = false;
+            return 0;
+        }
+        auto value = (std::uint8_t) payload[0];
+        payload.remove_prefix(1);
+        return value;
+    }
+
+    std::uint32_t get_u32() {
+        std::uint32_t value = 0;
+        if (payload.size() < sizeof(value)) {
+            ok = false;
+            return 0;
+        }
+        std::memcpy(&value, payload.data(), sizeof(value));
+        payload.remove_prefix(sizeof(value));
+        return value;
+    }
+
+    float get_float() {
+        std::uint32_t bits = get_u32();
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    std::string_view get_string() {
+        std::uint32_t length = get_u32();
+        if (payload.size() < length) {
+            ok = false;
+            return {};
+        }
+        std::string_view value = payload.substr(0, length);
+        payload.remove_prefix(length);
+        return value;
+    }
+};
+
+//Set every field of an item at once, so the indexes of the repository move it once
+struct ItemValuesIntent : public ItemModificationIntent {
+    std::string title;
+    Item::RentalType rental_type = Item::RentalType::OneWeek;
+    unsigned int stock = 0;
+    float fee = 0;
+    //The status is left as it is when it is not restored
+    bool set_rental_status = false;
+    Item::RentalStatus rental_status = Item::RentalStatus::Available;
+
+    void modify() override {
+        if (item->get_title() != title) {
+            item->set_title(title);
+        }
+        item->set_rental_type(rental_type);
+        item->set_num_in_stock(stock);
+        item->set_rental_fee(fee);
+        if (set_rental_status) {
+            item->set_rental_status(rental_status);
+        }
+    }
+};
+
+//Set every field of a customer at once, the level without the promotion rules
+struct CustomerValuesIntent : public ModificationIntent {
+    std::string name;
+    std::string address;
+    std::string phone;
+    Category level = Category::guest;
+    std::vector<Item *> rentals;
+    int number_of_rentals = 0;
+    int number_of_videos = 0;
+
+    void modify() override {
+        if (customer->get_name() != name) {
+            customer->set_name(name);
+        }
+        if (customer->get_address() != address) {
+            customer->set_address(address);
+        }
+        customer->set_phone(phone);
+        if (customer->get_state() != level) {
+            switch (level) {
+                case Category::guest:
+                    customer->change_state(new GuestState());
+                    break;
+                case Category::regular:
+                    customer->change_state(new RegularState());
+                    break;
+                case Category::vip:
+                    customer->change_state(new VIPState());
+                    break;
+            }
+        }
+        customer->set_rentals(rentals, number_of_rentals, number_of_videos);
+    }
+};
+
+//Set the rentals of a customer, after a borrow or a return
+struct CustomerRentalsIntent : public ModificationIntent {
+    std::vector<Item *> rentals;
+    int number_of_rentals = 0;
+    int number_of_videos = 0;
+
+    void modify() override {
+        customer->set_rentals(rentals, number_of_rentals, number_of_videos);
+    }
+};
+
+static CustomerState *create_state(Category level) {
+    switch (level) {
+        case Category::regular:
+            return new RegularState();
+        case Category::vip:
+            return new VIPState();
+        default:
+            return new GuestState();
+    }
+}
+
+Journal::Journal(ItemService &item_service, CustomerService &customer_service, bool restore_rental_status,
+                 std::size_t checkpoint_size, std::size_t sync_batch) :
+        item_service(item_service), customer_service(customer_service), restore_rental_status(restore_rental_status),
+        checkpoint_size(checkpoint_size), sync_batch(sync_batch) {}
+
+Journal::~Journal() {
+    close();
+}
+
+std::string Journal::file_name(std::uint64_t file_generation) const {
+    return std::string(directory) + "/journal." + std::to_string(file_generation) + ".log";
+}
+
+std::vector<std::uint64_t> Journal::list_generations() const {
+    std::vector<std::uint64_t> generations;
+    std::error_code error;
+    for (auto const &entry : std::filesystem::directory_iterator(directory, error)) {
+        std::string name = entry.path().filename().string();
+        if (name.size() > 12 && name.compare(0, 8, "journal.") == 0
+            && name.compare(name.size() - 4, 4, ".log") == 0) {
+            std::string number = name.substr(8, name.size() - 12);
+            if (number.find_first_not_of("0123456789") == std::string::npos) {
+                generations.push_back(std::stoull(number));
+            }
+        }
+    }
+    std::sort(generations.begin(), generations.end());
+    return generations;
+}
+
+bool Journal::open_file(std::uint64_t file_generation) {
+    descriptor = ::open(file_name(file_generation).c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    generation = file_generation;
+    size = 0;
+    unsynced = 0;
+    if (descriptor == -1) {
+        std::cerr << "[ERROR] Cannot open the journal, changes will only be saved at exit" << std::endl;
+        return false;
+    }
+    //The new file must survive a crash along with the records synced to it
+    sync_path(directory, true);
+    return true;
+}
+
+void Journal::sync() {
+    if (descriptor != -1 && unsynced != 0) {
+        if (::fdatasync(descriptor) != 0) {
+            std::cerr << "[ERROR] Cannot sync the journal" << std::endl;
+        }
+        unsynced = 0;
+    }
+}
+
+void Journal::open() {
+    //Replay the journals in the order they were written, then write the next one
+    std::vector<std::uint64_t> generations = list_generations();
+    std::size_t replayed = 0;
+    for (std::uint64_t file_generation : generations) {
+        replayed += replay(file_generation);
+    }
+    if (replayed != 0) {
+        std::cout << "[INFO] Replayed " << replayed << " change(s) from the journal" << std::endl;
+    }
+    open_file(generations.empty() ? 1 : generations.back() + 1);
+
+    //Short sessions each leave a small journal, fold them once they add up
+    if (is_open() && replayed_size >= checkpoint_size) {
+        checkpoint();
+    }
+}
+
+void Journal::close() {
+    if (checkpoint_thread.joinable()) {
+        checkpoint_thread.join();
+    }
+    if (descriptor != -1) {
+        sync();
+        ::close(descriptor);
+        descriptor = -1;
+        //A session without changes leaves no journal behind
+        if (size == 0) {
+            std::remove(file_name(generation).c_str());
+        }
+    }
+}
+
+std::size_t Journal::replay(std::uint64_t file_generation) {
+    MappedFile file;
+    if (!file.open(file_name(file_generation))) {
+        return 0;
+    }
+
+    std::string_view text = file.contents();
+    replayed_size += text.size();
+    std::size_t count = 0;
+    while (text.size() >= record_overhead) {
+        std::uint32_t payload_size;
+        std::memcpy(&payload_size, text.data(), sizeof(payload_size));
+        if (text.size() - record_overhead < payload_size) {
+            break;
+        }
+        std::string_view body = text.substr(4, 1 + payload_size);
+        std::uint32_t checksum;
+        std::memcpy(&checksum, text.data() + 4 + body.size(), sizeof(checksum));
+        if (checksum != record_checksum(body.data(), body.size())) {
+            break;
+        }
+        apply((Kind) body[0], body.substr(1));
+        text.remove_prefix(record_overhead + payload_size);
+        count++;
+    }
+    if (!text.empty()) {
+        std::cout << "[LOG] Ignoring the end of " << file_name(file_generation) << " (record cut by a crash)"
+                  << std::endl;
+    }
+    return count;
+}
+
+void Journal::apply(Kind kind, std::string_view payload) {
+    PayloadReader reader{payload};
+    switch (kind) {
+        case Kind::ItemPut: {
+            ItemId id(reader.get_u32());
+            auto type = (ItemType) reader.get_u8();
+            ItemValuesIntent values;
+            values.rental_type = (Item::RentalType) reader.get_u8();
+            auto rental_status = (Item::RentalStatus) reader.get_u8();
+            //A new item is available, like the items loaded from items.txt, when the status is not restored
+            values.set_rental_status = restore_rental_status;
+            values.rental_status = restore_rental_status ? rental_status : Item::RentalStatus::Available;
+            auto genre = (GenredItem::Genre) reader.get_u8();
+            values.stock = reader.get_u32();
+            values.fee = reader.get_float();
+            values.title = std::string(reader.get_string());
+            if (!reader.ok) {
+                return;
+            }
+
+            std::string id_text = decode_item_id(id);
+            Item *item = item_service.get(id_text);
+            if (item == nullptr) {
+                if (type == GAME) {
+                    item = new Game(id, values.title, values.rental_type, values.stock, values.fee,
+                                    values.rental_status);
+                } else if (type == VIDEO) {
+                    item = new VideoRecord(id, values.title, values.rental_type, values.stock, values.fee,
+                                           values.rental_status, genre);
+                } else {
+                    item = new DVD(id, values.title, values.rental_type, values.stock, values.fee,
+                                   values.rental_status, genre);
+                }
+                item_service.add(item);
+            } else {
+                item_service.update(id_text, values);
+                if (item->get_type() != GAME) {
+                    GenredItemGenreModificationIntent genre_intent{genre};
+                    item_service.update_genre(id_text, genre_intent);
+                }
+            }
+        }
+            break;
+        case Kind::ItemRemoved: {
+            ItemId id(reader.get_u32());
+            std::string id_text = decode_item_id(id);
+            if (reader.ok && item_service.get(id_text) != nullptr) {
+                item_service.remove(id_text);
+            }
+        }
+            break;
+        case Kind::CustomerPut: {
+            CustomerId id(reader.get_u32());
+            CustomerValuesIntent values;
+            values.level = (Category) reader.get_u8();
+            values.number_of_rentals = (int) reader.get_u32();
+            values.number_of_videos = (int) reader.get_u32();
+            values.name = std::string(reader.get_string());
+            values.address = std::string(reader.get_string());
+            values.phone = std::string(reader.get_string());
+            std::uint32_t rental_count = reader.get_u32();
+            for (std::uint32_t i = 0; i < rental_count && reader.ok; i++) {
+                Item *item = item_service.get(decode_item_id(ItemId(reader.get_u32())));
+                if (item != nullptr) {
+                    values.rentals.push_back(item);
+                }
+            }
+            if (!reader.ok) {
+                return;
+            }
+
+            std::string id_text = decode_customer_id(id);
+            if (customer_service.get(id_text) == nullptr) {
+                auto *customer = new Customer(id, values.name, values.address, values.phone,
+                                              values.number_of_rentals, values.rentals, create_state(values.level));
+                customer->set_rentals(values.rentals, values.number_of_rentals, values.number_of_videos);
+                customer_service.add(customer);
+            } else {
+                customer_service.update(id_text, values);
+            }
+        }
+            break;
+        case Kind::CustomerRemoved: {
+            CustomerId id(reader.get_u32());
+            std::string id_text = decode_customer_id(id);
+            if (reader.ok && customer_service.get(id_text) != nullptr) {
+                customer_service.remove(id_text);
+            }
+        }
+            break;
+        case Kind::Borrowed:
+        case Kind::Returned: {
+            std::string customer_id = decode_customer_id(CustomerId(reader.get_u32()));
+            Customer *customer = customer_service.get(customer_id);
+            std::string item_id = decode_item_id(ItemId(reader.get_u32()));
+            Item *item = item_service.get(item_id);
+            unsigned int stock = reader.get_u32();
+            auto rental_status = (Item::RentalStatus) reader.get_u8();
+            int number_of_rentals = (int) reader.get_u32();
+            int number_of_videos = (int) reader.get_u32();
+            if (!reader.ok || customer == nullptr || item == nullptr) {
+                return;
+            }
+
+            //The item gets the stock and status it had after the change
+            ItemValuesIntent item_values;
+            item_values.title = std::string(item->get_title());
+            item_values.rental_type = item->get_rental_type();
+            item_values.stock = stock;
+            item_values.fee = item->get_rental_fee();
+            item_values.set_rental_status = restore_rental_status;
+            item_values.rental_status = rental_status;
+            item_service.update(item_id, item_values);
+
+            //The customer has the item in its rentals after a borrow, not after a return
+            //Updated through the service, so a repository reading customers on demand keeps the change
+            CustomerRentalsIntent customer_values;
+            customer_values.rentals = customer->get_items();
+            auto position = std::find(customer_values.rentals.begin(), customer_values.rentals.end(), item);
+            if (kind == Kind::Borrowed && position == customer_values.rentals.end()) {
+                customer_values.rentals.push_back(item);
+            } else if (kind == Kind::Returned && position != customer_values.rentals.end()) {
+                customer_values.rentals.erase(position);
+            }
+            customer_values.number_of_rentals = number_of_rentals;
+            customer_values.number_of_videos = number_of_videos;
+            customer_service.update(customer_id, customer_values);
+        }
+            break;
+    }
+}
+
+void Journal::begin(Kind kind) {
+    record.clear();
+    put_u32(0);
+    record.push_back((char) kind);
+}
+
+void Journal::put_u32(std::uint32_t value) {
+    record.append(reinterpret_cast<char const *>(&value), sizeof(value));
+}
+
+void Journal::put_float(float value) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    put_u32(bits);
+}
+
+void Journal::put_string(std::string_view value) {
+    put_u32((std::uint32_t) value.size());
+    record.append(value.data(), value.size());
+}
+
+void Journal::put_customer_rentals(Customer const *customer) {
+    put_u32((std::uint32_t) customer->get_number_of_rentals());
+    put_u32((std::uint32_t) customer->get_number_of_videos());
+}
+
+//Frame the record and append it to the journal file with a single write
+void Journal::end() {
+    auto payload_size = (std::uint32_t) (record.size() - 5);
+    std::memcpy(&record[0], &payload_size, sizeof(payload_size));
+    std::uint32_t checksum = record_checksum(record.data() + 4, record.size() - 4);
+    put_u32(checksum);
+
+    if (descriptor == -1) {
+        return;
+    }
+    if (!write_all(descriptor, record)) {
+        //Cut the part of the record written, so the records before it still replay,
+        //and stop journaling: the session is saved in full at exit instead
+        std::cerr << "[ERROR] Cannot write to the journal, changes will be saved at exit" << std::endl;
+        if (::ftruncate(descriptor, (off_t) size) != 0) {
+            std::cerr << "[ERROR] Cannot cut the journal" << std::endl;
+        }
+        sync();
+        ::close(descriptor);
+        descriptor = -1;
+        return;
+    }
+    size += record.size();
+    if (++unsynced >= sync_batch) {
+        sync();
+    }
+    if (replayed_size + size >= checkpoint_size) {
+        checkpoint();
+    }
+}
+
+void Journal::item_put(Item const *item) {
+    begin(Kind::ItemPut);
+    put_u32(item->get_key().value);
+    record.push_back((char) item->get_type());
+    record.push_back((char) item->get_rental_type());
+    record.push_back((char) item->get_rental_status());
+    record.push_back((char) (item->get_type() != GAME ? static_cast<GenredItem const *>(item)->get_genre()
+                                                       : GenredItem::Genre::Action));
+    put_u32(item->get_number_in_stock());
+    put_float(item->get_rental_fee());
+    put_string(item->get_title());
+    end();
+}
+
+void Journal::item_removed(ItemId id) {
+    begin(Kind::ItemRemoved);
+    put_u32(id.value);
+    end();
+}
+
+void Journal::customer_put(Customer const *customer) {
+    begin(Kind::CustomerPut);
+    put_u32(customer->get_key().value);
+    record.push_back((char) customer->get_state());
+    put_customer_rentals(customer);
+    put_string(customer->get_name());
+    put_string(customer->get_address());
+    put_string(customer->get_phone());
+    put_u32((std::uint32_t) customer->get_items().size());
+    for (Item const *item : customer->get_items()) {
+        put_u32(item->get_key().value);
+    }
+    end();
+}
+
+void Journal::customer_removed(CustomerId id) {
+    begin(Kind::CustomerRemoved);
+    put_u32(id.value);
+    end();
+}
+
+void Journal::borrowed(Customer const *customer, Item const *item) {
+    begin(Kind::Borrowed);
+    put_u32(customer->get_key().value);
+    put_u32(item->get_key().value);
+    put_u32(item->get_number_in_stock());
+    record.push_back((char) item->get_rental_status());
+    put_customer_rentals(customer);
+    end();
+}
+
+void Journal::returned(Customer const *customer, Item const *item) {
+    begin(Kind::Returned);
+    put_u32(customer->get_key().value);
+    put_u32(item->get_key().value);
+    put_u32(item->get_number_in_stock());
+    record.push_back((char) item->get_rental_status());
+    put_customer_rentals(customer);
+    end();
+}
+
+void Journal::checkpoint() {
+    //One checkpoint at a time
+    if (checkpoint_thread.joinable()) {
+        checkpoint_thread.join();
+    }
+
+    //The changes from now on go to a new journal file, the current ones are folded
+    std::uint64_t folded = generation;
+    replayed_size = 0;
+    if (descriptor != -1) {
+        sync();
+        ::close(descriptor);
+    }
+    open_file(folded + 1);
+
+    //Render the data files now, write them and drop the folded journals in the background
+    std::vector<PendingFile> files;
+    files.push_back(item_service.render());
+    files.push_back(customer_service.render(item_service.get_all()));
+    std::vector<std::string> journals;
+    for (std::uint64_t file_generation : list_generations()) {
+        if (file_generation <= folded) {
+            journals.push_back(file_name(file_generation));
+        }
+    }
+    checkpoint_thread = std::thread([files = std::move(files), journals = std::move(journals)]() {
+        write_data_files(files, journals);
+    });
+}
+
+bool Journal::fold() {
+    close();
+    std::vector<PendingFile> files;
+    files.push_back(item_service.render());
+    files.push_back(customer_service.render(item_service.get_all()));
+    std::vector<std::string> journals;
+    for (std::uint64_t file_generation : list_generations()) {
+        journals.push_back(file_name(file_generation));
+    }
+    return write_data_files(files, journals);
+}
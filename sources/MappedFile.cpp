@@ -0,0 +1,66 @@
+#include "../headers/MappedFile.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(std::string const &path) {
+    close();
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor == -1) {
+        return false;
+    }
+
+    struct stat status{};
+    if (fstat(descriptor, &status) == -1) {
+        ::close(descriptor);
+        return false;
+    }
+
+    //An empty file can not be mapped, its contents are just empty
+    if (status.st_size > 0) {
+        void *mapping = mmap(nullptr, (std::size_t) status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(descriptor);
+            return false;
+        }
+        madvise(mapping, (std::size_t) status.st_size, MADV_SEQUENTIAL);
+        data = static_cast<char const *>(mapping);
+        size = (std::size_t) status.st_size;
+    }
+
+    //The mapping stays valid once the descriptor is closed
+    ::close(descriptor);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data != nullptr) {
+        munmap(const_cast<char *>(data), size);
+    }
+    data = nullptr;
+    size = 0;
+}
+
+bool next_line(std::string_view &text, std::string_view &line) {
+    if (text.empty()) {
+        return false;
+    }
+
+    std::size_t end = text.find('\n');
+    if (end == std::string_view::npos) {
+        line = text;
+        text = {};
+    } else {
+        line = text.substr(0, end);
+        text.remove_prefix(end + 1);
+    }
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    return true;
+}
@@ -5,25 +5,52 @@
 #include "../headers/ItemHelpers.h"
 
 //Constructor
-Menu::Menu() {
+Menu::Menu(MenuOptions const &options) {
     //Create customer service and item service using builder
-    StandardCustomerServiceBuilder customer_builder;
-    StandardItemServiceBuilder item_builder;
-    item_service = item_builder.create();
-    customer_service = customer_builder.create();
+    if (options.columnar_items) {
+        ColumnarItemServiceBuilder item_builder(options.format);
+        item_service = item_builder.create();
+    } else {
+        StandardItemServiceBuilder item_builder(options.format);
+        item_service = item_builder.create();
+    }
+    if (options.lazy_customers) {
+        LazyCustomerServiceBuilder customer_builder;
+        customer_service = customer_builder.create();
+    } else {
+        StandardCustomerServiceBuilder customer_builder(options.format);
+        customer_service = customer_builder.create();
+    }
+
+    item_service->set_profiling(options.profile);
+    customer_service->set_profiling(options.profile);
 
     //Load in items and customer
     item_service->load();
     customer_service->load(item_service->get_all());
+
+    //Apply the changes of the previous sessions, then journal the changes of this one
+    //Only the snapshots store the rental status, items.txt does not
+    journal = new Journal(*item_service, *customer_service, options.format == StorageFormat::Snapshot);
+    journal->open();
+    if (journal->is_open()) {
+        item_service->set_journal(journal);
+        customer_service->set_journal(journal);
+    }
 }
 
 //Destructor
 Menu::~Menu() {
-    //Save items and customers
-    item_service->save();
-    customer_service->save();
+    //The changes are already in the journal, the data files are only written by its
+    //checkpoints (or here, in full, if the journal could not be opened or a write to it failed)
+    bool journaled = journal->is_open();
+    journal->close();
+    if (!journaled && journal->fold()) {
+        std::cout << "[SUCCESS] Successfully saved the data files!" << std::endl;
+    }
 
     //Clear memory
+    delete journal;
     delete item_service;
     delete customer_service;
 }
@@ -97,6 +124,7 @@ bool Menu::display_customer_menu() {
     std::cout << "4. Display all customers" << std::endl;
     std::cout << "5. Display group of customers" << std::endl;
     std::cout << "6. Search customers" << std::endl;
+    std::cout << "7. Browse customers by page" << std::endl;
     std::cout << "0. Exit" << std::endl;
     std::cout << "Select option:" << std::endl;
 
@@ -131,9 +159,10 @@ bool Menu::display_customer_menu() {
             std::string id;
             std::cout << "Input customer ID that you want to edit:" << std::endl;
             std::cin >> id;
-            Customer *customer = customer_service->get(id);
-            if (customer != nullptr) {
-                customer->promote();
+            if (customer_service->get(id) != nullptr) {
+                //Promote through the service so the level order of the repository is kept
+                PromotionModificationIntent promotion;
+                customer_service->update(id, promotion);
                 std::cerr << "Promote customer successful. \n" << std::endl;
             } else {
                 std::cerr << "Customer does not exist. \n" << std::endl;
@@ -206,6 +235,9 @@ bool Menu::display_customer_menu() {
             }
         }
             break;
+        case 7:
+            browse_customers();
+            break;
         case 0:
             return false;
         default:
@@ -228,6 +260,7 @@ bool Menu::display_item_menu() {
     std::cout << "6. Display all items" << std::endl;
     std::cout << "7. Display out of stock item" << std::endl;
     std::cout << "8. Search items" << std::endl;
+    std::cout << "9. Browse items by page" << std::endl;
     std::cout << "0. Exit" << std::endl;
     std::cout << "Select option:" << std::endl;
 
@@ -275,7 +308,7 @@ bool Menu::display_item_menu() {
             Customer *customer = customer_service->get(customer_id);
             Item *item = item_service->get(item_id);
             if (customer != nullptr && item != nullptr) {
-                customer->borrow(item);
+                customer_service->borrow(customer, item);
                 std::cout << std::endl;
             } else {
                 std::cerr << "Item/Customer is not exist.\n" << std::endl;
@@ -292,7 +325,7 @@ bool Menu::display_item_menu() {
             Customer *customer = customer_service->get(customer_id);
             Item *item = item_service->get(item_id);
             if (customer != nullptr && item != nullptr) {
-                if (customer->return_item(item)) {
+                if (customer_service->return_item(customer, item)) {
                     std::cout << "Item rented returned successfully.\n" << std::endl;
                 }
             } else {
@@ -340,6 +373,9 @@ bool Menu::display_item_menu() {
             }
         }
             break;
+        case 9:
+            browse_items();
+            break;
         case 0:
             return false;
         default:
@@ -792,3 +828,75 @@ void Menu::modify_item(const std::string &id, ItemType type) {
     }
     std::cout << "Updated item successfully.\n" << std::endl;
 }
+
+std::size_t Menu::read_page_size() {
+    while (true) {
+        std::string page_size_string;
+        std::cout << "Input number of records per page:" << std::endl;
+        std::cin >> page_size_string;
+        int page_size = process_input(page_size_string);
+        if (page_size > 0) {
+            return (std::size_t) page_size;
+        }
+        std::cerr << "Invalid input." << std::endl;
+    }
+}
+
+//Get 1 for the next page, 2 for the previous one and 0 to stop browsing
+int Menu::read_page_option(bool has_previous, bool has_next) {
+    while (true) {
+        if (has_next) {
+            std::cout << "1. Next page" << std::endl;
+        }
+        if (has_previous) {
+            std::cout << "2. Previous page" << std::endl;
+        }
+        std::cout << "0. Back" << std::endl;
+        std::cout << "Select option:" << std::endl;
+
+        std::string option_string;
+        std::cin >> option_string;
+        std::cout << std::endl;
+        int option = process_input(option_string);
+        if (option == 0 || (option == 1 && has_next) || (option == 2 && has_previous)) {
+            return option;
+        }
+        std::cerr << "Invalid option. Please try again." << std::endl;
+    }
+}
+
+void Menu::browse_customers() {
+    //Pages follow the ids, the cursors keep their place when customers are added or removed
+    std::size_t page_size = read_page_size();
+    CustomerIdOrder order;
+    CustomerPage page = customer_service->page(&order, nullptr, true, page_size);
+    while (true) {
+        customer_service->display_page(page);
+        std::cout << std::endl;
+
+        int option = read_page_option(page.has_previous, page.has_next);
+        if (option == 0) {
+            break;
+        }
+        page = option == 1 ? customer_service->page(&order, &page.last, true, page_size)
+                           : customer_service->page(&order, &page.first, false, page_size);
+    }
+}
+
+void Menu::browse_items() {
+    //Pages follow the ids, the cursors keep their place when items are added or removed
+    std::size_t page_size = read_page_size();
+    ItemIdOrder order;
+    ItemPage page = item_service->page(&order, nullptr, true, page_size);
+    while (true) {
+        item_service->display_page(page);
+        std::cout << std::endl;
+
+        int option = read_page_option(page.has_previous, page.has_next);
+        if (option == 0) {
+            break;
+        }
+        page = option == 1 ? item_service->page(&order, &page.last, true, page_size)
+                           : item_service->page(&order, &page.first, false, page_size);
+    }
+}
@@ -0,0 +1,90 @@
+#include "../headers/OutputBuffer.h"
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+
+const std::size_t OutputBuffer::default_chunk_size;
+
+OutputBuffer::OutputBuffer(std::ostream &sink, std::size_t chunk_size) : sink(&sink), chunk_size(chunk_size) {
+    data.reserve(chunk_size + chunk_size / 4);
+}
+
+OutputBuffer::~OutputBuffer() {
+    if (sink != nullptr) {
+        flush();
+    }
+}
+
+//Digits are written from the end of a stack buffer, then appended at once
+void OutputBuffer::append_unsigned(unsigned long long value) {
+    char text[20];
+    char *begin = text + sizeof(text);
+    do {
+        *--begin = (char) ('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    data.append(begin, text + sizeof(text) - begin);
+}
+
+void OutputBuffer::append_signed(long long value) {
+    if (value < 0) {
+        data.push_back('-');
+        append_unsigned(0ull - (unsigned long long) value);
+    } else {
+        append_unsigned((unsigned long long) value);
+    }
+}
+
+void OutputBuffer::append_general(float value) {
+    char text[32];
+    auto result = std::to_chars(text, text + sizeof(text), value, std::chars_format::general, 6);
+    data.append(text, result.ptr - text);
+}
+
+void OutputBuffer::append_fixed(float value, int decimals) {
+    static const double scales[] = {1, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6};
+    static const std::uint64_t units[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+    //A float has 24 significant bits and 10^6 fits in 20, so the scaled value is exact
+    //in a double and rounding it to even gives the digits printf gives
+    double scaled = std::fabs((double) value) * scales[decimals];
+    if (!(scaled < 1e18)) {
+        //Huge values, infinities and NaN go through the library
+        char text[64];
+        auto result = std::to_chars(text, text + sizeof(text), value, std::chars_format::fixed, decimals);
+        data.append(text, result.ptr - text);
+        return;
+    }
+
+    auto rounded = (std::uint64_t) std::nearbyint(scaled);
+    if (std::signbit(value)) {
+        data.push_back('-');
+    }
+    append_unsigned(rounded / units[decimals]);
+    if (decimals == 0) {
+        return;
+    }
+
+    //Decimals with their leading zeros
+    data.push_back('.');
+    std::uint64_t fraction = rounded % units[decimals];
+    char text[6];
+    for (int i = decimals - 1; i >= 0; i--) {
+        text[i] = (char) ('0' + fraction % 10);
+        fraction /= 10;
+    }
+    data.append(text, decimals);
+}
+
+void OutputBuffer::flush() {
+    if (sink == nullptr) {
+        return;
+    }
+    write();
+    sink->flush();
+}
+
+void OutputBuffer::write() {
+    sink->write(data.data(), (std::streamsize) data.size());
+    data.clear();
+}
@@ -0,0 +1,76 @@
+#include "../headers/PackedId.h"
+
+//Read n digits starting at text[start], return false if one of them is not a digit
+static bool read_digits(std::string_view text, std::size_t start, std::size_t n, std::uint32_t &number) {
+    number = 0;
+    for (std::size_t i = start; i < start + n; i++) {
+        if (text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+        number = number * 10 + (text[i] - '0');
+    }
+    return true;
+}
+
+//Write number as n digits (with leading zeros) into out
+static void write_digits(std::uint32_t number, std::size_t n, char *out) {
+    for (std::size_t i = n; i > 0; i--) {
+        out[i - 1] = (char) ('0' + number % 10);
+        number /= 10;
+    }
+}
+
+bool encode_item_id(std::string_view id, ItemId &packed) {
+    std::uint32_t number, year;
+    if (id.length() != ItemId::length || id[0] != 'I' || id[4] != '-' ||
+        !read_digits(id, 1, 3, number) || !read_digits(id, 5, 4, year)) {
+        return false;
+    }
+    packed = ItemId{number * 10000 + year};
+    return true;
+}
+
+bool encode_customer_id(std::string_view id, CustomerId &packed) {
+    std::uint32_t number;
+    if (id.length() != CustomerId::length || id[0] != 'C' || !read_digits(id, 1, 3, number)) {
+        return false;
+    }
+    packed = CustomerId{number};
+    return true;
+}
+
+void write_item_id(ItemId id, char *out) {
+    out[0] = 'I';
+    write_digits(id.value / 10000, 3, out + 1);
+    out[4] = '-';
+    write_digits(id.value % 10000, 4, out + 5);
+}
+
+void write_customer_id(CustomerId id, char *out) {
+    out[0] = 'C';
+    write_digits(id.value, 3, out + 1);
+}
+
+std::string decode_item_id(ItemId id) {
+    char text[ItemId::length];
+    write_item_id(id, text);
+    return {text, ItemId::length};
+}
+
+std::string decode_customer_id(CustomerId id) {
+    char text[CustomerId::length];
+    write_customer_id(id, text);
+    return {text, CustomerId::length};
+}
+
+std::ostream &operator<<(std::ostream &os, ItemId id) {
+    char text[ItemId::length];
+    write_item_id(id, text);
+    return os.write(text, ItemId::length);
+}
+
+std::ostream &operator<<(std::ostream &os, CustomerId id) {
+    char text[CustomerId::length];
+    write_customer_id(id, text);
+    return os.write(text, CustomerId::length);
+}
@@ -1,5 +1,6 @@
 #include "../headers/ServiceBuilder.h"
 #include "../headers/ItemRepository.h"
+#include "../headers/Snapshot.h"
 
 
 CustomerService* StandardCustomerServiceBuilder::create() {
@@ -12,6 +13,29 @@ CustomerService* StandardCustomerServiceBuilder::create() {
     //Create filterer
     CustomerFilterer* filterer = new CustomerFilterer();
 
+    //Create persistence
+    CustomerPersistence* persistence;
+    if (format == StorageFormat::Snapshot) {
+        persistence = new SnapshotCustomerPersistence();
+    } else {
+        persistence = new TextFileCustomerPersistence();
+    }
+
+    //Create customer service
+    CustomerService* service = new CustomerService(repo, displayer, filterer, persistence);
+    return service;
+}
+
+CustomerService* LazyCustomerServiceBuilder::create() {
+    //Create repo
+    CustomerRepository* repo = new LazyCustomerRepository();
+
+    //Create diplay
+    CustomerDisplayer* displayer = new ConsoleCustomerDisplayer();
+
+    //Create filterer
+    CustomerFilterer* filterer = new CustomerFilterer();
+
     //Create persistence
     CustomerPersistence* persistence = new TextFileCustomerPersistence();
 
@@ -31,9 +55,36 @@ ItemService* StandardItemServiceBuilder::create() {
     ItemFilterer* filterer = new ItemFilterer();
 
     //Create persistence
-    ItemPersistence* persistence = new TextFileItemPersistence();
+    ItemPersistence* persistence;
+    if (format == StorageFormat::Snapshot) {
+        persistence = new SnapshotItemPersistence();
+    } else {
+        persistence = new TextFileItemPersistence();
+    }
 
     //Create customer service
     ItemService* service = new ItemService(repo, displayer, filterer, persistence);
     return service;
-}
\ No newline at end of file
+}
+ItemService* ColumnarItemServiceBuilder::create() {
+    //Create repo
+    ItemRepository* repo = new ColumnarItemRepository();
+
+    //Create diplay
+    ItemDisplayer* displayer = new ConsoleItemDisplayer();
+
+    //Create filterer
+    ItemFilterer* filterer = new ItemFilterer();
+
+    //Create persistence
+    ItemPersistence* persistence;
+    if (format == StorageFormat::Snapshot) {
+        persistence = new SnapshotItemPersistence();
+    } else {
+        persistence = new TextFileItemPersistence();
+    }
+
+    //Create item service
+    ItemService* service = new ItemService(repo, displayer, filterer, persistence);
+    return service;
+}
@@ -0,0 +1,448 @@
+#include "../headers/Snapshot.h"
+#include "../headers/ItemHelpers.h"
+#include "../headers/MappedFile.h"
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <type_traits>
+
+//Bump the version whenever a record changes, older snapshots are then ignored
+static const std::uint32_t snapshot_version = 1;
+static const char item_magic[8] = {'R', 'E', 'N', 'T', 'I', 'T', 'E', 'M'};
+static const char customer_magic[8] = {'R', 'E', 'N', 'T', 'C', 'U', 'S', 'T'};
+
+//Position of a rental whose item is not in the item snapshot
+static const std::uint32_t no_row = std::numeric_limits<std::uint32_t>::max();
+
+struct SnapshotHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t record_count;
+    std::uint32_t reference_count;
+    std::uint32_t heap_size;
+    std::uint64_t checksum;
+};
+
+//A string of the heap
+struct SnapshotString {
+    std::uint32_t offset;
+    std::uint32_t length;
+};
+
+struct ItemRecord {
+    std::uint32_t id;
+    SnapshotString title;
+    std::uint32_t stock;
+    float fee;
+    std::uint8_t type;
+    std::uint8_t rental_type;
+    std::uint8_t rental_status;
+    std::uint8_t genre;
+};
+
+struct CustomerRecord {
+    std::uint32_t id;
+    SnapshotString name;
+    SnapshotString address;
+    SnapshotString phone;
+    std::int32_t number_of_rentals;
+    std::uint32_t first_rental;
+    std::uint32_t rental_count;
+    std::uint8_t state;
+    std::uint8_t padding[3];
+};
+
+//Rental of a customer: position of the item in the item snapshot, and its id
+struct RentalReference {
+    std::uint32_t row;
+    std::uint32_t item_id;
+};
+
+static_assert(std::is_trivially_copyable<ItemRecord>::value && sizeof(ItemRecord) == 24, "ItemRecord layout");
+static_assert(std::is_trivially_copyable<CustomerRecord>::value && sizeof(CustomerRecord) == 44, "CustomerRecord layout");
+static_assert(sizeof(SnapshotHeader) == 32 && sizeof(RentalReference) == 8, "Snapshot layout");
+
+//FNV-1a over 8 bytes at a time, then over the remaining bytes
+static std::uint64_t snapshot_checksum(char const *data, std::size_t size) {
+    const std::uint64_t prime = 0x100000001b3ULL;
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * prime;
+    }
+    for (; i < size; i++) {
+        hash = (hash ^ (unsigned char) data[i]) * prime;
+    }
+    return hash;
+}
+
+//A snapshot being written: the records, the rentals and the heap are
+//gathered separately and written one after the other
+class SnapshotWriter {
+    std::string records;
+    std::string references;
+    std::string heap;
+
+public:
+    template<typename Record>
+    void add_record(Record const &record) {
+        records.append(reinterpret_cast<char const *>(&record), sizeof(Record));
+    }
+
+    void add_reference(RentalReference const &reference) {
+        references.append(reinterpret_cast<char const *>(&reference), sizeof(RentalReference));
+    }
+
+    SnapshotString add_string(std::string_view value) {
+        SnapshotString string{(std::uint32_t) heap.size(), (std::uint32_t) value.size()};
+        heap.append(value.data(), value.size());
+        return string;
+    }
+
+    //Get the whole snapshot, the header followed by the sections
+    std::string contents(char const (&magic)[8], std::size_t record_count) const {
+        std::string snapshot(sizeof(SnapshotHeader), '\0');
+        snapshot.reserve(sizeof(SnapshotHeader) + records.size() + references.size() + heap.size());
+        snapshot.append(records).append(references).append(heap);
+
+        SnapshotHeader header{};
+        std::memcpy(header.magic, magic, sizeof(header.magic));
+        header.version = snapshot_version;
+        header.record_count = (std::uint32_t) record_count;
+        header.reference_count = (std::uint32_t) (references.size() / sizeof(RentalReference));
+        header.heap_size = (std::uint32_t) heap.size();
+        header.checksum = snapshot_checksum(snapshot.data() + sizeof(SnapshotHeader),
+                                            snapshot.size() - sizeof(SnapshotHeader));
+        std::memcpy(&snapshot[0], &header, sizeof(header));
+        return snapshot;
+    }
+
+    bool write(std::string const &path, char const (&magic)[8], std::size_t record_count) const {
+        return replace_file(path, contents(magic, record_count));
+    }
+};
+
+//The sections of a mapped snapshot, once its header is checked
+struct SnapshotSections {
+    SnapshotHeader header;
+    char const *records;
+    char const *references;
+    std::string_view heap;
+};
+
+//Check the header, the size and the checksum of a mapped snapshot
+static bool open_snapshot(MappedFile const &file, char const (&magic)[8], std::size_t record_size,
+                          SnapshotSections &sections) {
+    std::string_view contents = file.contents();
+    if (contents.size() < sizeof(SnapshotHeader)) {
+        return false;
+    }
+    SnapshotHeader &header = sections.header;
+    std::memcpy(&header, contents.data(), sizeof(header));
+    if (std::memcmp(header.magic, magic, sizeof(header.magic)) != 0 || header.version != snapshot_version) {
+        return false;
+    }
+
+    std::uint64_t records_size = (std::uint64_t) header.record_count * record_size;
+    std::uint64_t references_size = (std::uint64_t) header.reference_count * sizeof(RentalReference);
+    if (sizeof(SnapshotHeader) + records_size + references_size + header.heap_size != contents.size()) {
+        return false;
+    }
+    std::string_view body = contents.substr(sizeof(SnapshotHeader));
+    if (snapshot_checksum(body.data(), body.size()) != header.checksum) {
+        return false;
+    }
+
+    sections.records = body.data();
+    sections.references = body.data() + records_size;
+    sections.heap = body.substr(records_size + references_size);
+    return true;
+}
+
+template<typename Record>
+static Record read_record(char const *records, std::size_t index) {
+    Record record;
+    std::memcpy(&record, records + index * sizeof(Record), sizeof(Record));
+    return record;
+}
+
+static bool string_in_heap(SnapshotString string, std::string_view heap) {
+    return (std::uint64_t) string.offset + string.length <= heap.size();
+}
+
+static std::string_view heap_string(SnapshotString string, std::string_view heap) {
+    return heap.substr(string.offset, string.length);
+}
+
+static void add_item_records(SnapshotWriter &writer, std::vector<Item *> const &items) {
+    for (Item const *item : items) {
+        ItemRecord record{};
+        record.id = item->get_key().value;
+        record.title = writer.add_string(item->get_title());
+        record.stock = item->get_number_in_stock();
+        record.fee = item->get_rental_fee();
+        record.type = (std::uint8_t) item->get_type();
+        record.rental_type = (std::uint8_t) item->get_rental_type();
+        record.rental_status = (std::uint8_t) item->get_rental_status();
+        if (item->get_type() != GAME) {
+            record.genre = (std::uint8_t) static_cast<GenredItem const *>(item)->get_genre();
+        }
+        writer.add_record(record);
+    }
+}
+
+bool write_item_snapshot(std::string const &path, std::vector<Item *> const &items) {
+    SnapshotWriter writer;
+    add_item_records(writer, items);
+    return writer.write(path, item_magic, items.size());
+}
+
+bool read_item_snapshot(std::string const &path, Arena &arena, std::vector<Item *> &items) {
+    MappedFile file;
+    SnapshotSections sections{};
+    if (!file.open(path) || !open_snapshot(file, item_magic, sizeof(ItemRecord), sections)) {
+        return false;
+    }
+
+    //Check every record before creating any item, so a bad snapshot loads nothing
+    std::uint32_t count = sections.header.record_count;
+    for (std::uint32_t i = 0; i < count; i++) {
+        auto record = read_record<ItemRecord>(sections.records, i);
+        if (!string_in_heap(record.title, sections.heap) || record.type > DISC || record.rental_type > 1
+            || record.rental_status > 1 || record.genre > 3) {
+            return false;
+        }
+    }
+
+    items.reserve(items.size() + count);
+    for (std::uint32_t i = 0; i < count; i++) {
+        auto record = read_record<ItemRecord>(sections.records, i);
+        ItemId id(record.id);
+        std::string_view title = heap_string(record.title, sections.heap);
+        auto rental_type = (Item::RentalType) record.rental_type;
+        auto rental_status = (Item::RentalStatus) record.rental_status;
+        auto genre = (GenredItem::Genre) record.genre;
+        switch ((ItemType) record.type) {
+            case GAME:
+                items.push_back(arena.create<Game>(id, title, rental_type, record.stock, record.fee, rental_status));
+                break;
+            case VIDEO:
+                items.push_back(arena.create<VideoRecord>(id, title, rental_type, record.stock, record.fee,
+                                                          rental_status, genre));
+                break;
+            case DISC:
+                items.push_back(arena.create<DVD>(id, title, rental_type, record.stock, record.fee, rental_status,
+                                                  genre));
+                break;
+        }
+    }
+    return true;
+}
+
+//Rows are the positions of the items in the item snapshot
+static void add_customer_records(SnapshotWriter &writer, std::vector<Customer *> const &customers,
+                                 HashIndex<ItemId, std::uint32_t> const &rows) {
+    std::uint32_t reference_count = 0;
+    for (Customer const *customer : customers) {
+        CustomerRecord record{};
+        record.id = customer->get_key().value;
+        record.name = writer.add_string(customer->get_name());
+        record.address = writer.add_string(customer->get_address());
+        record.phone = writer.add_string(customer->get_phone());
+        record.number_of_rentals = customer->get_number_of_rentals();
+        record.state = (std::uint8_t) customer->get_state();
+        record.first_rental = reference_count;
+        for (Item const *item : customer->get_items()) {
+            std::uint32_t const *row = rows.find(item->get_key());
+            writer.add_reference({row != nullptr ? *row : no_row, item->get_key().value});
+            reference_count++;
+        }
+        record.rental_count = reference_count - record.first_rental;
+        writer.add_record(record);
+    }
+}
+
+bool write_customer_snapshot(std::string const &path, std::vector<Customer *> const &customers,
+                             std::string const &item_path) {
+    //Positions of the items in the item snapshot, to resolve the rentals now instead of on every load
+    HashIndex<ItemId, std::uint32_t> rows;
+    MappedFile item_file;
+    SnapshotSections item_sections{};
+    if (item_file.open(item_path) && open_snapshot(item_file, item_magic, sizeof(ItemRecord), item_sections)) {
+        rows.reserve(item_sections.header.record_count);
+        for (std::uint32_t i = 0; i < item_sections.header.record_count; i++) {
+            rows.insert(ItemId(read_record<ItemRecord>(item_sections.records, i).id), i);
+        }
+    }
+
+    SnapshotWriter writer;
+    add_customer_records(writer, customers, rows);
+    return writer.write(path, customer_magic, customers.size());
+}
+
+bool read_customer_snapshot(std::string const &path, std::vector<Item *> const &items, Arena &arena,
+                            std::vector<Customer *> &customers) {
+    MappedFile file;
+    SnapshotSections sections{};
+    if (!file.open(path) || !open_snapshot(file, customer_magic, sizeof(CustomerRecord), sections)) {
+        return false;
+    }
+
+    std::uint32_t count = sections.header.record_count;
+    for (std::uint32_t i = 0; i < count; i++) {
+        auto record = read_record<CustomerRecord>(sections.records, i);
+        if (!string_in_heap(record.name, sections.heap) || !string_in_heap(record.address, sections.heap)
+            || !string_in_heap(record.phone, sections.heap) || record.state > (std::uint8_t) Category::vip
+            || (std::uint64_t) record.first_rental + record.rental_count > sections.header.reference_count) {
+            return false;
+        }
+    }
+
+    //The rentals point at the position of their item, which is right when the items were loaded from
+    //the item snapshot; the index by id is only built if some rental does not match
+    ItemIndex item_index;
+    bool indexed = false;
+    customers.reserve(customers.size() + count);
+    for (std::uint32_t i = 0; i < count; i++) {
+        auto record = read_record<CustomerRecord>(sections.records, i);
+        std::vector<Item *> rentals;
+        rentals.reserve(record.rental_count);
+        for (std::uint32_t r = record.first_rental; r < record.first_rental + record.rental_count; r++) {
+            auto reference = read_record<RentalReference>(sections.references, r);
+            ItemId item_id(reference.item_id);
+            if (reference.row < items.size() && items[reference.row]->get_key() == item_id) {
+                rentals.push_back(items[reference.row]);
+                continue;
+            }
+            if (!indexed) {
+                item_index = build_item_index(items);
+                indexed = true;
+            }
+            if (Item *item = get_item_with_id(item_index, item_id)) {
+                rentals.push_back(item);
+            } else {
+                std::cout << "[ERROR] No item exists with ID: " << item_id << " ignoring rental of "
+                          << CustomerId(record.id) << std::endl;
+            }
+        }
+
+        CustomerState *state;
+        switch ((Category) record.state) {
+            case Category::guest:
+                state = arena.create<GuestState>();
+                break;
+            case Category::regular:
+                state = arena.create<RegularState>();
+                break;
+            default:
+                state = arena.create<VIPState>();
+                break;
+        }
+        customers.push_back(arena.create<Customer>(
+                CustomerId(record.id),
+                heap_string(record.name, sections.heap),
+                heap_string(record.address, sections.heap),
+                std::string(heap_string(record.phone, sections.heap)),
+                record.number_of_rentals,
+                std::move(rentals),
+                state,
+                false));
+    }
+    return true;
+}
+
+bool convert_text_to_snapshots() {
+    Arena arena;
+    std::vector<Item *> items = TextFileItemPersistence().load(arena);
+    std::vector<Customer *> customers = TextFileCustomerPersistence().load(items, arena);
+    if (!write_item_snapshot(SnapshotItemPersistence::path, items)
+        || !write_customer_snapshot(SnapshotCustomerPersistence::path, customers, SnapshotItemPersistence::path)) {
+        std::cerr << "[ERROR] Cannot write the snapshots items.bin and customers.bin" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool convert_snapshots_to_text() {
+    Arena arena;
+    std::vector<Item *> items;
+    std::vector<Customer *> customers;
+    if (!read_item_snapshot(SnapshotItemPersistence::path, arena, items)
+        || !read_customer_snapshot(SnapshotCustomerPersistence::path, items, arena, customers)) {
+        std::cerr << "[ERROR] Cannot read the snapshots items.bin and customers.bin" << std::endl;
+        return false;
+    }
+    TextFileItemPersistence().save(items);
+    TextFileCustomerPersistence().save(customers);
+    return true;
+}
+
+//Implementation of ItemPersistence
+//This is responsible for loading and saving
+//items from and to a binary snapshot
+std::vector<Item *> SnapshotItemPersistence::load(Arena &arena) {
+    std::vector<Item *> items;
+    if (read_item_snapshot(path, arena, items)) {
+        std::cout << "[INFO] Loaded " << items.size() << " items from items.bin" << std::endl;
+        return items;
+    }
+    std::cout << "[INFO] No valid items.bin, loading items.txt instead..." << std::endl;
+    items = TextFileItemPersistence().load(arena);
+    //Nothing changed since the load, so the snapshot is written now rather than on save
+    save(items);
+    return items;
+}
+
+PendingFile SnapshotItemPersistence::render(std::vector<Item *> const &items) {
+    SnapshotWriter writer;
+    add_item_records(writer, items);
+    return {path, writer.contents(item_magic, items.size())};
+}
+
+void SnapshotItemPersistence::save(std::vector<Item *> const &items) {
+    if (!write_item_snapshot(path, items)) {
+        std::cerr << "[ERROR] Cannot write to file items.bin" << std::endl;
+        return;
+    }
+    std::cout << "[SUCCESS] Successfully saved items.bin!" << std::endl;
+}
+
+//Implementation of CustomerPersistence
+//This is responsible for loading and saving
+//customers from and to a binary snapshot
+std::vector<Customer *> SnapshotCustomerPersistence::load(std::vector<Item *> const &items, Arena &arena) {
+    std::vector<Customer *> customers;
+    if (read_customer_snapshot(path, items, arena, customers)) {
+        std::cout << "[INFO] Loaded " << customers.size() << " customers from customers.bin" << std::endl;
+        return customers;
+    }
+    std::cout << "[INFO] No valid customers.bin, loading customers.txt instead..." << std::endl;
+    customers = TextFileCustomerPersistence().load(items, arena);
+    //Nothing changed since the load, so the snapshot is written now rather than on save
+    save(customers);
+    return customers;
+}
+
+PendingFile SnapshotCustomerPersistence::render(std::vector<Customer *> const &customers,
+                                                std::vector<Item *> const &items) {
+    //The item snapshot written with these customers has the items in this order
+    HashIndex<ItemId, std::uint32_t> rows;
+    rows.reserve(items.size());
+    for (std::uint32_t i = 0; i < items.size(); i++) {
+        rows.insert(items[i]->get_key(), i);
+    }
+
+    SnapshotWriter writer;
+    add_customer_records(writer, customers, rows);
+    return {path, writer.contents(customer_magic, customers.size())};
+}
+
+void SnapshotCustomerPersistence::save(std::vector<Customer *> const &customers) {
+    if (!write_customer_snapshot(path, customers, SnapshotItemPersistence::path)) {
+        std::cerr << "[ERROR] Cannot write to file customers.bin" << std::endl;
+        return;
+    }
+    std::cout << "[SUCCESS] Successfully saved customers.bin!" << std::endl;
+}
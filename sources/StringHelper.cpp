@@ -2,16 +2,119 @@
 // Created by ryanz on 5/20/2021.
 //
 #include "../headers/StringHelper.h"
+#include <cstddef>
+#include <cstdint>
 
-void to_lowercase(std::string string) {
-    for (char & pointer : string) {
-        pointer = tolower(pointer);
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+//Compare n characters ignoring the ASCII case
+static bool equal_folded(char const *a, char const *b, std::size_t n) {
+    for (std::size_t i = 0; i < n; i++) {
+        if (fold_ascii(a[i]) != fold_ascii(b[i])) {
+            return false;
+        }
     }
+    return true;
 }
 
-bool check_field_contains(std::string target, std::string query) {
-    to_lowercase(target);
-    to_lowercase(query);
+//Check the candidate positions of a block: bit k of mask set means that both the
+//first and the last character of the query match at position k of the block
+static bool check_candidates(std::uint32_t mask, char const *block, std::string_view query) {
+    while (mask != 0) {
+        unsigned offset = __builtin_ctz(mask);
+        if (equal_folded(block + offset + 1, query.data() + 1, query.size() - 2)) {
+            return true;
+        }
+        mask &= mask - 1;
+    }
+    return false;
+}
+
+#if defined(__AVX2__)
+//Fold the uppercase letters of a block of 32 characters
+static inline __m256i fold_block(__m256i block) {
+    __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(block, _mm256_set1_epi8('A' - 1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), block));
+    return _mm256_or_si256(block, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+}
+#endif
 
-    return target.find(query) != std::string::npos;
+#if defined(__SSE2__)
+//Fold the uppercase letters of a block of 16 characters
+static inline __m128i fold_block(__m128i block) {
+    __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('A' - 1)),
+                                  _mm_cmplt_epi8(block, _mm_set1_epi8('Z' + 1)));
+    return _mm_or_si128(block, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+#endif
+
+//Search for the query ignoring the ASCII case, without allocating.
+//The vector paths compare a block of positions at once against the first and the last
+//character of the query, and only the positions matching both are compared in full
+bool check_field_contains(std::string_view target, std::string_view query) {
+    std::size_t n = query.size();
+    if (n == 0) {
+        return true;
+    }
+    if (n > target.size()) {
+        return false;
+    }
+    if (n == 1) {
+        char c = fold_ascii(query[0]);
+        for (char t : target) {
+            if (fold_ascii(t) == c) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    char const *data = target.data();
+    //Number of positions where the query may start
+    std::size_t positions = target.size() - n + 1;
+    std::size_t i = 0;
+
+#if defined(__AVX2__)
+    __m256i first32 = _mm256_set1_epi8(fold_ascii(query[0]));
+    __m256i last32 = _mm256_set1_epi8(fold_ascii(query[n - 1]));
+    for (; i + 32 <= positions; i += 32) {
+        __m256i block_first = fold_block(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(data + i)));
+        __m256i block_last = fold_block(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(data + i + n - 1)));
+        __m256i matches = _mm256_and_si256(_mm256_cmpeq_epi8(block_first, first32),
+                                           _mm256_cmpeq_epi8(block_last, last32));
+        if (check_candidates((std::uint32_t) _mm256_movemask_epi8(matches), data + i, query)) {
+            return true;
+        }
+    }
+#endif
+
+#if defined(__SSE2__)
+    __m128i first16 = _mm_set1_epi8(fold_ascii(query[0]));
+    __m128i last16 = _mm_set1_epi8(fold_ascii(query[n - 1]));
+    for (; i + 16 <= positions; i += 16) {
+        __m128i block_first = fold_block(_mm_loadu_si128(reinterpret_cast<__m128i const *>(data + i)));
+        __m128i block_last = fold_block(_mm_loadu_si128(reinterpret_cast<__m128i const *>(data + i + n - 1)));
+        __m128i matches = _mm_and_si128(_mm_cmpeq_epi8(block_first, first16),
+                                        _mm_cmpeq_epi8(block_last, last16));
+        if (check_candidates((std::uint32_t) _mm_movemask_epi8(matches), data + i, query)) {
+            return true;
+        }
+    }
+#endif
+
+    //Scalar fallback for the remaining positions
+    char first = fold_ascii(query[0]);
+    char last = fold_ascii(query[n - 1]);
+    for (; i < positions; i++) {
+        if (fold_ascii(data[i]) == first && fold_ascii(data[i + n - 1]) == last &&
+            equal_folded(data + i + 1, query.data() + 1, n - 2)) {
+            return true;
+        }
+    }
+    return false;
 }
@@ -0,0 +1,47 @@
+#include "../headers/StringPool.h"
+#include <algorithm>
+#include <cstring>
+
+const std::size_t StringPool::default_chunk_size;
+
+StringPool::StringPool() {
+    //Handle 0 is the empty string
+    strings.emplace_back();
+    handles.insert(std::string_view(), 0);
+}
+
+std::string_view StringPool::store(std::string_view value) {
+    //Start a new chunk when the value does not fit in the current one
+    if (chunks.empty() || chunk_used + value.size() > chunk_size) {
+        chunk_size = std::max(default_chunk_size, value.size());
+        chunks.emplace_back(new char[chunk_size]);
+        chunk_used = 0;
+    }
+
+    char *destination = chunks.back().get() + chunk_used;
+    std::memcpy(destination, value.data(), value.size());
+    chunk_used += value.size();
+    return {destination, value.size()};
+}
+
+InternedString StringPool::intern(std::string_view value) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    //Already in the pool
+    std::uint32_t const *existing = handles.find(value);
+    if (existing != nullptr) {
+        return InternedString{*existing};
+    }
+
+    //Copy the characters into the pool, the index keys on the stored copy
+    std::string_view stored = store(value);
+    auto handle = (std::uint32_t) strings.size();
+    strings.push_back(stored);
+    handles.insert(stored, handle);
+    return InternedString{handle};
+}
+
+StringPool &string_pool() {
+    static StringPool pool;
+    return pool;
+}
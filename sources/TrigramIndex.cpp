@@ -0,0 +1,181 @@
+#include "../headers/TrigramIndex.h"
+#include "../headers/StringHelper.h"
+#include <algorithm>
+#include <iterator>
+
+//Get the distinct trigrams of a text, each packed into one integer
+//The letters are folded to lowercase since the search ignores the case
+static std::vector<std::uint32_t> trigrams_of(std::string_view text) {
+    std::vector<std::uint32_t> trigrams;
+    if (text.size() < 3) {
+        return trigrams;
+    }
+
+    trigrams.reserve(text.size() - 2);
+    for (std::size_t i = 0; i + 2 < text.size(); i++) {
+        trigrams.push_back(((std::uint32_t) (unsigned char) fold_ascii(text[i]) << 16) |
+                           ((std::uint32_t) (unsigned char) fold_ascii(text[i + 1]) << 8) |
+                           (std::uint32_t) (unsigned char) fold_ascii(text[i + 2]));
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
+
+void TrigramIndex::index_text(std::uint32_t number, std::string_view text) {
+    for (auto trigram : trigrams_of(text)) {
+        std::vector<std::uint32_t> *list = postings.find(trigram);
+        if (list == nullptr) {
+            postings.insert(trigram, {});
+            list = postings.find(trigram);
+        }
+
+        //Numbers are mostly added in increasing order, so this is usually an append
+        auto position = std::lower_bound(list->begin(), list->end(), number);
+        list->insert(position, number);
+    }
+}
+
+void TrigramIndex::unindex_text(std::uint32_t number, std::string_view text) {
+    for (auto trigram : trigrams_of(text)) {
+        std::vector<std::uint32_t> *list = postings.find(trigram);
+        if (list == nullptr) {
+            continue;
+        }
+
+        auto position = std::lower_bound(list->begin(), list->end(), number);
+        if (position != list->end() && *position == number) {
+            list->erase(position);
+        }
+        if (list->empty()) {
+            postings.erase(trigram);
+        }
+    }
+}
+
+void TrigramIndex::compact() {
+    //Renumber the remaining documents, keeping their order
+    std::vector<Document> remaining;
+    remaining.reserve(live_count);
+    for (auto &document : documents) {
+        if (document.live) {
+            remaining.push_back(std::move(document));
+        }
+    }
+
+    clear();
+    for (auto const &document : remaining) {
+        set(document.key, string_pool().view(document.text));
+    }
+}
+
+void TrigramIndex::clear() {
+    documents.clear();
+    live_count = 0;
+    numbers.clear();
+    postings.clear();
+}
+
+void TrigramIndex::set(std::uint32_t key, std::string_view text) {
+    InternedString interned = string_pool().intern(text);
+
+    //Replace the text of an indexed document, keeping its number (and so its order)
+    std::uint32_t const *existing = numbers.find(key);
+    if (existing != nullptr) {
+        Document &document = documents[*existing];
+        if (document.text == interned) {
+            return;
+        }
+        unindex_text(*existing, string_pool().view(document.text));
+        document.text = interned;
+        index_text(*existing, text);
+        return;
+    }
+
+    auto number = (std::uint32_t) documents.size();
+    documents.push_back(Document{key, interned, true});
+    numbers.insert(key, number);
+    live_count++;
+    index_text(number, text);
+}
+
+bool TrigramIndex::remove(std::uint32_t key) {
+    std::uint32_t const *existing = numbers.find(key);
+    if (existing == nullptr) {
+        return false;
+    }
+
+    std::uint32_t number = *existing;
+    Document &document = documents[number];
+    unindex_text(number, string_pool().view(document.text));
+    document.live = false;
+    document.text = InternedString();
+    numbers.erase(key);
+    live_count--;
+
+    //Renumber once most of the numbers belong to removed documents
+    if (documents.size() > 64 && live_count * 2 < documents.size()) {
+        compact();
+    }
+    return true;
+}
+
+void TrigramIndex::search(std::string_view query, std::vector<std::uint32_t> &keys) const {
+    //Too short to have a trigram: check every document
+    if (query.size() < 3) {
+        for (auto const &document : documents) {
+            if (document.live && check_field_contains(string_pool().view(document.text), query)) {
+                keys.push_back(document.key);
+            }
+        }
+        return;
+    }
+
+    //Get the list of every trigram of the query, a missing one means no match
+    std::vector<std::vector<std::uint32_t> const *> lists;
+    for (auto trigram : trigrams_of(query)) {
+        std::vector<std::uint32_t> const *list = postings.find(trigram);
+        if (list == nullptr) {
+            return;
+        }
+        lists.push_back(list);
+    }
+
+    //Intersect from the shortest list so the candidates only shrink
+    std::sort(lists.begin(), lists.end(), [](std::vector<std::uint32_t> const *a,
+                                             std::vector<std::uint32_t> const *b) {
+        return a->size() < b->size();
+    });
+    std::vector<std::uint32_t> candidates(*lists.front());
+    std::vector<std::uint32_t> intersection;
+    for (std::size_t i = 1; i < lists.size() && !candidates.empty(); i++) {
+        intersection.clear();
+        std::set_intersection(candidates.begin(), candidates.end(), lists[i]->begin(), lists[i]->end(),
+                              std::back_inserter(intersection));
+        candidates.swap(intersection);
+    }
+
+    //Having every trigram does not mean having them in sequence: check the text
+    for (auto number : candidates) {
+        Document const &document = documents[number];
+        if (check_field_contains(string_pool().view(document.text), query)) {
+            keys.push_back(document.key);
+        }
+    }
+}
+
+std::size_t TrigramIndex::estimate(std::string_view query) const {
+    if (query.size() < 3) {
+        return live_count;
+    }
+
+    std::size_t shortest = live_count;
+    for (auto trigram : trigrams_of(query)) {
+        std::vector<std::uint32_t> const *list = postings.find(trigram);
+        if (list == nullptr) {
+            return 0;
+        }
+        shortest = std::min(shortest, list->size());
+    }
+    return shortest;
+}
@@ -0,0 +1,134 @@
+#include "../headers/CustomerHelpers.h"
+#include "../headers/CustomerRepository.h"
+#include "../headers/ItemRepository.h"
+#include "../headers/StringHelper.h"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+/*
+	Checks that the read paths of items, customers and their repositories
+	allocate nothing: every global allocation is counted, and each read path
+	is run once the data is in place
+*/
+
+static std::size_t allocations = 0;
+
+void *operator new(std::size_t size) {
+    allocations++;
+    if (void *memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+static int failures = 0;
+
+//Run a read path and report it if it allocated
+template<typename Function>
+static void expect_no_allocation(char const *name, Function &&function) {
+    std::size_t before = allocations;
+    function();
+    std::size_t count = allocations - before;
+    if (count != 0) {
+        std::printf("FAIL %s: %zu allocation(s)\n", name, count);
+        failures++;
+    } else {
+        std::printf("ok   %s\n", name);
+    }
+}
+
+int main() {
+    InMemoryItemRepository items;
+    char id[10];
+    for (unsigned int n = 0; n < 300; n++) {
+        std::snprintf(id, sizeof(id), "I%03u-2001", n);
+        std::string title = "Title " + std::to_string(n % 50);
+        if (n % 2 == 0) {
+            items.add_item(new Game(id, title, Item::RentalType::TwoDay, n % 4, 1.5f, Item::RentalStatus::Available));
+        } else {
+            items.add_item(new DVD(id, title, Item::RentalType::OneWeek, n % 4, 2.5f, Item::RentalStatus::Available,
+                                   GenredItem::Genre::Horror));
+        }
+    }
+
+    InMemoryCustomerRepository customers;
+    for (unsigned int n = 0; n < 30; n++) {
+        std::snprintf(id, sizeof(id), "C%03u", n);
+        std::vector<Item *> rentals(items.get_items().begin() + n, items.get_items().begin() + n + 3);
+        customers.add_customer(new Customer(id, "Name " + std::to_string(n % 7), "1 Irwin Street", "0421473243", 3,
+                                            rentals, new VIPState));
+    }
+
+    //Setting the data up allocates, so the counting itself is checked
+    if (allocations == 0) {
+        std::printf("FAIL allocations are not counted\n");
+        return 1;
+    }
+
+    std::size_t sink = 0;
+    expect_no_allocation("ItemRepository::get_items", [&]() {
+        sink += items.get_items().size();
+    });
+    expect_no_allocation("CustomerRepository::get_customers", [&]() {
+        sink += customers.get_customers().size();
+    });
+    expect_no_allocation("Item getters", [&]() {
+        for (Item const *item : items.get_items()) {
+            sink += item->get_title().size() + item->get_number_in_stock() + (std::size_t) item->get_rental_fee();
+        }
+    });
+    expect_no_allocation("Customer getters", [&]() {
+        for (Customer const *customer : customers.get_customers()) {
+            sink += customer->get_name().size() + customer->get_address().size() + customer->get_phone().size()
+                    + customer->get_items().size();
+        }
+    });
+    expect_no_allocation("get_number_of_videos", [&]() {
+        for (Customer const *customer : customers.get_customers()) {
+            sink += (std::size_t) get_number_of_videos(customer);
+        }
+    });
+    expect_no_allocation("ItemTitleOrder::less", [&]() {
+        ItemTitleOrder order;
+        auto const &all = items.get_items();
+        for (std::size_t i = 1; i < all.size(); i++) {
+            sink += order.less(all[i - 1], all[i]);
+        }
+    });
+    expect_no_allocation("CustomerNameOrder::less", [&]() {
+        CustomerNameOrder order;
+        auto const &all = customers.get_customers();
+        for (std::size_t i = 1; i < all.size(); i++) {
+            sink += order.less(all[i - 1], all[i]);
+        }
+    });
+    ItemTitleFilterSpecification title_spec{"title 1"};
+    NameFilterSpecification name_spec{"NAME 3"};
+    expect_no_allocation("title and name specifications", [&]() {
+        for (Item const *item : items.get_items()) {
+            sink += title_spec.is_satisfied(item);
+        }
+        for (Customer const *customer : customers.get_customers()) {
+            sink += name_spec.is_satisfied(customer);
+        }
+    });
+    expect_no_allocation("check_field_contains", [&]() {
+        for (Item const *item : items.get_items()) {
+            sink += check_field_contains(item->get_title(), "LE 4");
+        }
+    });
+
+    std::printf("%zu\n", sink);
+    return failures == 0 ? 0 : 1;
+}
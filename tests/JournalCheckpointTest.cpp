@@ -0,0 +1,127 @@
+#include "../bench/Bench.h"
+#include "../headers/Journal.h"
+#include "../headers/ServiceBuilder.h"
+#include <csignal>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <sys/resource.h>
+
+/*
+	Checks that the journals of short sessions are folded into the data files
+	once they add up to the checkpoint size, instead of piling up, and that
+	replaying them in text mode leaves the rental status as items.txt gives it.
+	Also checks that a session whose journal write fails (the file size is
+	limited to cut a record in the middle) is saved in full at exit, with no
+	journal left to undo it
+*/
+
+static int failures = 0;
+
+static void expect(bool condition, char const *name) {
+    std::printf("%s %s\n", condition ? "ok  " : "FAIL", name);
+    failures += !condition;
+}
+
+//Journal files left in the data directory
+static std::size_t count_journals(BenchDirectory const &directory) {
+    std::size_t count = 0;
+    for (auto const &entry : std::filesystem::directory_iterator(directory.textfile(""))) {
+        count += entry.path().filename().string().compare(0, 8, "journal.") == 0;
+    }
+    return count;
+}
+
+//Load the data files, replay the journals, run a change and close, like a session of the menu
+template<typename Change>
+static void run_session(std::size_t checkpoint_size, Change &&change) {
+    QuietConsole quiet;
+    ItemService *items = StandardItemServiceBuilder().create();
+    CustomerService *customers = StandardCustomerServiceBuilder().create();
+    items->load();
+    customers->load(items->get_all());
+    {
+        Journal journal(*items, *customers, false, checkpoint_size);
+        journal.open();
+        items->set_journal(&journal);
+        customers->set_journal(&journal);
+        change(*items, *customers);
+        bool journaled = journal.is_open();
+        journal.close();
+        if (!journaled) {
+            journal.fold();
+        }
+    }
+    delete items;
+    delete customers;
+}
+
+int main() {
+    BenchDirectory directory("journal_checkpoint_test");
+    write_bench_items(directory.textfile("items.txt"), 20);
+    write_bench_customers(directory.textfile("customers.txt"), 5, 20, 1);
+
+    //Each session writes one small record, far below the checkpoint size on its own
+    //(the stocks are above the 3 of items.txt, so a folded one can be told apart)
+    const std::size_t checkpoint_size = 256;
+    const unsigned int sessions = 40;
+    for (unsigned int n = 1; n <= sessions; n++) {
+        run_session(checkpoint_size, [&](ItemService &items, CustomerService &) {
+            ItemNumStockModificationIntent intent{10 + n};
+            items.update(bench_item_id(0), intent);
+        });
+    }
+    expect(count_journals(directory) < 10, "short sessions are folded");
+
+    unsigned int stock = 0, file_stock = 0;
+    run_session(checkpoint_size, [&](ItemService &items, CustomerService &) {
+        stock = items.get(bench_item_id(0))->get_number_in_stock();
+    });
+    {
+        QuietConsole quiet;
+        Arena arena;
+        file_stock = TextFileItemPersistence().load(arena)[0]->get_number_in_stock();
+    }
+    expect(stock == 10 + sessions, "the last change is replayed");
+    expect(file_stock > 10 && file_stock <= 10 + sessions, "items.txt holds a folded change");
+
+    //items.txt does not store the rental status, so the replay does not restore it
+    run_session(checkpoint_size, [&](ItemService &items, CustomerService &customers) {
+        customers.borrow(customers.get(bench_customer_id(0)), items.get(bench_item_id(1)));
+    });
+    Item::RentalStatus status = Item::RentalStatus::Borrowed;
+    unsigned int borrowed_stock = 0;
+    run_session(checkpoint_size, [&](ItemService &items, CustomerService &) {
+        status = items.get(bench_item_id(1))->get_rental_status();
+        borrowed_stock = items.get(bench_item_id(1))->get_number_in_stock();
+    });
+    expect(borrowed_stock == 1, "the borrow is replayed");
+    expect(status == Item::RentalStatus::Available, "the text mode replay leaves the rental status");
+
+    //A journal write fails in the middle of the second record
+    BenchDirectory failing_directory("journal_failure_test");
+    write_bench_items(failing_directory.textfile("items.txt"), 20);
+    write_bench_customers(failing_directory.textfile("customers.txt"), 5, 20, 1);
+    std::signal(SIGXFSZ, SIG_IGN);
+    run_session(Journal::default_checkpoint_size, [&](ItemService &items, CustomerService &) {
+        rlimit limit{};
+        getrlimit(RLIMIT_FSIZE, &limit);
+        rlimit small = limit;
+        small.rlim_cur = 60;
+        setrlimit(RLIMIT_FSIZE, &small);
+        for (unsigned int n = 100; n <= 102; n++) {
+            ItemNumStockModificationIntent intent{n};
+            items.update(bench_item_id(0), intent);
+        }
+        setrlimit(RLIMIT_FSIZE, &limit);
+    });
+    unsigned int failed_stock = 0;
+    {
+        QuietConsole quiet;
+        Arena arena;
+        failed_stock = TextFileItemPersistence().load(arena)[0]->get_number_in_stock();
+    }
+    expect(failed_stock == 102, "a failed journal write saves the data files at exit");
+    expect(count_journals(failing_directory) == 0, "the journals are dropped with the full save");
+    return failures == 0 ? 0 : 1;
+}
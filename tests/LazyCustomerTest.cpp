@@ -0,0 +1,142 @@
+#include "../bench/Bench.h"
+#include "../headers/Journal.h"
+#include "../headers/ServiceBuilder.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+/*
+	Checks that the customers read on demand keep the borrows and returns
+	replayed from the journal when the cache is much smaller than the
+	customers changed: the repository must keep the changed customers
+	instead of dropping them and reading them again from customers.txt.
+	Also checks that reading a customer on demand prints nothing, even when
+	its lines have problems, and that a checkpoint writes customers.txt
+	without bringing every customer in memory
+*/
+
+static int failures = 0;
+
+static void expect(bool condition, char const *name) {
+    std::printf("%s %s\n", condition ? "ok  " : "FAIL", name);
+    failures += !condition;
+}
+
+//Services on the text files with the customers read on demand through a tiny cache
+struct Session {
+    LazyCustomerRepository *repository = new LazyCustomerRepository(2);
+    ItemService *items = StandardItemServiceBuilder().create();
+    CustomerService *customers = new CustomerService(repository, new ConsoleCustomerDisplayer(),
+                                                     new CustomerFilterer(), new TextFileCustomerPersistence());
+    Journal journal{*items, *customers};
+
+    Session() {
+        QuietConsole quiet;
+        items->load();
+        customers->load(items->get_all());
+    }
+
+    ~Session() {
+        QuietConsole quiet;
+        journal.close();
+        delete customers;
+        delete items;
+    }
+
+    void open_journal() {
+        QuietConsole quiet;
+        journal.open();
+        items->set_journal(&journal);
+        customers->set_journal(&journal);
+    }
+};
+
+static bool has_rental(Customer *customer, Item *item) {
+    std::vector<Item *> const &rentals = customer->get_items();
+    return std::find(rentals.begin(), rentals.end(), item) != rentals.end();
+}
+
+int main() {
+    BenchDirectory directory("lazy_customer_test");
+    write_bench_items(directory.textfile("items.txt"), 30);
+    write_bench_customers(directory.textfile("customers.txt"), 10, 30, 1);
+    {
+        //A customer renting an item which does not exist
+        std::ofstream file(directory.textfile("customers.txt"), std::ios::binary | std::ios::app);
+        file << "\nC010,Missing Item,1 Irwin Street,0421473243,1,VIP\nI999-2001";
+    }
+
+    //Borrow an item for six customers, and give one of them back
+    const std::size_t changed = 6;
+    {
+        Session session;
+        session.open_journal();
+        QuietConsole quiet;
+        for (std::size_t n = 0; n < changed; n++) {
+            session.customers->borrow(session.customers->get(bench_customer_id(n)),
+                                      session.items->get(bench_item_id(10 + n)));
+        }
+        session.customers->return_item(session.customers->get(bench_customer_id(0)),
+                                       session.items->get(bench_item_id(10)));
+    }
+
+    Session session;
+    std::uint64_t version = session.repository->get_version();
+    session.open_journal();
+    expect(session.repository->get_version() != version, "the replay changes the version");
+    expect(session.repository->get_cached_count() >= changed, "the replayed customers are kept");
+
+    //Read the other customers through the cache, then the changed ones again
+    bool borrowed = true, returned = false;
+    std::size_t cached = 0;
+    {
+        QuietConsole quiet;
+        for (std::size_t n = changed; n < 10; n++) {
+            session.customers->get(bench_customer_id(n));
+        }
+        for (std::size_t n = 1; n < changed; n++) {
+            borrowed &= has_rental(session.customers->get(bench_customer_id(n)),
+                                   session.items->get(bench_item_id(10 + n)));
+        }
+        returned = !has_rental(session.customers->get(bench_customer_id(0)), session.items->get(bench_item_id(10)));
+        cached = session.repository->get_cached_count();
+    }
+
+    expect(borrowed, "the replayed borrows survive the cache");
+    expect(returned, "the replayed return survives the cache");
+    expect(cached <= changed + 2, "the unchanged customers are dropped");
+
+    std::ostringstream output;
+    std::streambuf *console = std::cout.rdbuf(output.rdbuf());
+    Customer *customer = session.customers->get(bench_customer_id(10));
+    std::cout.rdbuf(console);
+    expect(customer != nullptr && customer->get_items().empty(), "the missing rental is ignored");
+    expect(output.str().empty(), "reading a customer prints nothing");
+
+    //A checkpoint streams customers.txt, the cache keeps its size
+    {
+        QuietConsole quiet;
+        session.journal.checkpoint();
+        session.journal.close();
+    }
+    expect(session.repository->get_cached_count() <= changed + 3, "a checkpoint does not read every customer");
+    std::vector<Customer *> saved;
+    Arena arena;
+    {
+        QuietConsole quiet;
+        saved = TextFileCustomerPersistence().load(session.items->get_all(), arena);
+    }
+    bool saved_rentals = saved.size() == 11;
+    for (Customer *customer : saved) {
+        std::size_t n = std::stoul(customer->get_id().substr(1));
+        if (n == 0) {
+            saved_rentals &= !has_rental(customer, session.items->get(bench_item_id(10)));
+        } else if (n < changed) {
+            saved_rentals &= has_rental(customer, session.items->get(bench_item_id(10 + n)));
+        }
+    }
+    expect(saved_rentals, "the checkpoint writes every customer with its rentals");
+    return failures == 0 ? 0 : 1;
+}
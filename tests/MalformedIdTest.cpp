@@ -0,0 +1,49 @@
+#include "../headers/Customer.h"
+#include "../headers/Item.h"
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+/*
+	Checks that items and customers created from a text id reject a malformed
+	one instead of silently packing it as id 0 (I000-0000 or C000)
+*/
+
+static int failures = 0;
+
+static void expect(bool condition, char const *name) {
+    std::printf("%s %s\n", condition ? "ok  " : "FAIL", name);
+    failures += !condition;
+}
+
+static bool item_rejected(std::string const &id) {
+    try {
+        Game game(id, "Medal of Honour", Item::RentalType::TwoDay, 3, 3.99f, Item::RentalStatus::Available);
+    } catch (std::invalid_argument &) {
+        return true;
+    }
+    return false;
+}
+
+static bool customer_rejected(std::string const &id) {
+    try {
+        Customer customer(id, "Brian Tran", "1 Irwin Street", "0421473243", 0, {}, new GuestState);
+    } catch (std::invalid_argument &) {
+        return true;
+    }
+    return false;
+}
+
+int main() {
+    expect(!item_rejected("I001-2001"), "a valid item id is accepted");
+    expect(item_rejected("I01-2001") && item_rejected("X001-2001") && item_rejected("I001_2001") &&
+           item_rejected("I0a1-2001") && item_rejected(""), "malformed item ids are rejected");
+
+    Game game("I123-1999", "Medal of Honour", Item::RentalType::TwoDay, 3, 3.99f, Item::RentalStatus::Available);
+    expect(game.get_id() == "I123-1999", "a valid item id is kept");
+
+    expect(!customer_rejected("C001"), "a valid customer id is accepted");
+    expect(customer_rejected("C01") && customer_rejected("D001") && customer_rejected("C0x1") &&
+           customer_rejected(""), "malformed customer ids are rejected");
+    return failures == 0 ? 0 : 1;
+}
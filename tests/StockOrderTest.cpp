@@ -0,0 +1,74 @@
+#include "../headers/ItemRepository.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+	Checks that the stock order of the item repositories stays sorted, with
+	every item exactly once, when the stock changes through update_item and
+	outside of it (borrowing and returning change it on the item itself)
+*/
+
+static int failures = 0;
+
+static void expect(bool condition, char const *repository, char const *what) {
+    if (!condition) {
+        std::printf("FAIL %s: %s\n", repository, what);
+        failures++;
+    }
+}
+
+//The items with a stock in [low, high] found by a scan, for comparison with the index
+static std::size_t count_stocks(std::vector<Item *> const &items, unsigned int low, unsigned int high) {
+    std::size_t count = 0;
+    for (Item const *item : items) {
+        count += item->get_number_in_stock() >= low && item->get_number_in_stock() <= high;
+    }
+    return count;
+}
+
+static void check_repository(ItemRepository &repository, char const *name) {
+    char id[10];
+    for (unsigned int n = 0; n < 200; n++) {
+        std::snprintf(id, sizeof(id), "I%03u-2001", n);
+        repository.add_item(new Game(id, "Title", Item::RentalType::TwoDay, n % 5, 1.5f,
+                                     Item::RentalStatus::Available));
+    }
+    std::vector<Item *> const &items = repository.get_items();
+
+    //Borrow and return: the stock changes on the item, the repository is only notified
+    for (std::size_t n = 0; n < items.size(); n += 3) {
+        items[n]->decrease_num_in_stock(1);
+    }
+    for (std::size_t n = 0; n < items.size(); n += 7) {
+        items[n]->increase_num_in_stock(4);
+    }
+    //And through the repository, which takes the item out of the order while it changes
+    for (unsigned int n = 0; n < 200; n += 11) {
+        std::snprintf(id, sizeof(id), "I%03u-2001", n);
+        ItemNumStockModificationIntent intent{n % 9};
+        repository.update_item(id, intent);
+    }
+
+    std::size_t total = 0;
+    for (unsigned int low = 0; low <= 9; low++) {
+        for (unsigned int high = low; high <= 9; high++) {
+            std::vector<Item *> found;
+            expect(repository.range_stocks(low, high, found), name, "no stock index");
+            expect(found.size() == count_stocks(items, low, high), name, "stock range differs from a scan");
+            if (low == high) {
+                total += found.size();
+            }
+        }
+    }
+    expect(total == items.size(), name, "an item is missing from or repeated in the stock order");
+    std::printf("%s %s\n", failures == 0 ? "ok  " : "FAIL", name);
+}
+
+int main() {
+    InMemoryItemRepository in_memory;
+    check_repository(in_memory, "InMemoryItemRepository");
+    ColumnarItemRepository columnar;
+    check_repository(columnar, "ColumnarItemRepository");
+    return failures == 0 ? 0 : 1;
+}